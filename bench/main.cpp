@@ -0,0 +1,332 @@
+/*!
+  @file   bench/main.cpp
+  @brief  Benchmarks for context, transfer and shader costs.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Run with JSON output for regression tracking:
+
+    aglet-bench --benchmark_out=aglet-bench.json --benchmark_out_format=json
+
+  On CPU only machines (Mesa llvmpipe) use the EGL backend (AGLET_USE_EGL=ON)
+  with a surfaceless platform:
+
+    EGL_PLATFORM=surfaceless aglet-bench
+
+*/
+
+#include <aglet/GLContext.h>
+#include <aglet/GLFrameBufferObject.h>
+#include <aglet/GLPBO.h>
+#include <aglet/GLQuad.h>
+#include <aglet/GLShader.h>
+#include <aglet/GLTexture.h>
+#include <aglet/gl_includes.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(AGLET_OPENGL_ES2)
+static const auto glKind = aglet::GLContext::kGLES20;
+#elif defined(AGLET_OPENGL_ES31)
+static const auto glKind = aglet::GLContext::kGLES31;
+#elif defined(AGLET_OPENGL_ES3)
+static const auto glKind = aglet::GLContext::kGLES30;
+#else
+static const auto glKind = aglet::GLContext::kGL;
+#endif
+
+// Each benchmark owns its context (an EGL context terminates the display when destroyed),
+// the benchmark is skipped if no context can be created (i.e., headless hosts without EGL):
+static aglet::GLContext::GLContextPtr createContext(benchmark::State& state, aglet::GLContext::ContextKind kind = aglet::GLContext::kAuto, int width = 64, int height = 64)
+{
+    aglet::GLContext::GLContextPtr gl;
+    try
+    {
+        gl = aglet::GLContext::create(kind, {}, width, height, glKind);
+    }
+    catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return nullptr;
+    }
+    if (!gl || !(*gl))
+    {
+        state.SkipWithError("aglet::GLContext::create()");
+        return nullptr;
+    }
+    (*gl)();
+    return gl;
+}
+
+static std::string getRenderer()
+{
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    return renderer ? reinterpret_cast<const char*>(renderer) : "unknown";
+}
+
+// Render target for the readback benchmarks:
+struct Target
+{
+    Target(int width, int height)
+        : texture(width, height)
+    {
+        fbo.bind();
+        fbo.attach(texture);
+        glClearColor(0.25f, 0.5f, 0.75f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    ~Target() { fbo.unbind(); }
+
+    aglet::GLTexture texture;
+    aglet::GLFrameBufferObject fbo;
+};
+
+// clang-format off
+#define AGLET_BENCH_SIZES \
+    Args({ 256, 256 })->Args({ 640, 480 })->Args({ 1280, 720 })->Args({ 1920, 1080 })
+// clang-format on
+
+// ::: context :::
+
+static void BM_ContextCreate(benchmark::State& state, aglet::GLContext::ContextKind kind)
+{
+    std::string renderer;
+    for (auto _ : state)
+    {
+        auto gl = createContext(state, kind, 640, 480);
+        if (!gl)
+        {
+            break;
+        }
+        renderer = getRenderer();
+    } // destroy
+    state.SetLabel(renderer);
+}
+#if defined(AGLET_EGL)
+BENCHMARK_CAPTURE(BM_ContextCreate, egl, aglet::GLContext::kEGL)->Unit(benchmark::kMillisecond);
+#endif
+#if defined(AGLET_HAS_GLFW)
+BENCHMARK_CAPTURE(BM_ContextCreate, glfw, aglet::GLContext::kGLFW)->Unit(benchmark::kMillisecond);
+#endif
+#if defined(AGLET_IOS)
+BENCHMARK_CAPTURE(BM_ContextCreate, ios, aglet::GLContext::kIOS)->Unit(benchmark::kMillisecond);
+#endif
+
+static void BM_MakeCurrent(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    for (auto _ : state)
+    {
+        (*gl)();
+    }
+}
+BENCHMARK(BM_MakeCurrent);
+
+// Alternate between two contexts, so each call is a real context switch:
+static void BM_MakeCurrentSwitch(benchmark::State& state)
+{
+    auto gl0 = createContext(state);
+    auto gl1 = gl0 ? createContext(state) : nullptr;
+    if (!gl1)
+    {
+        return;
+    }
+    for (auto _ : state)
+    {
+        (*gl0)();
+        (*gl1)();
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_MakeCurrentSwitch);
+
+// ::: readback :::
+
+static void BM_ReadPixels(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    const int width = int(state.range(0)), height = int(state.range(1));
+    Target target(width, height);
+    std::vector<GLubyte> pixels(width * height * 4);
+    for (auto _ : state)
+    {
+        aglet::readPixels(0, 0, width, height, pixels.data());
+        benchmark::DoNotOptimize(pixels.data());
+    }
+    state.SetBytesProcessed(state.iterations() * std::int64_t(pixels.size()));
+}
+BENCHMARK(BM_ReadPixels)->AGLET_BENCH_SIZES;
+
+#if defined(AGLET_HAS_PBO)
+// Synchronous PBO round trip (start + finish):
+static void BM_ReadPBO(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    const int width = int(state.range(0)), height = int(state.range(1));
+    Target target(width, height);
+    aglet::IPBO pbo(width, height);
+    std::vector<GLubyte> pixels(pbo.getSize());
+    pbo.bind();
+    for (auto _ : state)
+    {
+        pbo.read(pixels.data());
+        benchmark::DoNotOptimize(pixels.data());
+    }
+    pbo.unbind();
+    state.SetBytesProcessed(state.iterations() * std::int64_t(pixels.size()));
+}
+BENCHMARK(BM_ReadPBO)->AGLET_BENCH_SIZES;
+
+// Pipelined readback through two PBOs (one frame of latency):
+static void BM_ReadPBO2(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    const int width = int(state.range(0)), height = int(state.range(1));
+    Target target(width, height);
+    std::unique_ptr<aglet::IPBO> pbos[2] = {
+        std::unique_ptr<aglet::IPBO>(new aglet::IPBO(width, height)),
+        std::unique_ptr<aglet::IPBO>(new aglet::IPBO(width, height))
+    };
+    std::vector<GLubyte> pixels(pbos[0]->getSize());
+    std::size_t index = 0;
+    for (auto _ : state)
+    {
+        auto& pbo = *pbos[index++ % 2];
+        pbo.bind();
+        pbo.finish(pixels.data()); // no-op on the first iteration
+        pbo.start();
+        pbo.unbind();
+        benchmark::DoNotOptimize(pixels.data());
+    }
+    for (auto& pbo : pbos)
+    {
+        pbo->bind();
+        pbo->finish(pixels.data());
+        pbo->unbind();
+    }
+    state.SetBytesProcessed(state.iterations() * std::int64_t(pixels.size()));
+}
+BENCHMARK(BM_ReadPBO2)->AGLET_BENCH_SIZES;
+#endif
+
+// ::: upload :::
+
+static void BM_TexImage2D(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    const int width = int(state.range(0)), height = int(state.range(1));
+    aglet::GLTexture texture(width, height);
+    std::vector<GLubyte> pixels(width * height * 4, 128);
+    texture.bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto _ : state)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+    glFinish(); // include the last transfer
+    texture.unbind();
+    state.SetBytesProcessed(state.iterations() * std::int64_t(pixels.size()));
+}
+BENCHMARK(BM_TexImage2D)->AGLET_BENCH_SIZES;
+
+#if defined(AGLET_HAS_PBO)
+static void BM_UploadPBO(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    const int width = int(state.range(0)), height = int(state.range(1));
+    aglet::GLTexture texture(width, height);
+    aglet::OPBO pbo(width, height);
+    std::vector<GLubyte> pixels(pbo.getSize(), 128);
+    pbo.bind();
+    for (auto _ : state)
+    {
+        pbo.write(pixels.data(), texture);
+    }
+    glFinish();
+    pbo.unbind();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    state.SetBytesProcessed(state.iterations() * std::int64_t(pixels.size()));
+}
+BENCHMARK(BM_UploadPBO)->AGLET_BENCH_SIZES;
+#endif
+
+// ::: shaders :::
+
+// The salt makes each source unique, so driver shader caches don't hide the compile:
+static std::string getFragmentShader(std::int64_t salt, int taps)
+{
+    std::stringstream ss;
+    ss << "#ifdef GL_ES\n"
+       << "precision highp float;\n"
+       << "#endif\n"
+       << "varying vec2 vTexCoord;\n"
+       << "uniform sampler2D uInputTex;\n"
+       << "void main() {\n"
+       << "    vec4 sum = vec4(" << salt << ".0 * 1e-9);\n";
+    for (int i = 0; i < taps; i++)
+    {
+        ss << "    sum += texture2D(uInputTex, vTexCoord + vec2(" << (i % 7 - 3) << ".0, " << (i / 7 - 3) << ".0) * 0.001) / " << taps << ".0;\n";
+    }
+    ss << "    gl_FragColor = sum;\n"
+       << "}\n";
+    return ss.str();
+}
+
+static void BM_ShaderBuild(benchmark::State& state)
+{
+    auto gl = createContext(state);
+    if (!gl)
+    {
+        return;
+    }
+    std::int64_t salt = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const std::string fshSrc = getFragmentShader(salt++, int(state.range(0)));
+        state.ResumeTiming();
+
+        aglet::GLShader shader;
+        const bool status = shader.buildFromSrc(aglet::GLQuad::getVertexShader(), fshSrc.c_str(), aglet::GLQuad::getAttributes());
+        if (!status)
+        {
+            state.SkipWithError("GLShader::buildFromSrc()");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_ShaderBuild)->Arg(1)->Arg(49)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
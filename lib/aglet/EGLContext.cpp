@@ -8,16 +8,20 @@
 */
 
 #include "aglet/EGLContext.h"
+#include "aglet/GLTrace.h"
 #include "aglet/aglet_assert.h"
 #include "aglet/gl_includes.h"
 
 #include <EGL/eglext.h>
 
+#include <algorithm>
+#include <vector>
+
 AGLET_BEGIN
 
 EGLContextImpl::EGLContextImpl(int width, int height, GLVersion kVersion)
 {
-    EGLint eglOpenglBit = EGL_OPENGL_ES2_BIT, eglContextClientVersion = 2;
+    EGLint eglOpenglBit = EGL_OPENGL_ES2_BIT, eglContextClientVersion = 2, eglContextMinorVersion = 0;
     EGLenum eglApi = EGL_OPENGL_ES_API;
 
     switch(kVersion)
@@ -33,14 +37,22 @@ EGLContextImpl::EGLContextImpl(int width, int height, GLVersion kVersion)
 	  eglContextClientVersion = 2;
 	  break;
         case kGLES30:
+        case kGLES31:
 #if defined(EGL_OPENGL_ES3_BIT_KHR)
 	  eglApi = EGL_OPENGL_ES_API;
 	  eglOpenglBit = EGL_OPENGL_ES3_BIT_KHR;
 	  eglContextClientVersion = 3;
+	  eglContextMinorVersion = (kVersion == kGLES31) ? 1 : 0;
 #else
 	  throw_assert(false, "EGLContextImpl::EGLContextImpl() : EGL_OPENGL_ES3_BIT_KHR is unavailable");
 #endif
 	  break;
+        case kGL43:
+	  eglApi = EGL_OPENGL_API;
+	  eglOpenglBit = EGL_OPENGL_BIT;
+	  eglContextClientVersion = 4;
+	  eglContextMinorVersion = 3;
+	  break;
     }
 
     // EGL config attributes
@@ -56,18 +68,21 @@ EGLContextImpl::EGLContextImpl(int width, int height, GLVersion kVersion)
     };
 
     // EGL context attributes
-    const EGLint ctxAttr[] = {
+    std::vector<EGLint> ctxAttr = {
         EGL_CONTEXT_CLIENT_VERSION, eglContextClientVersion, // very important!
-        EGL_NONE
     };
 
-    // surface attributes
-    // the surface size is set to the input frame size
-    const EGLint surfaceAttr[] = {
-        EGL_WIDTH, width,
-        EGL_HEIGHT, height,
-        EGL_NONE
-    };
+    if (eglContextMinorVersion > 0)
+    {
+        // EGL_KHR_create_context: EGL_CONTEXT_CLIENT_VERSION == EGL_CONTEXT_MAJOR_VERSION_KHR
+        ctxAttr.insert(ctxAttr.end(), { EGL_CONTEXT_MINOR_VERSION_KHR, eglContextMinorVersion });
+        if (eglApi == EGL_OPENGL_API)
+        {
+            // GLFilterGraph and friends use legacy (GLSL 1.10 / GLSL ES 1.00) shaders
+            ctxAttr.insert(ctxAttr.end(), { EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR });
+        }
+    }
+    ctxAttr.push_back(EGL_NONE);
 
     EGLint eglMajVers, eglMinVers;
     EGLint numConfigs;
@@ -82,14 +97,37 @@ EGLContextImpl::EGLContextImpl(int width, int height, GLVersion kVersion)
     eglChooseConfig(eglDisp, confAttr, &eglConf, 1, &numConfigs);
     throw_assert((eglGetError() == EGL_SUCCESS), "EGLContextImpl::EGLContextImpl() : eglChooseConfig()");
 
+    // surface attributes
+    // the surface size is set to the input frame size, within the limits of
+    // the config (large images are processed offscreen, i.e., GLTiler)
+    EGLint maxWidth = 0, maxHeight = 0;
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_MAX_PBUFFER_WIDTH, &maxWidth);
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_MAX_PBUFFER_HEIGHT, &maxHeight);
+    const EGLint surfaceAttr[] = {
+        EGL_WIDTH, (maxWidth > 0) ? std::min(width, int(maxWidth)) : width,
+        EGL_HEIGHT, (maxHeight > 0) ? std::min(height, int(maxHeight)) : height,
+        EGL_NONE
+    };
+
     eglSurface = eglCreatePbufferSurface(eglDisp, eglConf, surfaceAttr);
     throw_assert((eglGetError() == EGL_SUCCESS), "EGLContextImpl::EGLContextImpl() : eglCreatePbufferSurface()");
     throw_assert((eglSurface != EGL_NO_SURFACE), "EGLContextImpl::EGLContextImpl() : eglCreatePbufferSurface()");
 
+    // Color and depth buffers of the (possibly clamped) surface:
+    EGLint surfaceWidth = 0, surfaceHeight = 0, bufferSize = 32, depthSize = 16;
+    eglQuerySurface(eglDisp, eglSurface, EGL_WIDTH, &surfaceWidth);
+    eglQuerySurface(eglDisp, eglSurface, EGL_HEIGHT, &surfaceHeight);
+    m_geometry.width = int(surfaceWidth);
+    m_geometry.height = int(surfaceHeight);
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_BUFFER_SIZE, &bufferSize);
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_DEPTH_SIZE, &depthSize);
+    const std::size_t pixelSize = std::size_t(bufferSize + depthSize + 7) / 8;
+    surfaceAllocation = GLAllocation(this, GLMemory::kSurface, std::size_t(surfaceWidth) * std::size_t(surfaceHeight) * pixelSize);
+
     eglBindAPI(eglApi);
     throw_assert((EGL_SUCCESS == eglGetError()), "EGLContextImpl::EGLContextImpl() : eglCreateContext()");
 
-    eglCtx = eglCreateContext(eglDisp, eglConf, EGL_NO_CONTEXT, ctxAttr);
+    eglCtx = eglCreateContext(eglDisp, eglConf, EGL_NO_CONTEXT, ctxAttr.data());
     throw_assert((EGL_SUCCESS == eglGetError()), "EGLContextImpl::EGLContextImpl() : eglCreateContext()");
     throw_assert((eglCtx != EGL_NO_CONTEXT), "EGLContextImpl::EGLContextImpl() : eglCreateContext()");
 
@@ -99,6 +137,8 @@ EGLContextImpl::EGLContextImpl(int width, int height, GLVersion kVersion)
 
 EGLContextImpl::~EGLContextImpl()
 {
+    releaseObjects();
+
     if (eglCtx != EGL_NO_CONTEXT)
     {
         eglDestroyContext(eglDisp, eglCtx);
@@ -126,9 +166,11 @@ EGLContextImpl::operator bool() const
 
 void EGLContextImpl::operator()()
 {
+    AGLET_TRACE_SCOPE("makeCurrent", "context");
     auto status = eglMakeCurrent(eglDisp, eglSurface, eglSurface, eglCtx);
     throw_assert(status, "EGLContextImpl::operator()() : eglMakeCurrent()");
     throw_assert(eglGetError() == EGL_SUCCESS, "EGLContextImpl::operator()() : eglMakeCurrent()");
+    setCurrent(this);
 }
 
 // Display:
@@ -142,11 +184,43 @@ void EGLContextImpl::resize(int width, int height)
     // noop
 }
 
+bool EGLContextImpl::setSwapInterval(int interval)
+{
+    m_swapIntervalRequested = interval;
+
+    // EGL has no late swap tear extension: use the equivalent fixed interval
+    EGLint minInterval = 0, maxInterval = 1;
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_MIN_SWAP_INTERVAL, &minInterval);
+    eglGetConfigAttrib(eglDisp, eglConf, EGL_MAX_SWAP_INTERVAL, &maxInterval);
+
+    EGLint value = (interval < 0) ? -interval : interval;
+    value = std::max(minInterval, std::min(value, maxInterval));
+
+    // Note: eglSwapInterval() applies to the surface bound to the current context
+    (*this)();
+    auto status = eglSwapInterval(eglDisp, value);
+    throw_assert(status, "EGLContextImpl::setSwapInterval() : eglSwapInterval()");
+
+    m_swapInterval = value;
+    m_swapIntervalHonoured = (value == interval);
+    return m_swapIntervalHonoured;
+}
+
+auto EGLContextImpl::getProcAddress(const char* name) const -> ProcAddress
+{
+    // EGL 1.5 (and Mesa, for all versions) also returns core entry points:
+    return reinterpret_cast<ProcAddress>(eglGetProcAddress(name));
+}
+
+std::string EGLContextImpl::getPlatformExtensions() const
+{
+    const char* extensions = eglQueryString(eglDisp, EGL_EXTENSIONS);
+    return extensions ? extensions : "";
+}
+
 void EGLContextImpl::operator()(std::function<bool(void)>& f)
 {
-    while (f())
-    {
-    }
+    run(f);
 }
 
 AGLET_END
@@ -11,14 +11,17 @@
 #define __aglet_EGLContext_h__
 
 #include "aglet/GLContext.h"
+#include "aglet/GLContextLoop.h"
+#include "aglet/GLMemory.h"
 
 #include <EGL/egl.h>
 
 AGLET_BEGIN
 
 // NOTE: EGLContext is already a type!
-struct EGLContextImpl : public GLContext
+struct EGLContextImpl : public GLContext, public GLContextLoop<EGLContextImpl>
 {
+    // The pbuffer surface is clamped to EGL_MAX_PBUFFER_WIDTH/HEIGHT, getGeometry() has its actual size:
     EGLContextImpl(int width = 640, int height = 480, GLVersion kVersion = kGLES20);
     ~EGLContextImpl();
 
@@ -28,11 +31,22 @@ struct EGLContextImpl : public GLContext
     virtual bool hasDisplay() const;
     virtual void resize(int width, int height);
     virtual void operator()(std::function<bool(void)>& f);
+    virtual bool setSwapInterval(int interval);
+    virtual ProcAddress getProcAddress(const char* name) const;
+    virtual std::string getPlatformExtensions() const;
+
+    // GLContextLoop<> hooks: frames are never presented from the pbuffer
+    // surface, so the loop is not throttled and these are noops.
+    void beginLoop() {}
+    bool beginFrame() { return true; }
+    void endFrame() {}
 
     EGLConfig eglConf;
     EGLSurface eglSurface = EGL_NO_SURFACE;
     EGLContext eglCtx = EGL_NO_CONTEXT;
     EGLDisplay eglDisp = EGL_NO_DISPLAY;
+
+    GLAllocation surfaceAllocation; // GLMemory::kSurface
 };
 
 AGLET_END
@@ -0,0 +1,232 @@
+/*!
+  @file   FrameRing.cpp
+  @brief  Implementation of a shared memory frame ring and its (OpenGL free) consumer.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/FrameRing.h"
+
+#if defined(AGLET_HAS_POSIX)
+
+#include "aglet/aglet_assert.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+AGLET_BEGIN
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "FrameRing requires address free 64 bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "FrameRing requires address free 32 bit atomics");
+
+static const char kMagic[8] = { 'A', 'G', 'L', 'E', 'T', 'R', 'N', 'G' };
+
+static std::size_t alignToPage(std::size_t size)
+{
+    const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    return ((size + page - 1) / page) * page;
+}
+
+static std::size_t getDataOffset(std::size_t slotCount)
+{
+    return alignToPage(sizeof(FrameRingHeader) + slotCount * sizeof(FrameRingSlot));
+}
+
+FrameRing::FrameRing(const std::string& name, std::uint32_t width, std::uint32_t height, std::uint32_t format, std::uint32_t type, std::uint32_t pixelSize, std::size_t slotCount)
+    : m_name(name)
+    , m_owner(true)
+{
+    throw_assert((width > 0) && (height > 0) && (pixelSize > 0) && (slotCount > 0), "FrameRing::FrameRing() : invalid size");
+
+    const std::size_t frameSize = std::size_t(width) * std::size_t(height) * pixelSize;
+    const std::size_t slotSize = alignToPage(frameSize);
+    const std::size_t dataOffset = getDataOffset(slotCount);
+    m_size = dataOffset + slotCount * slotSize;
+
+    // A stale ring of the same name is replaced, its consumers keep their mapping:
+    shm_unlink(name.c_str());
+    m_fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    throw_assert(m_fd >= 0, "FrameRing::FrameRing() : shm_open() " << name << " : " << std::strerror(errno));
+    if (ftruncate(m_fd, off_t(m_size)) != 0)
+    {
+        const int error = errno;
+        close(m_fd);
+        shm_unlink(name.c_str());
+        throw_assert(false, "FrameRing::FrameRing() : ftruncate() " << m_size << " bytes : " << std::strerror(error));
+    }
+    map(true);
+
+    // The mapping is zero filled (sequences, count), publish the layout before the magic:
+    m_header->version = 1;
+    m_header->width = width;
+    m_header->height = height;
+    m_header->format = format;
+    m_header->type = type;
+    m_header->pixelSize = pixelSize;
+    m_header->frameSize = frameSize;
+    m_header->slotSize = slotSize;
+    m_header->slotCount = slotCount;
+    m_header->dataOffset = dataOffset;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, kMagic, sizeof(kMagic));
+}
+
+FrameRing::FrameRing(const std::string& name)
+    : m_name(name)
+{
+    m_fd = shm_open(name.c_str(), O_RDONLY, 0);
+    throw_assert(m_fd >= 0, "FrameRing::FrameRing() : shm_open() " << name << " : " << std::strerror(errno));
+
+    struct stat info;
+    if ((fstat(m_fd, &info) != 0) || (std::size_t(info.st_size) < sizeof(FrameRingHeader)))
+    {
+        close(m_fd);
+        throw_assert(false, "FrameRing::FrameRing() : not a frame ring " << name);
+    }
+    m_size = std::size_t(info.st_size);
+    map(false);
+
+    const bool ready = (std::memcmp(m_header->magic, kMagic, sizeof(kMagic)) == 0);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const bool valid = ready && (m_header->version == 1) && (m_header->slotCount > 0)
+        && ((m_header->dataOffset + m_header->slotCount * m_header->slotSize) <= m_size);
+    if (!valid)
+    {
+        munmap(m_data, m_size);
+        close(m_fd);
+        throw_assert(false, "FrameRing::FrameRing() : not a frame ring " << name);
+    }
+}
+
+void FrameRing::map(bool writable)
+{
+    void* data = mmap(nullptr, m_size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        const int error = errno;
+        close(m_fd);
+        if (m_owner)
+        {
+            shm_unlink(m_name.c_str());
+        }
+        throw_assert(false, "FrameRing::FrameRing() : mmap() " << m_name << " : " << std::strerror(error));
+    }
+
+    m_data = static_cast<std::uint8_t*>(data);
+    m_header = reinterpret_cast<FrameRingHeader*>(m_data);
+}
+
+FrameRing::~FrameRing()
+{
+    munmap(m_data, m_size);
+    close(m_fd);
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str()); // consumers keep their mapping
+    }
+}
+
+FrameRingSlot& FrameRing::getSlot(std::size_t index) const
+{
+    return reinterpret_cast<FrameRingSlot*>(m_data + sizeof(FrameRingHeader))[index];
+}
+
+std::uint8_t* FrameRing::getData(std::size_t index) const
+{
+    return m_data + m_header->dataOffset + index * m_header->slotSize;
+}
+
+// ::: consumer :::
+
+FrameRingConsumer::FrameRingConsumer(const std::string& name)
+    : m_ring(name)
+{
+}
+
+std::uint64_t FrameRingConsumer::getCount() const
+{
+    return m_ring.getHeader().count.load(std::memory_order_acquire);
+}
+
+std::uint64_t FrameRingConsumer::wait(std::uint64_t count, int timeoutMs)
+{
+    auto& header = m_ring.getHeader();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true)
+    {
+        // Read the futex word before the count, so a publish in between wakes us:
+        const std::uint32_t word = header.futex.load(std::memory_order_acquire);
+        const std::uint64_t current = getCount();
+        if (current > count)
+        {
+            return current;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return 0;
+        }
+
+#if defined(__linux__)
+        const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        struct timespec timeout;
+        timeout.tv_sec = time_t(remaining / 1000000000);
+        timeout.tv_nsec = long(remaining % 1000000000);
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header.futex), FUTEX_WAIT, word, &timeout, nullptr, 0);
+#else
+        static_cast<void>(word);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+bool FrameRingConsumer::acquire(Frame& frame) const
+{
+    const std::uint64_t count = getCount();
+    return (count > 0) && acquire(count - 1, frame);
+}
+
+bool FrameRingConsumer::acquire(std::uint64_t number, Frame& frame) const
+{
+    const auto& header = m_ring.getHeader();
+    const std::size_t slot = std::size_t(number % header.slotCount);
+    const std::uint64_t sequence = m_ring.getSlot(slot).sequence.load(std::memory_order_acquire);
+    if (sequence != (number * 2 + 2))
+    {
+        return false; // being written, or a newer frame
+    }
+
+    frame.data = m_ring.getData(slot);
+    frame.number = number;
+    frame.timestamp = m_ring.getSlot(slot).timestamp;
+    frame.sequence = sequence;
+    frame.slot = slot;
+    return isValid(frame);
+}
+
+bool FrameRingConsumer::isValid(const Frame& frame) const
+{
+    // Order the (plain) reads of the frame before the sequence check:
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (m_ring.getSlot(frame.slot).sequence.load(std::memory_order_relaxed) == frame.sequence);
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
@@ -0,0 +1,151 @@
+/*!
+  @file   FrameRing.h
+  @brief  Declaration of a shared memory frame ring and its (OpenGL free) consumer.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_FrameRing_h__
+#define __aglet_FrameRing_h__
+
+#include "aglet/aglet.h"
+
+#if defined(AGLET_HAS_POSIX) // shared memory
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+AGLET_BEGIN
+
+/*
+ * POSIX shared memory (shm_open) ring of fixed size frame slots written by
+ * a producer process (GLFrameRing) and mapped read only by any number of
+ * consumer processes.  This header has no OpenGL dependency, consumers
+ * only link the aglet_ring library.
+ *
+ * Frame n (counting from 0) is written to slot n % slotCount under a
+ * per-slot sequence lock: the slot sequence is 2n + 1 while the frame is
+ * written and 2n + 2 once it is complete.  Consumers use frames in place
+ * and check afterwards that the sequence did not change, i.e., that the
+ * producer did not lap them.  New frames are signalled through a futex
+ * word on Linux (polling elsewhere).
+ */
+
+struct FrameRingHeader
+{
+    char magic[8];         // "AGLETRNG", written last by the producer
+    std::uint32_t version; // 1
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t format; // GL_RGBA, ... (as read by glReadPixels)
+    std::uint32_t type;   // GL_UNSIGNED_BYTE, ...
+    std::uint32_t pixelSize;
+    std::uint64_t frameSize;
+    std::uint64_t slotSize;
+    std::uint64_t slotCount;
+    std::uint64_t dataOffset;
+    std::atomic<std::uint64_t> count; // number of published frames
+    std::atomic<std::uint32_t> futex; // incremented per published frame
+};
+
+struct FrameRingSlot
+{
+    std::atomic<std::uint64_t> sequence; // odd: being written
+    std::uint64_t frame;
+    std::uint64_t timestamp;
+};
+
+// Shared memory mapping of a frame ring (creator or reader):
+class FrameRing
+{
+public:
+    // Create (replace) ring name ("/name") for slotCount frames, read/write:
+    FrameRing(const std::string& name, std::uint32_t width, std::uint32_t height, std::uint32_t format, std::uint32_t type, std::uint32_t pixelSize, std::size_t slotCount);
+
+    // Open an existing ring read only, throws if it doesn't exist or isn't complete:
+    explicit FrameRing(const std::string& name);
+
+    ~FrameRing();
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    FrameRingHeader& getHeader() const { return *m_header; }
+    FrameRingSlot& getSlot(std::size_t index) const;
+    std::uint8_t* getData(std::size_t index) const;
+
+    const std::string& getName() const { return m_name; }
+
+protected:
+    void map(bool writable); // throws
+
+    std::string m_name;
+    bool m_owner = false;
+    int m_fd = -1;
+    std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    FrameRingHeader* m_header = nullptr;
+};
+
+/*
+ * Consumer side, zero copy:
+ *
+ *   aglet::FrameRingConsumer consumer("/camera");
+ *   std::uint64_t seen = 0;
+ *   while ((seen = consumer.wait(seen, 1000)))
+ *   {
+ *       aglet::FrameRingConsumer::Frame frame;
+ *       if (consumer.acquire(frame))
+ *       {
+ *           auto result = analyze(frame.data); // in place
+ *           if (consumer.isValid(frame)) publish(result); // not overwritten meanwhile
+ *       }
+ *   }
+ */
+
+class FrameRingConsumer
+{
+public:
+    struct Frame
+    {
+        const std::uint8_t* data = nullptr;
+        std::uint64_t number = 0; // frame number (from 0)
+        std::uint64_t timestamp = 0;
+        std::uint64_t sequence = 0;
+        std::size_t slot = 0;
+    };
+
+    // Open an existing ring, throws if it doesn't exist or is invalid:
+    explicit FrameRingConsumer(const std::string& name);
+
+    const FrameRingHeader& getHeader() const { return m_ring.getHeader(); }
+
+    // Number of published frames:
+    std::uint64_t getCount() const;
+
+    // Wait until more than count frames are published, return the new count
+    // or 0 on timeout:
+    std::uint64_t wait(std::uint64_t count, int timeoutMs);
+
+    // Latest complete frame, false if none or it is being overwritten:
+    bool acquire(Frame& frame) const;
+
+    // Frame number (getCount() - getHeader().slotCount <= number < getCount()):
+    bool acquire(std::uint64_t number, Frame& frame) const;
+
+    // True if the frame has not been overwritten since acquire():
+    bool isValid(const Frame& frame) const;
+
+protected:
+    FrameRing m_ring;
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
+
+#endif // __aglet_FrameRing_h__
@@ -0,0 +1,200 @@
+/*!
+  @file   GLBatch.cpp
+  @brief  Implementation of batched processing of small images in a texture array.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLBatch.h"
+#include "aglet/GLCapabilities.h"
+
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+#include "aglet/GLPBO.h"
+
+#include <algorithm>
+
+AGLET_BEGIN
+
+// clang-format off
+#if defined(AGLET_OPENGL_ES3)
+static const char* kVersion = "#version 300 es\n";
+#else
+static const char* kVersion = "#version 330\n";
+#endif
+
+// Instance i covers cell (i % cols, i / cols) of the atlas:
+static const char* kVertexShaderSrc =
+    "in vec4 aPos;\n"
+    "in vec2 aTexCoord;\n"
+    "uniform vec2 uCells;\n"
+    "out vec2 vTexCoord;\n"
+    "flat out float vLayer;\n"
+    "void main() {\n"
+    "    float i = float(gl_InstanceID);\n"
+    "    vec2 cell = vec2(mod(i, uCells.x), floor(i / uCells.x));\n"
+    "    vec2 p = ((aPos.xy * 0.5 + 0.5) + cell) / uCells;\n"
+    "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "    vTexCoord = aTexCoord;\n"
+    "    vLayer = i;\n"
+    "}\n";
+
+static const char* kFragmentShaderSrc =
+    "in vec2 vTexCoord;\n"
+    "flat in float vLayer;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = process(vTexCoord, vLayer);\n"
+    "}\n";
+
+static const char* kDefaultStageSrc =
+    "vec4 process(vec2 texCoord, float layer) {\n"
+    "    return texture(uInputTex, vec3(texCoord, layer));\n"
+    "}\n";
+// clang-format on
+
+const char* GLBatch::getDefaultStage()
+{
+    return kDefaultStageSrc;
+}
+
+GLBatch::GLBatch(int width, int height, int capacity, const std::string& stageSrc)
+    : m_width(width)
+    , m_height(height)
+    , m_capacity(capacity)
+{
+    throw_assert((width > 0) && (height > 0) && (capacity > 0), "GLBatch::GLBatch() : invalid size");
+
+    const auto& limits = GLCapabilities::current().getLimits();
+    const int maxSize = limits.maxTextureSize, maxLayers = limits.maxArrayTextureLayers;
+    throw_assert((width <= maxSize) && (height <= maxSize), "GLBatch::GLBatch() : size exceeds GL_MAX_TEXTURE_SIZE");
+    throw_assert(capacity <= maxLayers, "GLBatch::GLBatch() : capacity exceeds GL_MAX_ARRAY_TEXTURE_LAYERS " << maxLayers);
+
+    // Wide atlas: fill rows up to the texture size limit
+    m_columns = std::min(capacity, maxSize / width);
+    const int rows = (capacity + m_columns - 1) / m_columns;
+    throw_assert((rows * height) <= maxSize, "GLBatch::GLBatch() : atlas exceeds GL_MAX_TEXTURE_SIZE");
+
+    m_input = GLNamePool::generate(GLNamePool::kTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_input);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    checkGLError("GLBatch::GLBatch() : glTexImage3D()");
+    m_inputAllocation = GLAllocation(GLMemory::kTexture, std::size_t(width) * std::size_t(height) * std::size_t(capacity) * 4);
+
+    m_atlas.reset(new GLTexture(m_columns * width, rows * height));
+    m_atlasFbo.bind();
+    m_atlasFbo.attach(*m_atlas);
+    m_atlasFbo.unbind();
+
+    const std::string vshSrc = std::string(kVersion) + kVertexShaderSrc;
+    const std::string fshSrc = std::string(kVersion)
+        + "precision highp float;\n"
+          "uniform highp sampler2DArray uInputTex;\n"
+          "uniform vec2 uTexelSize;\n"
+        + (stageSrc.empty() ? std::string(kDefaultStageSrc) : stageSrc)
+        + kFragmentShaderSrc;
+    auto status = m_shader.buildFromSrc(vshSrc.c_str(), fshSrc.c_str(), GLQuad::getAttributes());
+    throw_assert(status, "GLBatch::GLBatch() : GLShader::buildFromSrc()");
+
+    const GLuint program = m_shader.getProgramId();
+    m_shader.use();
+    glUniform1i(glGetUniformLocation(program, "uInputTex"), 0);
+    glUniform2f(glGetUniformLocation(program, "uTexelSize"), 1.f / GLfloat(width), 1.f / GLfloat(height));
+    glUniform2f(glGetUniformLocation(program, "uCells"), GLfloat(m_columns), GLfloat(rows));
+    glUseProgram(0);
+
+    m_pbo.reset(new IPBO(m_atlas->getWidth(), m_atlas->getHeight()));
+
+    checkGLError("GLBatch::GLBatch() : glUniform2f()");
+}
+
+GLBatch::~GLBatch()
+{
+    if (m_input > 0)
+    {
+        m_owner.release(GLDeletionQueue::kTexture, m_input, std::move(m_inputAllocation));
+        m_input = 0;
+    }
+}
+
+void GLBatch::upload(const GLubyte* pixels, int first, int count)
+{
+    throw_assert((first >= 0) && (count >= 0) && ((first + count) <= m_capacity), "GLBatch::upload() : invalid layers");
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_input);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, first, m_width, m_height, count, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    checkGLError("GLBatch::upload() : glTexSubImage3D()");
+}
+
+void GLBatch::copy(int layer, GLuint texture, int x, int y)
+{
+    throw_assert((layer >= 0) && (layer < m_capacity), "GLBatch::copy() : invalid layer " << layer);
+
+    m_readFbo.bind();
+    m_readFbo.attach(texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_input);
+    glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, x, y, m_width, m_height);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    m_readFbo.unbind();
+    checkGLError("GLBatch::copy() : glCopyTexSubImage3D()");
+}
+
+GLuint GLBatch::operator()(int count)
+{
+    throw_assert((count >= 0) && (count <= m_capacity), "GLBatch::operator()() : invalid count " << count);
+
+    m_atlasFbo.bind();
+    glViewport(0, 0, getAtlasWidth(), getAtlasHeight());
+
+    m_shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_input);
+
+    m_quad.bind();
+    m_quad.draw(count);
+    m_quad.unbind();
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+    m_atlasFbo.unbind();
+
+    checkGLError("GLBatch::operator()() : glDrawArraysInstanced()");
+    return *m_atlas;
+}
+
+void GLBatch::start()
+{
+    m_atlasFbo.bind();
+    m_pbo->bind();
+    m_pbo->start();
+    m_pbo->unbind();
+    m_atlasFbo.unbind();
+}
+
+void GLBatch::finish(GLubyte* pixels)
+{
+    m_pbo->bind();
+    m_pbo->finish(pixels);
+    m_pbo->unbind();
+}
+
+void GLBatch::read(GLubyte* pixels)
+{
+    start();
+    finish(pixels);
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_TEXTURE_ARRAY)
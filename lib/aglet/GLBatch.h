@@ -0,0 +1,110 @@
+/*!
+  @file   GLBatch.h
+  @brief  Declaration of batched processing of small images in a texture array.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLBatch_h__
+#define __aglet_GLBatch_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTexture.h"
+
+#include <memory>
+#include <string>
+
+AGLET_BEGIN
+
+class IPBO;
+
+/*
+ * Process many small RGBA images (i.e., face or object chips) of the same
+ * size with one upload, one draw and one readback per batch:
+ *
+ *   aglet::GLBatch batch(64, 64, 256);    // chip size, capacity
+ *   batch.upload(chips, 0, count);        // one glTexSubImage3D, or
+ *   batch.copy(i, frame, x, y);           // crop on the GPU
+ *   batch(count);                         // one instanced draw
+ *   batch.read(pixels);                   // one readback (atlas)
+ *
+ * Inputs are layers of a GL_TEXTURE_2D_ARRAY, instance i of the draw
+ * processes layer i and writes cell i of an atlas with getColumns() cells
+ * per row, so output pixel (x, y) of item i is found at:
+ *
+ *   pixels[((i / cols) * height + y) * getAtlasWidth() + (i % cols) * width + x]
+ *
+ * The fragment stage is GLSL ES 3.00 / GLSL 3.30 and defines
+ * "vec4 process(vec2 texCoord, float layer)", with access to the input
+ * through "uniform sampler2DArray uInputTex" and "uniform vec2 uTexelSize":
+ *
+ *   vec4 process(vec2 texCoord, float layer) { return texture(uInputTex, vec3(texCoord, layer)); }
+ */
+
+class GLBatch
+{
+public:
+    // Throws if the atlas would exceed GL_MAX_TEXTURE_SIZE:
+    GLBatch(int width, int height, int capacity, const std::string& stageSrc = {});
+    ~GLBatch();
+
+    // Upload count contiguous images (RGBA) to layers first...first+count-1:
+    void upload(const GLubyte* pixels, int first, int count);
+
+    // Copy the width x height crop at (x, y) of texture to layer (no CPU copy):
+    void copy(int layer, GLuint texture, int x, int y);
+
+    // Process layers 0...count-1 in one instanced draw, return the atlas:
+    GLuint operator()(int count);
+
+    // Read the atlas (RGBA), non-blocking start() where PBOs are available:
+    void start();
+    void finish(GLubyte* pixels);
+    void read(GLubyte* pixels);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getCapacity() const { return m_capacity; }
+    int getColumns() const { return m_columns; }
+    int getAtlasWidth() const { return int(m_atlas->getWidth()); }
+    int getAtlasHeight() const { return int(m_atlas->getHeight()); }
+
+    GLuint getInput() const { return m_input; }
+    GLuint getAtlas() const { return *m_atlas; }
+
+    // Default stage (identity):
+    static const char* getDefaultStage();
+
+protected:
+    int m_width = 0;
+    int m_height = 0;
+    int m_capacity = 0;
+    int m_columns = 0;
+
+    GLuint m_input = 0; // GL_TEXTURE_2D_ARRAY
+    GLAllocation m_inputAllocation;
+    GLOwner m_owner;
+    std::unique_ptr<GLTexture> m_atlas;
+    GLFrameBufferObject m_atlasFbo;
+    GLFrameBufferObject m_readFbo;
+
+    GLQuad m_quad;
+    GLShader m_shader;
+
+    std::unique_ptr<IPBO> m_pbo;
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_TEXTURE_ARRAY)
+
+#endif // __aglet_GLBatch_h__
@@ -0,0 +1,80 @@
+/*!
+  @file   GLBuffer.cpp
+  @brief  Implementation of a minimal OpenGL buffer object wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLBuffer.h"
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+
+#include <cstring>
+
+AGLET_BEGIN
+
+GLBuffer::GLBuffer(GLenum target, std::size_t size, GLenum usage, const void* data)
+    : target(target)
+    , size(size)
+{
+    id = GLNamePool::generate(GLNamePool::kBuffer);
+    checkGLError("GLBuffer::GLBuffer() : glGenBuffers()");
+    bind();
+    glBufferData(target, GLsizeiptr(size), data, usage);
+    checkGLError("GLBuffer::GLBuffer() : glBufferData()");
+    unbind();
+
+    allocation = GLAllocation(GLMemory::kBuffer, size);
+}
+
+GLBuffer::~GLBuffer()
+{
+    if (id > 0)
+    {
+        owner.release(GLDeletionQueue::kBuffer, id, std::move(allocation));
+        id = 0;
+    }
+}
+
+void GLBuffer::bind()
+{
+    glBindBuffer(target, id);
+}
+
+void GLBuffer::unbind()
+{
+    glBindBuffer(target, 0);
+}
+
+void GLBuffer::write(const void* data, std::size_t size, std::size_t offset)
+{
+    throw_assert((offset + size) <= this->size, "GLBuffer::write() : out of range");
+    bind();
+    glBufferSubData(target, GLintptr(offset), GLsizeiptr(size), data);
+    checkGLError("GLBuffer::write() : glBufferSubData()");
+    unbind();
+}
+
+#if !defined(AGLET_OPENGL_ES2)
+void GLBuffer::read(void* data, std::size_t size, std::size_t offset)
+{
+    throw_assert((offset + size) <= this->size, "GLBuffer::read() : out of range");
+    bind();
+#if defined(AGLET_OSX)
+    // Note: glMapBufferRange does not seem to work in OS X
+    const auto* ptr = static_cast<const GLubyte*>(glMapBuffer(target, GL_READ_ONLY));
+    ptr = ptr ? (ptr + offset) : ptr;
+#else
+    const auto* ptr = static_cast<const GLubyte*>(glMapBufferRange(target, GLintptr(offset), GLsizeiptr(size), GL_MAP_READ_BIT));
+#endif
+    checkGLError("GLBuffer::read() : glMapBufferRange()");
+    throw_assert(ptr, "GLBuffer::read() : glMapBufferRange()");
+    std::memcpy(data, ptr, size);
+    glUnmapBuffer(target);
+    unbind();
+}
+#endif
+
+AGLET_END
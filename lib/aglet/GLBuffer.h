@@ -0,0 +1,60 @@
+/*!
+  @file   GLBuffer.h
+  @brief  Declaration of a minimal OpenGL buffer object wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLBuffer_h__
+#define __aglet_GLBuffer_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLDeletionQueue.h"
+#include "aglet/GLMemory.h"
+
+#include <cstddef>
+
+AGLET_BEGIN
+
+class GLBuffer
+{
+public:
+    GLBuffer(GLenum target, std::size_t size, GLenum usage, const void* data = nullptr);
+    ~GLBuffer();
+
+    GLBuffer(const GLBuffer&) = delete;
+    GLBuffer& operator=(const GLBuffer&) = delete;
+
+    void bind();
+    void unbind();
+
+    // Upload size bytes at offset (glBufferSubData):
+    void write(const void* data, std::size_t size, std::size_t offset = 0);
+
+#if !defined(AGLET_OPENGL_ES2)
+    // Download size bytes at offset through a read only mapping:
+    void read(void* data, std::size_t size, std::size_t offset = 0);
+#endif
+
+    GLenum getTarget() const { return target; }
+    std::size_t getSize() const { return size; }
+
+    operator GLuint() const
+    {
+        return id;
+    }
+
+protected:
+    GLenum target;
+    std::size_t size;
+    GLuint id = 0;
+    GLAllocation allocation; // GLMemory::kBuffer
+    GLOwner owner;
+};
+
+AGLET_END
+
+#endif // __aglet_GLBuffer_h__
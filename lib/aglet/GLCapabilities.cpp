@@ -0,0 +1,218 @@
+/*!
+  @file   GLCapabilities.cpp
+  @brief  Implementation of cached version, extension and limit queries of a context.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLContext.h"
+#include "aglet/GLDispatch.h" // AGLET_APIENTRY
+#include "aglet/gl_includes.h"
+
+// clang-format off
+#if defined(AGLET_EGL)
+#  include <EGL/egl.h>
+#endif
+// clang-format on
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+AGLET_BEGIN
+
+// Tokens of later versions (not in all headers), queried only if the context version has them:
+static const GLenum kNumExtensions = 0x821D;                   // GL_NUM_EXTENSIONS
+static const GLenum kMaxArrayTextureLayers = 0x88FF;           // GL_MAX_ARRAY_TEXTURE_LAYERS
+static const GLenum kMaxSamples = 0x8D57;                      // GL_MAX_SAMPLES
+static const GLenum kMaxComputeWorkGroupInvocations = 0x90EB;  // GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS
+static const GLenum kMaxComputeWorkGroupCount = 0x91BE;        // GL_MAX_COMPUTE_WORK_GROUP_COUNT
+static const GLenum kMaxComputeWorkGroupSize = 0x91BF;         // GL_MAX_COMPUTE_WORK_GROUP_SIZE
+
+using GetStringi = const GLubyte*(AGLET_APIENTRY*)(GLenum name, GLuint index);
+using GetIntegeri = void(AGLET_APIENTRY*)(GLenum target, GLuint index, GLint* data);
+
+static std::string getString(GLenum name)
+{
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+static void split(const std::string& names, std::unordered_set<std::string>& result)
+{
+    std::stringstream ss(names);
+    std::string name;
+    while (ss >> name)
+    {
+        result.insert(name);
+    }
+}
+
+static GetStringi getGetStringi(const GLContext* context)
+{
+    if (context)
+    {
+        return reinterpret_cast<GetStringi>(context->getProcAddress("glGetStringi"));
+    }
+#if defined(AGLET_EGL)
+    return reinterpret_cast<GetStringi>(eglGetProcAddress("glGetStringi")); // native context without an aglet context
+#else
+    return nullptr;
+#endif
+}
+
+static int getInteger(GLenum name)
+{
+    GLint value = 0;
+    glGetIntegerv(name, &value);
+    return value;
+}
+
+GLCapabilities::GLCapabilities(const GLContext* context)
+{
+    m_vendor = getString(GL_VENDOR);
+    m_renderer = getString(GL_RENDERER);
+    m_version = getString(GL_VERSION);
+    m_shadingLanguageVersion = getString(GL_SHADING_LANGUAGE_VERSION);
+
+    const char* text = m_version.c_str();
+    m_es = (std::strncmp(text, "OpenGL ES", 9) == 0);
+    if (m_es)
+    {
+        text += std::strcspn(text, "0123456789"); // "OpenGL ES 3.1", "OpenGL ES-CM 1.1"
+    }
+    if (std::sscanf(text, "%d.%d", &m_major, &m_minor) != 2)
+    {
+        m_major = m_minor = 0;
+    }
+
+    // GL_EXTENSIONS is not a glGetString() name in core profiles, use glGetStringi() where available:
+    auto getStringi = isVersion(3, 0) ? getGetStringi(context) : nullptr;
+    if (getStringi)
+    {
+        const GLint count = getInteger(kNumExtensions);
+        for (GLint i = 0; i < count; i++)
+        {
+            const GLubyte* name = getStringi(GL_EXTENSIONS, GLuint(i));
+            if (name)
+            {
+                m_names.insert(reinterpret_cast<const char*>(name));
+            }
+        }
+    }
+    else if (const GLubyte* names = glGetString(GL_EXTENSIONS))
+    {
+        split(reinterpret_cast<const char*>(names), m_names);
+    }
+    else if (isVersion(3, 0))
+    {
+        glGetError(); // GL_INVALID_ENUM of a core profile, not an error of the caller
+    }
+
+    for (int i = 0; i < kExtensionCount; i++)
+    {
+        m_extensions[i] = has(getName(Extension(i)));
+    }
+
+    if (context)
+    {
+        split(context->getPlatformExtensions(), m_names); // EGL_*
+    }
+
+    m_limits.maxTextureSize = getInteger(GL_MAX_TEXTURE_SIZE);
+    m_limits.maxRenderbufferSize = getInteger(GL_MAX_RENDERBUFFER_SIZE);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, m_limits.maxViewportDims);
+    m_limits.maxTextureImageUnits = getInteger(GL_MAX_TEXTURE_IMAGE_UNITS);
+    m_limits.maxCombinedTextureImageUnits = getInteger(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS);
+    m_limits.maxVertexAttribs = getInteger(GL_MAX_VERTEX_ATTRIBS);
+
+    if (isVersion(3, 0))
+    {
+        m_limits.maxArrayTextureLayers = getInteger(kMaxArrayTextureLayers);
+        m_limits.maxSamples = getInteger(kMaxSamples);
+    }
+
+    const bool compute = m_es ? isVersion(3, 1) : (isVersion(4, 3) || has(kARB_compute_shader));
+    auto getIntegeri = (context && compute) ? reinterpret_cast<GetIntegeri>(context->getProcAddress("glGetIntegeri_v")) : nullptr;
+    if (getIntegeri)
+    {
+        m_limits.maxComputeWorkGroupInvocations = getInteger(kMaxComputeWorkGroupInvocations);
+        for (GLuint i = 0; i < 3; i++)
+        {
+            getIntegeri(kMaxComputeWorkGroupSize, i, &m_limits.maxComputeWorkGroupSize[i]);
+            getIntegeri(kMaxComputeWorkGroupCount, i, &m_limits.maxComputeWorkGroupCount[i]);
+        }
+    }
+}
+
+// Identity of the current native context, the version and renderer strings
+// tell contexts apart where the platform has no current context query:
+struct NativeKey
+{
+    const void* context = nullptr;
+    const GLubyte* version = nullptr;
+    const GLubyte* renderer = nullptr;
+
+    bool operator==(const NativeKey& other) const
+    {
+        return (context == other.context) && (version == other.version) && (renderer == other.renderer);
+    }
+};
+
+static NativeKey getNativeKey()
+{
+    NativeKey key;
+#if defined(AGLET_EGL)
+    key.context = eglGetCurrentContext();
+#endif
+    key.version = glGetString(GL_VERSION);
+    key.renderer = glGetString(GL_RENDERER);
+    return key;
+}
+
+const GLCapabilities& GLCapabilities::current()
+{
+    GLContext* context = GLContext::current();
+    if (context)
+    {
+        return context->capabilities();
+    }
+
+    // Not an aglet context: queried again only when the native context changes
+    thread_local std::unique_ptr<GLCapabilities> capabilities;
+    thread_local NativeKey key;
+
+    const NativeKey current = getNativeKey();
+    if (!capabilities || !(current == key))
+    {
+        capabilities.reset(new GLCapabilities(nullptr));
+        key = current;
+    }
+    return *capabilities;
+}
+
+bool GLCapabilities::hasFloatRenderTargets() const
+{
+#if defined(AGLET_OPENGL_ES2) || !defined(GL_RGBA32F)
+    return false;
+#else
+    return !m_es || has(kEXT_color_buffer_float);
+#endif
+}
+
+const char* GLCapabilities::getName(Extension extension)
+{
+    // clang-format off
+#define AGLET_GL_EXTENSION_NAME(name) "GL_" #name,
+    static const char* names[] = { AGLET_GL_EXTENSIONS(AGLET_GL_EXTENSION_NAME) };
+#undef AGLET_GL_EXTENSION_NAME
+    // clang-format on
+
+    return (extension < kExtensionCount) ? names[extension] : "unknown";
+}
+
+AGLET_END
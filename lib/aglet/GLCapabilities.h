@@ -0,0 +1,129 @@
+/*!
+  @file   GLCapabilities.h
+  @brief  Declaration of cached version, extension and limit queries of a context.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLCapabilities_h__
+#define __aglet_GLCapabilities_h__
+
+#include "aglet/aglet.h"
+
+#include <array>
+#include <bitset>
+#include <string>
+#include <unordered_set>
+
+/*
+ * Version, extensions and limits of a context, queried once (with the
+ * context current) instead of parsing glGetString(GL_EXTENSIONS) in each
+ * feature that needs an extension:
+ *
+ *   const auto& caps = context->capabilities();
+ *   if (caps.has(aglet::GLCapabilities::kEXT_color_buffer_float)) // bit test
+ *   if (caps.has("GL_OES_texture_float_linear"))                  // hash lookup
+ *   if (caps.has("EGL_KHR_fence_sync"))                           // platform extension
+ *   caps.getLimits().maxTextureSize;
+ *
+ * The extensions aglet selects fast paths with are listed below and kept
+ * in a bitset, any other name (including the platform extensions of the
+ * context, see GLContext::getPlatformExtensions()) is found in a hash set.
+ */
+
+// clang-format off
+#define AGLET_GL_EXTENSIONS(X) \
+    X(EXT_color_buffer_float) X(EXT_color_buffer_half_float) X(OES_texture_float_linear) \
+    X(ARB_buffer_storage) X(EXT_buffer_storage) \
+    X(ARB_texture_storage) X(EXT_texture_storage) \
+    X(KHR_parallel_shader_compile) X(ARB_parallel_shader_compile) \
+    X(ARB_timer_query) X(EXT_disjoint_timer_query) \
+    X(KHR_debug) X(ARB_compute_shader) \
+    X(NVX_gpu_memory_info) X(ATI_meminfo)
+// clang-format on
+
+AGLET_BEGIN
+
+class GLContext;
+
+class GLCapabilities
+{
+public:
+    // clang-format off
+#define AGLET_GL_EXTENSION_ENUM(name) k##name,
+    enum Extension
+    {
+        AGLET_GL_EXTENSIONS(AGLET_GL_EXTENSION_ENUM)
+        kExtensionCount
+    };
+#undef AGLET_GL_EXTENSION_ENUM
+    // clang-format on
+
+    // Limits, zero where the context version lacks the query:
+    struct Limits
+    {
+        int maxTextureSize = 0;
+        int maxRenderbufferSize = 0;
+        int maxViewportDims[2] = { 0, 0 };
+        int maxTextureImageUnits = 0;         // fragment shader
+        int maxCombinedTextureImageUnits = 0; // all stages
+        int maxVertexAttribs = 0;
+        int maxArrayTextureLayers = 0; // OpenGL ES 3.0, OpenGL 3.0
+        int maxSamples = 0;            // OpenGL ES 3.0, OpenGL 3.0
+
+        // OpenGL ES 3.1, OpenGL 4.3:
+        int maxComputeWorkGroupInvocations = 0;
+        std::array<int, 3> maxComputeWorkGroupSize = { { 0, 0, 0 } };
+        std::array<int, 3> maxComputeWorkGroupCount = { { 0, 0, 0 } };
+    };
+
+    // Query the current context (context provides entry points and platform extensions, may be nullptr):
+    explicit GLCapabilities(const GLContext* context);
+
+    // Capabilities of the current context, cached by the aglet context (see GLContext::current()),
+    // or per thread for other contexts until the native context changes (references are invalidated then):
+    static const GLCapabilities& current();
+
+    // Version of the context, i.e., 3.1 for "OpenGL ES 3.1 Mesa ...":
+    int getMajorVersion() const { return m_major; }
+    int getMinorVersion() const { return m_minor; }
+    bool isES() const { return m_es; }
+    bool isVersion(int major, int minor) const { return (m_major > major) || ((m_major == major) && (m_minor >= minor)); }
+
+    const std::string& getVendor() const { return m_vendor; }
+    const std::string& getRenderer() const { return m_renderer; }
+    const std::string& getVersion() const { return m_version; }
+    const std::string& getShadingLanguageVersion() const { return m_shadingLanguageVersion; }
+
+    bool has(Extension extension) const { return m_extensions[extension]; }
+    bool has(const std::string& name) const { return m_names.count(name) > 0; }
+    const std::unordered_set<std::string>& getExtensions() const { return m_names; }
+
+    const Limits& getLimits() const { return m_limits; }
+
+    // GL_RGBA32F and GL_RGBA16F textures are color renderable (desktop, or GL_EXT_color_buffer_float):
+    bool hasFloatRenderTargets() const;
+
+    static const char* getName(Extension extension); // i.e., "GL_EXT_color_buffer_float"
+
+protected:
+    int m_major = 0;
+    int m_minor = 0;
+    bool m_es = false;
+
+    std::string m_vendor;
+    std::string m_renderer;
+    std::string m_version;
+    std::string m_shadingLanguageVersion;
+
+    std::bitset<kExtensionCount> m_extensions;
+    std::unordered_set<std::string> m_names;
+
+    Limits m_limits;
+};
+
+AGLET_END
+
+#endif // __aglet_GLCapabilities_h__
@@ -0,0 +1,167 @@
+/*!
+  @file   GLComputeProgram.cpp
+  @brief  Implementation of a compute shader program wrapper and dispatch helpers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLComputeProgram.h"
+#include "aglet/GLCapabilities.h"
+
+#if defined(AGLET_HAS_COMPUTE)
+
+#include "aglet/GLError.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTrace.h"
+
+#include <algorithm>
+#include <sstream>
+
+AGLET_BEGIN
+
+void GLMemoryBarrier::read(GLbitfield consumers)
+{
+    const GLbitfield bits = (m_pending & consumers);
+    if (bits)
+    {
+        glMemoryBarrier(bits);
+        m_pending &= ~bits;
+    }
+}
+
+GLComputeProgram::GLComputeProgram(const std::string& src)
+{
+    AGLET_TRACE_SCOPE("GLComputeProgram::GLComputeProgram", "shader");
+    GLuint shader = GLShader::compile(GL_COMPUTE_SHADER, src.c_str());
+    throw_assert(shader, "GLComputeProgram::GLComputeProgram() : GLShader::compile()");
+
+    m_programId = glCreateProgram();
+    glAttachShader(m_programId, shader);
+    glLinkProgram(m_programId);
+    glDeleteShader(shader); // flagged for deletion with the program
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(m_programId, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar infoLogBuf[1024] = {};
+        GLsizei infoLogLen = 0;
+        glGetProgramInfoLog(m_programId, 1024, &infoLogLen, infoLogBuf);
+        glDeleteProgram(m_programId);
+        m_programId = 0;
+        throw_assert(false, "GLComputeProgram::GLComputeProgram() : glLinkProgram() " << infoLogBuf);
+    }
+
+    GLint localSize[3] = { 1, 1, 1 };
+    glGetProgramiv(m_programId, GL_COMPUTE_WORK_GROUP_SIZE, localSize);
+    checkGLError("GLComputeProgram::GLComputeProgram() : glGetProgramiv()");
+    m_localSize = { { GLuint(localSize[0]), GLuint(localSize[1]), GLuint(localSize[2]) } };
+}
+
+GLComputeProgram::~GLComputeProgram()
+{
+    if (m_programId > 0)
+    {
+        m_owner.release(GLDeletionQueue::kProgram, m_programId);
+        m_programId = 0;
+    }
+}
+
+void GLComputeProgram::use()
+{
+    glUseProgram(m_programId);
+}
+
+GLint GLComputeProgram::getUniform(const char* name) const
+{
+    return glGetUniformLocation(m_programId, name);
+}
+
+auto GLComputeProgram::getGroupCount(GLuint x, GLuint y, GLuint z) const -> Size
+{
+    return { { (x + m_localSize[0] - 1) / m_localSize[0],
+        (y + m_localSize[1] - 1) / m_localSize[1],
+        (z + m_localSize[2] - 1) / m_localSize[2] } };
+}
+
+void GLComputeProgram::dispatch(const Size& groups, GLMemoryBarrier* barrier)
+{
+    use();
+    glDispatchCompute(groups[0], groups[1], groups[2]);
+    if (barrier)
+    {
+        barrier->write();
+    }
+}
+
+void GLComputeProgram::run(GLuint x, GLuint y, GLuint z, GLMemoryBarrier* barrier)
+{
+    dispatch(getGroupCount(x, y, z), barrier);
+}
+
+void GLComputeProgram::bindStorageBuffer(GLuint index, GLuint buffer)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
+}
+
+void GLComputeProgram::bindImage(GLuint unit, GLuint texture, GLenum access, GLenum format, GLint level)
+{
+    glBindImageTexture(unit, texture, level, GL_FALSE, 0, access, format);
+}
+
+const char* GLComputeProgram::getVersionDeclaration()
+{
+#if defined(AGLET_OPENGL_ES31)
+    return "#version 310 es\n";
+#else
+    return "#version 430\n";
+#endif
+}
+
+std::string GLComputeProgram::getLocalSizeDeclaration(const Size& size)
+{
+    std::stringstream ss;
+    ss << "layout(local_size_x = " << size[0] << ", local_size_y = " << size[1] << ", local_size_z = " << size[2] << ") in;\n";
+    return ss.str();
+}
+
+auto GLComputeProgram::getDefaultLocalSize(int dimensions) -> Size
+{
+    // Minimum maximums are 128 invocations and 128 x 128 x 64 (OpenGL ES 3.1):
+    const auto& limits = GLCapabilities::current().getLimits();
+    GLint invocations = limits.maxComputeWorkGroupInvocations ? limits.maxComputeWorkGroupInvocations : 128;
+    const GLint maxSize[3] = {
+        limits.maxComputeWorkGroupSize[0] ? limits.maxComputeWorkGroupSize[0] : 128,
+        limits.maxComputeWorkGroupSize[1] ? limits.maxComputeWorkGroupSize[1] : 128,
+        limits.maxComputeWorkGroupSize[2] ? limits.maxComputeWorkGroupSize[2] : 64
+    };
+
+    // Up to 256 invocations (a common sweet spot), split between the dimensions:
+    invocations = std::min(invocations, 256);
+
+    Size size = { { 1, 1, 1 } };
+    switch (dimensions)
+    {
+        case 1:
+            size[0] = GLuint(std::min(invocations, maxSize[0]));
+            break;
+        case 2:
+            size[0] = size[1] = (invocations >= 256) ? 16 : 8;
+            break;
+        default:
+            size[0] = size[1] = (invocations >= 256) ? 8 : 4;
+            size[2] = 4;
+            break;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        size[i] = std::min(size[i], GLuint(maxSize[i]));
+    }
+    return size;
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_COMPUTE)
@@ -0,0 +1,110 @@
+/*!
+  @file   GLComputeProgram.h
+  @brief  Declaration of a compute shader program wrapper and dispatch helpers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLComputeProgram_h__
+#define __aglet_GLComputeProgram_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLDeletionQueue.h"
+
+#if defined(AGLET_HAS_COMPUTE)
+
+#include <array>
+#include <string>
+
+AGLET_BEGIN
+
+/*
+ * Tracks incoherent writes (image stores, SSBO writes, atomics) made by
+ * compute dispatches and issues glMemoryBarrier() lazily, only for the
+ * consumers that actually read the results, e.g.:
+ *
+ *   program.dispatch(groups, &barrier);
+ *   barrier.read(GL_BUFFER_UPDATE_BARRIER_BIT); // before glMapBufferRange()
+ *   barrier.read(GL_BUFFER_UPDATE_BARRIER_BIT); // noop, already visible
+ *
+ * Barriers are per context: use one instance for each context.
+ */
+
+class GLMemoryBarrier
+{
+public:
+    // Record a dispatch with incoherent writes:
+    void write() { m_pending = GL_ALL_BARRIER_BITS; }
+
+    // Make pending writes visible to consumers (GL_*_BARRIER_BIT):
+    void read(GLbitfield consumers);
+
+    // Issue all pending barriers:
+    void flush() { read(GL_ALL_BARRIER_BITS); }
+
+    GLbitfield getPending() const { return m_pending; }
+
+protected:
+    GLbitfield m_pending = 0;
+};
+
+class GLComputeProgram
+{
+public:
+    using Size = std::array<GLuint, 3>;
+
+    // Compile and link compute shader source, throws on failure:
+    explicit GLComputeProgram(const std::string& src);
+    ~GLComputeProgram();
+
+    GLComputeProgram(const GLComputeProgram&) = delete;
+    GLComputeProgram& operator=(const GLComputeProgram&) = delete;
+
+    void use();
+
+    GLint getUniform(const char* name) const;
+
+    // Work group size declared by the shader (local_size_{x,y,z}):
+    const Size& getLocalSize() const { return m_localSize; }
+
+    // Number of work groups needed to cover a domain of size x * y * z:
+    Size getGroupCount(GLuint x, GLuint y = 1, GLuint z = 1) const;
+
+    // Dispatch work groups (program is used), recording writes in barrier:
+    void dispatch(const Size& groups, GLMemoryBarrier* barrier = nullptr);
+
+    // Dispatch enough work groups to cover a domain of size x * y * z:
+    void run(GLuint x, GLuint y = 1, GLuint z = 1, GLMemoryBarrier* barrier = nullptr);
+
+    GLuint getProgramId() const { return m_programId; }
+
+    // Bind an SSBO to binding point index (layout(std430, binding = index)):
+    static void bindStorageBuffer(GLuint index, GLuint buffer);
+
+    // Bind a texture level to image unit (layout(format, binding = unit)):
+    static void bindImage(GLuint unit, GLuint texture, GLenum access, GLenum format, GLint level = 0);
+
+    // "#version 310 es" or "#version 430" for the current build:
+    static const char* getVersionDeclaration();
+
+    // "layout(local_size_x = x, local_size_y = y, local_size_z = z) in;":
+    static std::string getLocalSizeDeclaration(const Size& size);
+
+    // Work group size for a 1D, 2D or 3D domain within the context limits
+    // (GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS and _SIZE), e.g. 16x16 for 2D:
+    static Size getDefaultLocalSize(int dimensions);
+
+protected:
+    GLuint m_programId = 0;
+    Size m_localSize = { { 1, 1, 1 } };
+    GLOwner m_owner;
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_COMPUTE)
+
+#endif // __aglet_GLComputeProgram_h__
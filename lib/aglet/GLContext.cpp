@@ -1,4 +1,10 @@
 #include "aglet/GLContext.h"
+#include "aglet/GLBuffer.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLDispatch.h"
+#include "aglet/GLMemory.h"
+#include "aglet/GLNamePool.h"
+#include "aglet/GLTrace.h"
 #include "aglet/gl_includes.h"
 
 #include <assert.h>
@@ -25,25 +31,142 @@
 
 AGLET_BEGIN
 
+// A context may be destroyed on any thread, the other threads it was current on
+// see it expire through its liveness token instead of keeping a dangling pointer:
+struct CurrentContext
+{
+    GLContext* context = nullptr;
+    std::weak_ptr<void> alive;
+};
+
+static thread_local CurrentContext currentContext;
+
+GLContext::~GLContext()
+{
+    m_alive.reset();
+    if (currentContext.context == this)
+    {
+        currentContext = {};
+    }
+}
+
+GLContext* GLContext::current()
+{
+    if (currentContext.context && currentContext.alive.expired())
+    {
+        currentContext = {};
+    }
+    return currentContext.context;
+}
+
+void GLContext::setCurrent(GLContext* context)
+{
+    currentContext.context = context;
+    currentContext.alive = context ? context->m_alive : nullptr;
+    if (context)
+    {
+        context->m_deletionQueue->drain();
+    }
+}
+
+void GLContext::releaseObjects()
+{
+    if (current() != this)
+    {
+        return;
+    }
+
+    m_packBuffer.reset();
+    m_unpackBuffer.reset();
+    m_deletionQueue->drain();
+    if (m_namePool)
+    {
+        m_namePool->clear(); // free names and recycled textures, the share group may outlive this context
+    }
+
+#if defined(AGLET_TRACE)
+    GLTrace::collect(); // GPU spans of this thread, deletes their queries
+#endif
+}
+
+const GLCapabilities& GLContext::capabilities()
+{
+    if (!m_capabilities)
+    {
+        m_capabilities = std::make_shared<GLCapabilities>(this);
+    }
+    return *m_capabilities;
+}
+
+const GLDispatch& GLContext::getDispatch()
+{
+    if (!m_dispatch)
+    {
+        m_dispatch = std::make_shared<GLDispatch>(*this, capabilities());
+    }
+    return *m_dispatch;
+}
+
+GLMemory& GLContext::getMemory()
+{
+    if (!m_memory)
+    {
+        m_memory = std::make_shared<GLMemory>();
+
+        // The caches of this context go first, recycled textures before transfer
+        // buffers, and before any evictor of the application:
+        m_memory->addEvictor([this](std::size_t bytes) {
+            if (m_namePool && (current() == this))
+            {
+                m_namePool->trim(bytes);
+            }
+        });
+        m_memory->addEvictor([this](std::size_t) {
+            if (current() == this)
+            {
+                m_packBuffer.reset();
+                m_unpackBuffer.reset();
+            }
+        });
+    }
+    return *m_memory;
+}
+
+GLNamePool& GLContext::getNamePool()
+{
+    if (!m_namePool)
+    {
+        getMemory(); // evicts the recycled textures first
+        m_namePool = std::make_shared<GLNamePool>();
+    }
+    return *m_namePool;
+}
+
 auto GLContext::create(ContextKind kind, const std::string& name, int width, int height, GLVersion version) -> GLContextPtr
 {
+    AGLET_TRACE_SCOPE("GLContext::create", "context");
+
+    GLContextPtr context;
     switch (kind)
     {
         case kAuto:
 
 #if defined(AGLET_IOS)
         case kIOS:
-            return std::make_shared<aglet::GLContextIOS>(width, height, version);
+            context = std::make_shared<aglet::GLContextIOS>(width, height, version);
+            break;
 #endif
 
 #if defined(AGLET_EGL)
         case kEGL:
-            return std::make_shared<aglet::EGLContextImpl>(width, height, version);
+            context = std::make_shared<aglet::EGLContextImpl>(width, height, version);
+            break;
 #endif
 
 #if defined(AGLET_HAS_GLFW)
         case kGLFW:
-            return std::make_shared<aglet::GLFWContext>(name, width, height);
+            context = std::make_shared<aglet::GLFWContext>(name, width, height, version);
+            break;
 #endif
 
         default:
@@ -51,7 +174,10 @@ auto GLContext::create(ContextKind kind, const std::string& name, int width, int
             break;
     }
 
-    return nullptr;
+    // Backends make the new context current:
+    setCurrent(context.get());
+
+    return context;
 }
 
 AGLET_END
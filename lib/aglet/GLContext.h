@@ -12,16 +12,25 @@
 #define __aglet_GLContext_h__
 
 #include "aglet/aglet.h"
+#include "aglet/GLDeletionQueue.h"
+#include "aglet/GLStats.h"
 #include <memory>
 #include <string>
 #include <functional>
 
 AGLET_BEGIN
 
+class GLBuffer;
+class GLCapabilities;
+class GLDispatch;
+class GLMemory;
+class GLNamePool;
+
 class GLContext
 {
 public:
     using GLContextPtr = std::shared_ptr<GLContext>;
+    using ProcAddress = void (*)();
     using RenderDelegate = std::function<bool(void)>;
     using CursorDelegate = std::function<void(double xpos, double ypos)>;
 
@@ -38,7 +47,22 @@ public:
     {
         kGL,
         kGLES20,
-        kGLES30
+        kGLES30,
+        kGLES31, // compute shaders (OpenGL ES 3.1)
+        kGL43    // compute shaders (desktop OpenGL 4.3, compatibility profile)
+    };
+
+    // Pixel transfer methods, see GLTransferTuner.h:
+    enum TransferMethod
+    {
+        kTransferDirect, // client memory (glReadPixels / glTexSubImage2D)
+        kTransferPBO     // through a mapped pixel buffer object
+    };
+
+    struct TransferStrategy
+    {
+        TransferMethod readback = kTransferDirect;
+        TransferMethod upload = kTransferDirect;
     };
 
     struct Geometry
@@ -52,7 +76,7 @@ public:
     };
 
     GLContext() {}
-    ~GLContext() {}
+    ~GLContext();
 
     GLContext(const std::string& name, int width, int height) {}
 
@@ -68,11 +92,82 @@ public:
     virtual void resize(int width, int height) {}
     virtual void operator()(RenderDelegate& f){}; // render loop
 
+    // Swap interval (vsync) control:
+    //   interval > 0 : wait for interval vertical blanks per swap
+    //   interval = 0 : unsynchronized swaps (throughput benchmarks)
+    //   interval < 0 : adaptive sync, late swaps tear (*_swap_control_tear)
+    // Returns true if the backend honoured the requested interval, otherwise
+    // the nearest supported interval is applied (see getSwapInterval()).
+    virtual bool setSwapInterval(int interval)
+    {
+        m_swapIntervalRequested = interval;
+        m_swapIntervalHonoured = (interval == m_swapInterval);
+        return m_swapIntervalHonoured;
+    }
+    int getSwapInterval() const { return m_swapInterval; }
+    bool isSwapIntervalHonoured() const { return m_swapIntervalHonoured; }
+
+    // Transfer methods used by aglet (readPixels(), writePixels(), ...) while
+    // this context is current, set by calibrateTransfers() (calibrated) or by hand:
+    void setTransferStrategy(const TransferStrategy& strategy, bool calibrated = false)
+    {
+        m_transferStrategy = strategy;
+        m_transferCalibrated = calibrated;
+    }
+    const TransferStrategy& getTransferStrategy() const { return m_transferStrategy; }
+    bool isTransferCalibrated() const { return m_transferCalibrated; }
+
+    // Address of an entry point of this context (current), nullptr if unknown.  Some
+    // loaders (i.e., libglvnd) return stubs for any name, check the version first:
+    virtual ProcAddress getProcAddress(const char* name) const { return nullptr; }
+
+    // Platform (i.e., EGL) extensions of this context, space separated:
+    virtual std::string getPlatformExtensions() const { return {}; }
+
+    // Version, extensions and limits of this context, queried on first use (call with the context current):
+    const GLCapabilities& capabilities();
+
+    // Optional entry points of this context, resolved on first use (call with the context current):
+    const GLDispatch& getDispatch();
+
+    // Memory held by the aglet resources of this context, budget and evictors (see GLMemory.h):
+    GLMemory& getMemory();
+
+    // Batched object names and recycled immutable textures of this context, created on first use (see GLNamePool.h):
+    GLNamePool& getNamePool();
+
+    // Names released by aglet wrappers on other threads, deleted when this context
+    // is made current through aglet and at the end of each frame (see GLDeletionQueue.h):
+    GLDeletionQueue& getDeletionQueue() { return *m_deletionQueue; }
+
+    // GL call statistics of this context (AGLET_GL_STATS builds):
+    GLStats& getStats() { return m_stats; }
+    const GLStats& getStats() const { return m_stats; }
+
+    // Context last made current on this thread through aglet (nullptr if none or destroyed since):
+    static GLContext* current();
+
     Geometry& getGeometry() { return m_geometry; }
     const Geometry& getGeometry() const { return m_geometry; }
 
     Geometry m_geometry;
 
+    int m_swapInterval = 1;              // effective swap interval
+    int m_swapIntervalRequested = 1;     // last requested swap interval
+    bool m_swapIntervalHonoured = true;  // requested == effective
+
+    GLStats m_stats;
+
+    std::shared_ptr<GLCapabilities> m_capabilities;
+    std::shared_ptr<GLDispatch> m_dispatch; // contexts of a share group can share the table
+    std::shared_ptr<GLMemory> m_memory;     // resources outliving the context hold weak references
+    std::shared_ptr<GLDeletionQueue> m_deletionQueue = std::make_shared<GLDeletionQueue>(); // idem
+    std::shared_ptr<GLNamePool> m_namePool;
+    std::shared_ptr<void> m_alive = std::make_shared<bool>(true); // expires with the context (see current())
+
+    std::shared_ptr<GLBuffer> m_packBuffer;   // kTransferPBO readback (see readPixels()), grown on demand
+    std::shared_ptr<GLBuffer> m_unpackBuffer; // kTransferPBO upload (see writePixels()), grown on demand
+
     CursorDelegate cursorCallback;
 
     // Create context (w/ window if name is specified):
@@ -82,6 +177,18 @@ public:
         int width = 640,
         int height = 480,
         GLVersion version = kGLES20);
+
+protected:
+    // Backends call this whenever they make their context current:
+    static void setCurrent(GLContext* context);
+
+    // Backends call this first in their destructor: deletes the GL objects kept by
+    // this context if it is current on this thread (they go with the context otherwise):
+    void releaseObjects();
+
+private:
+    TransferStrategy m_transferStrategy;
+    bool m_transferCalibrated = false; // m_transferStrategy was measured (see setTransferStrategy())
 };
 
 AGLET_END
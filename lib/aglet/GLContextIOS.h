@@ -11,12 +11,13 @@
 #define __aglet_GLContextIOS_h__
 
 #include "aglet/GLContext.h"
+#include "aglet/GLContextLoop.h"
 
 #include <memory>
 
 AGLET_BEGIN
 
-class GLContextIOS : public GLContext
+class GLContextIOS : public GLContext, public GLContextLoop<GLContextIOS>
 {
 public:
     GLContextIOS(int width = 640, int height = 480, GLVersion version = kGLES20);
@@ -28,8 +29,16 @@ public:
     virtual bool hasDisplay() const;
     virtual void resize(int width, int height);
     virtual void operator()(std::function<bool(void)>& f);
+    virtual ProcAddress getProcAddress(const char* name) const;
 
 private:
+    friend GLContextLoop<GLContextIOS>;
+
+    // GLContextLoop<> hooks (offscreen, nothing is presented):
+    void beginLoop() {}
+    bool beginFrame() { return true; }
+    void endFrame() {}
+
     struct Impl;
     std::unique_ptr<Impl> impl;
 };
@@ -8,6 +8,7 @@
 */
 
 #include "aglet/GLContextIOS.h"
+#include "aglet/GLTrace.h"
 #include "aglet/aglet_assert.h"
 #include "aglet/gl_includes.h"
 
@@ -15,6 +16,8 @@
 
 #include <memory>
 
+#include <dlfcn.h>
+
 AGLET_BEGIN
 
 // Workaround for c++11 targets
@@ -32,6 +35,7 @@ struct GLContextIOS::Impl
         {
             case kGLES20: egl = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES2]; break;
             case kGLES30: egl = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES3]; break;
+            default: break; // kGL, kGLES31 and kGL43 are not supported on iOS
         }
         throw_assert(egl, "EAGLContexfft initWithAPI");
 
@@ -55,7 +59,7 @@ GLContextIOS::GLContextIOS(int width, int height, GLVersion version)
 
 GLContextIOS::~GLContextIOS()
 {
-    
+    releaseObjects();
 }
 
 GLContextIOS::operator bool() const
@@ -65,12 +69,20 @@ GLContextIOS::operator bool() const
 
 void GLContextIOS::operator()()
 {
+    AGLET_TRACE_SCOPE("makeCurrent", "context");
     if(impl)
     {
         (*impl)();
+        setCurrent(this);
     }
 }
 
+auto GLContextIOS::getProcAddress(const char* name) const -> ProcAddress
+{
+    // OpenGLES.framework exports all entry points:
+    return reinterpret_cast<ProcAddress>(dlsym(RTLD_DEFAULT, name));
+}
+
 // Display:
 bool GLContextIOS::hasDisplay() const
 {
@@ -84,7 +96,7 @@ void GLContextIOS::resize(int width, int height)
 
 void GLContextIOS::operator()(std::function<bool(void)> &f)
 {
-    while(f()) {}
+    run(f);
 }
 
 AGLET_END
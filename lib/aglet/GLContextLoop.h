@@ -0,0 +1,63 @@
+/*!
+  @file   GLContextLoop.h
+  @brief  Render loop with static dispatch of the per frame delegate.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLContextLoop_h__
+#define __aglet_GLContextLoop_h__
+
+#include "aglet/GLContext.h"
+#include "aglet/GLTrace.h"
+
+AGLET_BEGIN
+
+/*
+ * CRTP render loop: GLContext::operator()(RenderDelegate&) invokes a
+ * std::function through a virtual call on every frame, which shows up
+ * in tight GPGPU loops.  Backends derive from GLContextLoop<Impl> and
+ * provide the (inline) hooks below, so that run(f) compiles to a plain
+ * loop with the delegate inlined:
+ *
+ *   void beginLoop();  // once, before the first frame
+ *   bool beginFrame(); // per frame, return false to exit the loop
+ *   void endFrame();   // per frame, after the delegate (i.e., swap)
+ *
+ * Names queued for deletion by other threads are deleted after the
+ * delegate of each frame, if the context is current.  In AGLET_GL_STATS builds each iteration is a
+ * GLStats frame.
+ */
+
+template <typename Impl>
+class GLContextLoop
+{
+public:
+    template <typename Delegate>
+    void run(Delegate&& f)
+    {
+        Impl& impl = static_cast<Impl&>(*this);
+        impl.beginLoop();
+
+        bool okay = true;
+        while (okay && impl.beginFrame())
+        {
+            AGLET_TRACE_SCOPE("frame", "loop");
+            okay = f(); // <== callback
+            if (GLContext::current() == &impl) // the loop does not make the context current on every backend
+            {
+                impl.getDeletionQueue().drain();
+            }
+            impl.endFrame();
+#if defined(AGLET_GL_STATS)
+            impl.getStats().frame();
+#endif
+        }
+    }
+};
+
+AGLET_END
+
+#endif // __aglet_GLContextLoop_h__
@@ -0,0 +1,72 @@
+/*!
+  @file   GLContextStatic.h
+  @brief  Compile time selection of the GLContext backend.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLContextStatic_h__
+#define __aglet_GLContextStatic_h__
+
+#include "aglet/GLContext.h"
+
+#include <cassert>
+#include <functional>
+#include <utility>
+
+// clang-format off
+#if defined(AGLET_HAS_GLFW)
+#  include "aglet/GLFWContext.h"
+#endif
+#if defined(AGLET_EGL)
+#  include "aglet/EGLContext.h"
+#endif
+#if defined(AGLET_IOS)
+#  include "aglet/GLContextIOS.h"
+#endif
+#if (defined(AGLET_HAS_GLFW) + defined(AGLET_EGL) + defined(AGLET_IOS)) == 1
+#  define AGLET_STATIC_BACKEND 1
+#endif
+// clang-format on
+
+AGLET_BEGIN
+
+// clang-format off
+#if defined(AGLET_STATIC_BACKEND)
+#  if defined(AGLET_HAS_GLFW)
+using GLContextStatic = GLFWContext;
+#  elif defined(AGLET_EGL)
+using GLContextStatic = EGLContextImpl;
+#  elif defined(AGLET_IOS)
+using GLContextStatic = GLContextIOS;
+#  endif
+#endif
+// clang-format on
+
+/*
+ * Run the render loop for a context returned by GLContext::create():
+ *
+ *   aglet::run(*gl, [&]() { return process(); });
+ *
+ * When a single backend is built every context has the same concrete
+ * type, which is selected at compile time (no virtual call, no type
+ * erasure), otherwise this falls back to the virtual render loop.
+ */
+
+template <typename Delegate>
+void run(GLContext& context, Delegate&& f)
+{
+#if defined(AGLET_STATIC_BACKEND)
+    assert(dynamic_cast<GLContextStatic*>(&context));
+    static_cast<GLContextStatic&>(context).run(std::forward<Delegate>(f));
+#else
+    GLContext::RenderDelegate delegate = std::ref(f);
+    context(delegate);
+#endif
+}
+
+AGLET_END
+
+#endif // __aglet_GLContextStatic_h__
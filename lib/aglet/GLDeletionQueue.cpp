@@ -0,0 +1,163 @@
+/*!
+  @file   GLDeletionQueue.cpp
+  @brief  Implementation of a per context queue for deferred deletion of GL objects.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLDeletionQueue.h"
+#include "aglet/GLContext.h"
+#include "aglet/GLError.h"
+#include "aglet/gl_includes.h"
+
+AGLET_BEGIN
+
+struct GLDeletionQueue::Node
+{
+    Kind kind;
+    unsigned int name;
+    GLAllocation allocation;
+    Node* next;
+};
+
+GLDeletionQueue::~GLDeletionQueue()
+{
+    Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void GLDeletionQueue::push(Kind kind, unsigned int name)
+{
+    push(kind, name, GLAllocation());
+}
+
+void GLDeletionQueue::push(Kind kind, unsigned int name, GLAllocation&& allocation)
+{
+    Node* node = new Node{ kind, name, std::move(allocation), nullptr };
+    node->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+std::size_t GLDeletionQueue::drain()
+{
+    if (isEmpty())
+    {
+        return 0; // make current and frame end: one atomic load
+    }
+
+    Node* list = m_head.exchange(nullptr, std::memory_order_acquire);
+    for (Node* node = list; node; node = node->next)
+    {
+        m_names[node->kind].push_back(node->name);
+    }
+
+    std::size_t count = 0;
+    for (int kind = 0; kind < kKindCount; kind++)
+    {
+        auto& names = m_names[kind];
+        if (!names.empty())
+        {
+            destroy(Kind(kind), names.data(), names.size());
+            count += names.size();
+            names.clear();
+        }
+    }
+
+    while (list) // releases the allocations
+    {
+        Node* next = list->next;
+        delete list;
+        list = next;
+    }
+
+    m_deleted += count;
+    return count;
+}
+
+void GLDeletionQueue::destroy(Kind kind, const unsigned int* names, std::size_t count)
+{
+    switch (kind)
+    {
+        case kTexture:
+            glDeleteTextures(GLsizei(count), names);
+            break;
+        case kBuffer:
+            glDeleteBuffers(GLsizei(count), names);
+            break;
+        case kFramebuffer:
+            glDeleteFramebuffers(GLsizei(count), names);
+            break;
+        case kRenderbuffer:
+            glDeleteRenderbuffers(GLsizei(count), names);
+            break;
+        case kProgram:
+            for (std::size_t i = 0; i < count; i++)
+            {
+                glDeleteProgram(names[i]);
+            }
+            break;
+        case kShader:
+            for (std::size_t i = 0; i < count; i++)
+            {
+                glDeleteShader(names[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+GLOwner::GLOwner()
+{
+    if (GLContext* context = GLContext::current())
+    {
+        m_queue = context->m_deletionQueue;
+        m_owned = true;
+    }
+}
+
+void GLOwner::release(GLDeletionQueue::Kind kind, unsigned int name)
+{
+    release(kind, name, GLAllocation());
+}
+
+void GLOwner::release(GLDeletionQueue::Kind kind, unsigned int name, GLAllocation&& allocation)
+{
+    if (!m_owned)
+    {
+        GLDeletionQueue::destroy(kind, &name, 1);
+        return;
+    }
+
+    auto queue = m_queue.lock();
+    if (!queue)
+    {
+        return; // the owning context is gone
+    }
+
+    if (isCurrent())
+    {
+        GLDeletionQueue::destroy(kind, &name, 1);
+    }
+    else
+    {
+        queue->push(kind, name, std::move(allocation));
+    }
+}
+
+bool GLOwner::isCurrent() const
+{
+    const GLContext* context = GLContext::current();
+    return m_owned && context && (context->m_deletionQueue == m_queue.lock());
+}
+
+AGLET_END
@@ -0,0 +1,114 @@
+/*!
+  @file   GLDeletionQueue.h
+  @brief  Declaration of a per context queue for deferred deletion of GL objects.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLDeletionQueue_h__
+#define __aglet_GLDeletionQueue_h__
+
+#include "aglet/aglet.h"
+#include "aglet/GLMemory.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+ * GL objects can only be deleted while their context is current.  The
+ * aglet wrappers (GLTexture, GLBuffer, IPBO, OPBO, GLFrameBufferObject,
+ * GLShader, GLComputeProgram, GLQuad, GLBatch) remember the aglet context
+ * that was current when they were created (GLOwner), and on destruction:
+ *
+ *   - delete the name directly if that context is current on this thread,
+ *   - push the name to the deletion queue of that context otherwise (any
+ *     thread, lock free), the owning thread deletes the queued names in
+ *     one glDelete* call per kind the next time the context is made current
+ *     through aglet and at the end of each GLContextLoop frame,
+ *   - do nothing if the context is gone (its names went with it).
+ *
+ * No context switch is needed to release a wrapper on another thread:
+ *
+ *   std::thread([texture = std::move(texture)]() {}); // deleted by the owner
+ *
+ * The memory charged for a queued object (GLMemory) is released when the
+ * name is actually deleted.  Wrappers created without a current aglet
+ * context delete their names directly, as before.
+ */
+
+AGLET_BEGIN
+
+class GLContext;
+
+class GLDeletionQueue
+{
+public:
+    enum Kind
+    {
+        kTexture,
+        kBuffer,
+        kFramebuffer,
+        kRenderbuffer,
+        kProgram,
+        kShader,
+        kKindCount
+    };
+
+    GLDeletionQueue() = default;
+    ~GLDeletionQueue(); // pending names are dropped (the context is gone)
+
+    GLDeletionQueue(const GLDeletionQueue&) = delete;
+    GLDeletionQueue& operator=(const GLDeletionQueue&) = delete;
+
+    // Queue a name for deletion (any thread), allocation is released on deletion:
+    void push(Kind kind, unsigned int name);
+    void push(Kind kind, unsigned int name, GLAllocation&& allocation);
+
+    // Delete all queued names (owning context current), return the number of names deleted:
+    std::size_t drain();
+
+    bool isEmpty() const { return (m_head.load(std::memory_order_acquire) == nullptr); }
+
+    // Names deleted by drain() so far:
+    std::size_t getDeletedCount() const { return m_deleted; }
+
+    // Delete names of a kind in the current context:
+    static void destroy(Kind kind, const unsigned int* names, std::size_t count);
+
+protected:
+    struct Node;
+
+    std::atomic<Node*> m_head{ nullptr }; // LIFO, multiple producers, one consumer
+    std::array<std::vector<unsigned int>, kKindCount> m_names; // drain() batches
+    std::size_t m_deleted = 0;
+};
+
+/*
+ * Context owning the GL names of a wrapper (the current aglet context at construction):
+ */
+
+class GLOwner
+{
+public:
+    GLOwner();
+
+    // Delete the name now or defer it to the owning context (see above):
+    void release(GLDeletionQueue::Kind kind, unsigned int name);
+    void release(GLDeletionQueue::Kind kind, unsigned int name, GLAllocation&& allocation);
+
+    // True if the owning context is current on this thread:
+    bool isCurrent() const;
+
+protected:
+    std::weak_ptr<GLDeletionQueue> m_queue;
+    bool m_owned = false; // created in an aglet context
+};
+
+AGLET_END
+
+#endif // __aglet_GLDeletionQueue_h__
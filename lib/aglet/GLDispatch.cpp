@@ -0,0 +1,78 @@
+/*!
+  @file   GLDispatch.cpp
+  @brief  Implementation of a per context table of optional OpenGL entry points.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLDispatch.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLContext.h"
+
+AGLET_BEGIN
+
+const GLbitfield GLDispatch::kMapPersistent;
+const GLbitfield GLDispatch::kMapCoherent;
+const GLenum GLDispatch::kCompletionStatus;
+const GLenum GLDispatch::kTimestamp;
+const GLenum GLDispatch::kQueryResult;
+const GLenum GLDispatch::kQueryResultAvailable;
+const GLenum GLDispatch::kGPUDisjoint;
+
+// Resolve the first available name (core or an extension) into entry:
+template <typename Entry>
+static void resolve(const GLContext& context, Entry& entry, bool available, const char* name)
+{
+    if (available && !entry)
+    {
+        entry = reinterpret_cast<Entry>(context.getProcAddress(name));
+    }
+}
+
+GLDispatch::GLDispatch(const GLContext& context, const GLCapabilities& caps)
+{
+    const bool desktop = !caps.isES();
+
+    resolve(context, bufferStorage, desktop && caps.isVersion(4, 4), "glBufferStorage");
+    resolve(context, bufferStorage, caps.has(GLCapabilities::kARB_buffer_storage), "glBufferStorage");
+    resolve(context, bufferStorage, caps.has(GLCapabilities::kEXT_buffer_storage), "glBufferStorageEXT");
+
+    resolve(context, texStorage2D, caps.isES() ? caps.isVersion(3, 0) : caps.isVersion(4, 2), "glTexStorage2D");
+    resolve(context, texStorage2D, caps.has(GLCapabilities::kARB_texture_storage), "glTexStorage2D");
+    resolve(context, texStorage2D, caps.has(GLCapabilities::kEXT_texture_storage), "glTexStorage2DEXT");
+
+    resolve(context, maxShaderCompilerThreads, caps.has(GLCapabilities::kKHR_parallel_shader_compile), "glMaxShaderCompilerThreadsKHR");
+    resolve(context, maxShaderCompilerThreads, caps.has(GLCapabilities::kARB_parallel_shader_compile), "glMaxShaderCompilerThreadsARB");
+
+    // Timer queries, only the EXT entry points of OpenGL ES take 64 bit results:
+    const bool timerQuery = desktop && (caps.isVersion(3, 3) || caps.has(GLCapabilities::kARB_timer_query));
+    const bool disjointQuery = caps.isES() && caps.has(GLCapabilities::kEXT_disjoint_timer_query);
+    if (timerQuery)
+    {
+        resolve(context, genQueries, true, "glGenQueries");
+        resolve(context, deleteQueries, true, "glDeleteQueries");
+        resolve(context, queryCounter, true, "glQueryCounter");
+        resolve(context, getQueryObjectuiv, true, "glGetQueryObjectuiv");
+        resolve(context, getQueryObjectui64v, true, "glGetQueryObjectui64v");
+        resolve(context, getInteger64v, true, "glGetInteger64v");
+    }
+    else if (disjointQuery)
+    {
+        resolve(context, genQueries, true, "glGenQueriesEXT");
+        resolve(context, deleteQueries, true, "glDeleteQueriesEXT");
+        resolve(context, queryCounter, true, "glQueryCounterEXT");
+        resolve(context, getQueryObjectuiv, true, "glGetQueryObjectuivEXT");
+        resolve(context, getQueryObjectui64v, true, "glGetQueryObjectui64vEXT");
+        resolve(context, getInteger64v, caps.isVersion(3, 0), "glGetInteger64v");
+        resolve(context, getInteger64v, true, "glGetInteger64vEXT");
+    }
+
+    if (!hasTimerQuery())
+    {
+        queryCounter = nullptr; // all or nothing
+    }
+}
+
+AGLET_END
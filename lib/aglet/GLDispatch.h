@@ -0,0 +1,93 @@
+/*!
+  @file   GLDispatch.h
+  @brief  Declaration of a per context table of optional OpenGL entry points.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLDispatch_h__
+#define __aglet_GLDispatch_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#include <cstdint>
+
+// clang-format off
+#if defined(GL_APIENTRY)
+#  define AGLET_APIENTRY GL_APIENTRY
+#elif defined(APIENTRY)
+#  define AGLET_APIENTRY APIENTRY
+#else
+#  define AGLET_APIENTRY
+#endif
+// clang-format on
+
+AGLET_BEGIN
+
+class GLCapabilities;
+class GLContext;
+
+/*
+ * aglet links the entry points of its baseline (OpenGL ES 2.0/3.0 or
+ * desktop OpenGL through GL_GLEXT_PROTOTYPES or GLEW), fast paths from
+ * newer versions or extensions are resolved at run time instead:
+ *
+ *   const auto& gl = context->getDispatch(); // context current
+ *   if (gl.hasBufferStorage())
+ *   {
+ *       gl.bufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+ *   }
+ *
+ * The table is filled through GLContext::getProcAddress() (eglGetProcAddress,
+ * glfwGetProcAddress, dlsym on iOS) on the first getDispatch() call of a
+ * context, an entry point is set only if the context's version or extensions
+ * (GLCapabilities.h) provide it, calls go through the pointer without lookups.  Core
+ * and extension variants (i.e., glQueryCounter or glQueryCounterEXT) fill
+ * the same slot.
+ */
+class GLDispatch
+{
+public:
+    // Resolve the entry points of context (must be current) with capabilities caps:
+    GLDispatch(const GLContext& context, const GLCapabilities& caps);
+
+    // GL_ARB_buffer_storage (OpenGL 4.4) or GL_EXT_buffer_storage: immutable, persistently mappable buffers
+    bool hasBufferStorage() const { return bufferStorage != nullptr; }
+
+    // OpenGL ES 3.0, OpenGL 4.2, GL_ARB_texture_storage or GL_EXT_texture_storage: immutable textures
+    bool hasTextureStorage() const { return texStorage2D != nullptr; }
+
+    // GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile: query kCompletionStatus without blocking
+    bool hasParallelCompile() const { return maxShaderCompilerThreads != nullptr; }
+
+    // GL_ARB_timer_query (OpenGL 3.3) or GL_EXT_disjoint_timer_query: GPU timestamps
+    bool hasTimerQuery() const { return genQueries && deleteQueries && queryCounter && getQueryObjectuiv && getQueryObjectui64v && getInteger64v; }
+
+    // Extension tokens (not in all headers):
+    static const GLbitfield kMapPersistent = 0x0040;    // GL_MAP_PERSISTENT_BIT
+    static const GLbitfield kMapCoherent = 0x0080;      // GL_MAP_COHERENT_BIT
+    static const GLenum kCompletionStatus = 0x91B1;     // GL_COMPLETION_STATUS_KHR
+    static const GLenum kTimestamp = 0x8E28;            // GL_TIMESTAMP
+    static const GLenum kQueryResult = 0x8866;          // GL_QUERY_RESULT
+    static const GLenum kQueryResultAvailable = 0x8867; // GL_QUERY_RESULT_AVAILABLE
+    static const GLenum kGPUDisjoint = 0x8FBB;          // GL_GPU_DISJOINT_EXT
+
+    // clang-format off
+    void (AGLET_APIENTRY* bufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) = nullptr;
+    void (AGLET_APIENTRY* texStorage2D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) = nullptr;
+    void (AGLET_APIENTRY* maxShaderCompilerThreads)(GLuint count) = nullptr;
+    void (AGLET_APIENTRY* genQueries)(GLsizei n, GLuint* ids) = nullptr;
+    void (AGLET_APIENTRY* deleteQueries)(GLsizei n, const GLuint* ids) = nullptr;
+    void (AGLET_APIENTRY* queryCounter)(GLuint id, GLenum target) = nullptr;
+    void (AGLET_APIENTRY* getQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params) = nullptr;
+    void (AGLET_APIENTRY* getQueryObjectui64v)(GLuint id, GLenum pname, std::uint64_t* params) = nullptr;
+    void (AGLET_APIENTRY* getInteger64v)(GLenum pname, std::int64_t* data) = nullptr;
+    // clang-format on
+};
+
+AGLET_END
+
+#endif // __aglet_GLDispatch_h__
@@ -0,0 +1,28 @@
+/*!
+  @file   GLError.h
+  @brief  OpenGL error checking utilities.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLError_h__
+#define __aglet_GLError_h__
+
+#include "aglet/aglet.h"
+#include "aglet/aglet_assert.h"
+#include "aglet/gl_includes.h"
+
+AGLET_BEGIN
+
+// Throw AssertionFailureException for pending GL errors, tag is "Class::method() : glCall()"
+inline void checkGLError(const char* tag)
+{
+    const GLenum error = glGetError();
+    throw_assert((error == GL_NO_ERROR), tag << " : GL error " << int(error));
+}
+
+AGLET_END
+
+#endif // __aglet_GLError_h__
@@ -8,6 +8,7 @@
 */
 
 #include "aglet/GLFWContext.h"
+#include "aglet/GLTrace.h"
 #include "aglet/aglet_assert.h"
 #include "aglet/gl_includes.h"
 
@@ -28,7 +29,7 @@ struct GLFWContextPool
 {
     std::recursive_mutex mutex;
 
-    void alloc(GLFWContext* src, const std::string& name, int width, int height)
+    void alloc(GLFWContext* src, const std::string& name, int width, int height, GLContext::GLVersion version)
     {
         std::unique_lock<decltype(mutex)> lock(mutex);
         if (pool.empty())
@@ -42,7 +43,7 @@ struct GLFWContextPool
 	
         glfwSetErrorCallback(GLFWContextError);
 
-        src->alloc(name, width, height);
+        src->alloc(name, width, height, version);
         auto* context = src->getContext();
         if (!context)
         {
@@ -82,13 +83,34 @@ static GLFWContextPool glfwPool;
 
 static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
-void GLFWContext::alloc(const std::string& name, int width, int height)
+void GLFWContext::alloc(const std::string& name, int width, int height, GLVersion version)
 {
+    glfwDefaultWindowHints();
+
     if (name.empty())
     {
         glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     }
 
+    // Compute shader capable contexts must be requested explicitly, other
+    // versions use the default (most compatible) GLFW context:
+    switch (version)
+    {
+        case kGLES31:
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+            break;
+        case kGL43:
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
+            break;
+        default:
+            break;
+    }
+
     m_context = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
     if (!m_context)
     {
@@ -120,20 +142,28 @@ void GLFWContext::alloc(const std::string& name, int width, int height)
     }
 }
 
-GLFWContext::GLFWContext(const std::string& name, int width, int height)
+GLFWContext::GLFWContext(const std::string& name, int width, int height, GLVersion version)
 {
     // forcing centralized allocation ensures proper reference counting
-    glfwPool.alloc(this, name, width, height);
+    glfwPool.alloc(this, name, width, height, version);
 }
 
 GLFWContext::~GLFWContext()
 {
+    releaseObjects();
     glfwPool.erase(this);
 }
 
 void GLFWContext::operator()()
 {
+    AGLET_TRACE_SCOPE("makeCurrent", "context");
     glfwMakeContextCurrent(m_context);
+    setCurrent(this);
+}
+
+auto GLFWContext::getProcAddress(const char* name) const -> ProcAddress
+{
+    return reinterpret_cast<ProcAddress>(glfwGetProcAddress(name));
 }
 
 GLFWContext::operator bool() const
@@ -186,23 +216,46 @@ void GLFWContext::resize(int width, int height)
     glfwSetWindowSize(m_context, width, height);
 }
 
-void GLFWContext::operator()(std::function<bool(void)>& f)
+// ::: swap interval :::
+
+bool GLFWContext::setSwapInterval(int interval)
+{
+    m_swapIntervalRequested = interval;
+    applySwapInterval();
+    return m_swapIntervalHonoured;
+}
+
+void GLFWContext::applySwapInterval()
 {
-    bool okay = true;
-    while (!glfwWindowShouldClose(m_context) && okay)
+    int interval = m_swapIntervalRequested;
+
+    // glfwSwapInterval() acts on the context that is current on this thread
+    glfwMakeContextCurrent(m_context);
+    setCurrent(this);
+
+    if (interval < 0)
     {
-        if (m_wait)
+        // Negative intervals (adaptive sync) require the late swap tear extensions:
+        const bool hasTear = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+        if (!hasTear)
         {
-            glfwWaitEvents();
+            interval = -interval;
         }
-        else
-        {
-            glfwPollEvents();
-        }
-        okay = f(); // <== callback
-        glfwSwapBuffers(m_context);
     }
-    glfwTerminate();
+
+    glfwSwapInterval(interval);
+
+    m_swapInterval = interval;
+    m_swapIntervalHonoured = (interval == m_swapIntervalRequested);
+}
+
+void GLFWContext::operator()(std::function<bool(void)>& f)
+{
+    // Note: The loop may run on a different thread than setSwapInterval(),
+    // so beginLoop() (re)applies the request and records the outcome.
+    // glfwTerminate() is left to GLFWContextPool, which owns the GLFW
+    // reference count for all live contexts.
+    run(f);
 }
 
 void GLFWContext::framebufferSizeCallback(int width, int height)
@@ -221,6 +274,7 @@ void GLFWContext::framebufferSizeCallback(int width, int height)
     m_geometry.ty = hShift;
 
     glfwMakeContextCurrent(m_context);
+    setCurrent(this);
     glViewport(wShift, hShift, std::nearbyint(winWidth), std::nearbyint(winHeight));
 }
 
@@ -11,6 +11,7 @@
 #define __aglet_GLFWContext_h__
 
 #include "aglet/GLContext.h"
+#include "aglet/GLContextLoop.h"
 
 // clang-format off
 #if defined(_WIN32) || defined(_WIN64)
@@ -26,10 +27,10 @@ AGLET_BEGIN
 
 struct GLFWContextPool;
 
-class GLFWContext : public GLContext
+class GLFWContext : public GLContext, public GLContextLoop<GLFWContext>
 {
 public:
-    GLFWContext(const std::string& name = {}, int width = 640, int height = 480);
+    GLFWContext(const std::string& name = {}, int width = 640, int height = 480, GLVersion version = kGL);
     ~GLFWContext();
 
     virtual void operator()();
@@ -44,13 +45,38 @@ public:
     virtual bool hasDisplay() const;
     virtual void resize(int width, int height);
     virtual void operator()(std::function<bool(void)>& f);
+    virtual bool setSwapInterval(int interval);
+    virtual ProcAddress getProcAddress(const char* name) const;
 
     GLFWwindow* getContext() const { return m_context; }
     void framebufferSizeCallback(int width, int height);
 
 protected:
     friend GLFWContextPool;
-    void alloc(const std::string& name = {}, int width = 640, int height = 480);
+    friend GLContextLoop<GLFWContext>;
+
+    // GLContextLoop<> hooks:
+    void beginLoop() { applySwapInterval(); }
+    bool beginFrame()
+    {
+        if (glfwWindowShouldClose(m_context))
+        {
+            return false;
+        }
+        if (m_wait)
+        {
+            glfwWaitEvents();
+        }
+        else
+        {
+            glfwPollEvents();
+        }
+        return true;
+    }
+    void endFrame() { glfwSwapBuffers(m_context); }
+
+    void alloc(const std::string& name = {}, int width = 640, int height = 480, GLVersion version = kGL);
+    void applySwapInterval();
 
     GLFWwindow* m_context = nullptr;
     bool m_visible = false;
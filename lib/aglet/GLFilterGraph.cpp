@@ -0,0 +1,364 @@
+/*!
+  @file   GLFilterGraph.cpp
+  @brief  Implementation of a multi-pass GPGPU filter graph with recycled render targets.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLFilterGraph.h"
+#include "aglet/GLError.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTexture.h"
+#include "aglet/GLTrace.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+AGLET_BEGIN
+
+struct GLFilterGraph::Target
+{
+    Target(int width, int height)
+        : texture(width, height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, nullptr, GLTexture::kImmutable)
+    {
+        fbo.bind();
+        fbo.attach(texture);
+        fbo.unbind();
+    }
+
+    GLTexture texture;
+    GLFrameBufferObject fbo;
+};
+
+GLFilterGraph::GLFilterGraph(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+}
+
+GLFilterGraph::~GLFilterGraph() = default;
+
+const char* GLFilterGraph::getVertexShader()
+{
+    return GLQuad::getVertexShader();
+}
+
+auto GLFilterGraph::input(GLuint texture) -> Node
+{
+    Pass pass;
+    pass.kind = kInput;
+    pass.texture = texture;
+    m_passes.push_back(pass);
+    m_dirty = true;
+    return Node(m_passes.size() - 1);
+}
+
+auto GLFilterGraph::pass(const std::string& fshSrc, const std::vector<Node>& inputs, const UniformDelegate& uniforms) -> Node
+{
+    throw_assert(!fshSrc.empty(), "GLFilterGraph::pass() : empty fragment shader");
+    for (const auto& node : inputs)
+    {
+        throw_assert((node >= 0) && (node < Node(m_passes.size())), "GLFilterGraph::pass() : invalid input node " << node);
+    }
+
+    Pass pass;
+    pass.kind = kShader;
+    pass.fshSrc = fshSrc;
+    pass.inputs = inputs;
+    pass.uniforms = uniforms;
+    m_passes.push_back(pass);
+    m_dirty = true;
+    return Node(m_passes.size() - 1);
+}
+
+auto GLFilterGraph::elementwise(const std::string& stageSrc, Node input, const Params& params) -> Node
+{
+    throw_assert(!stageSrc.empty(), "GLFilterGraph::elementwise() : empty stage");
+    throw_assert((input >= 0) && (input < Node(m_passes.size())), "GLFilterGraph::elementwise() : invalid input node " << input);
+
+    Pass pass;
+    pass.kind = kElementwise;
+    pass.fshSrc = stageSrc;
+    pass.inputs = { input };
+    pass.params = params;
+    m_passes.push_back(pass);
+    m_dirty = true;
+    return Node(m_passes.size() - 1);
+}
+
+void GLFilterGraph::setParams(Node node, const Params& params)
+{
+    throw_assert((node >= 0) && (node < Node(m_passes.size())), "GLFilterGraph::setParams() : invalid node " << node);
+    throw_assert((m_passes[node].kind == kElementwise), "GLFilterGraph::setParams() : node is not elementwise");
+    m_passes[node].params = params; // no recompilation needed
+}
+
+void GLFilterGraph::setFusion(bool flag)
+{
+    m_dirty |= (m_fusion != flag);
+    m_fusion = flag;
+}
+
+void GLFilterGraph::output(Node node)
+{
+    throw_assert((node >= 0) && (node < Node(m_passes.size())), "GLFilterGraph::output() : invalid node " << node);
+    throw_assert(!isInput(m_passes[node]), "GLFilterGraph::output() : output must be a pass");
+    m_output = node;
+    m_dirty = true;
+}
+
+std::size_t GLFilterGraph::getPassCount() const
+{
+    return std::count_if(m_passes.begin(), m_passes.end(), [&](const Pass& pass) { return isDrawn(pass); });
+}
+
+GLuint GLFilterGraph::getTexture(Node node) const
+{
+    const auto& pass = m_passes[node];
+    return isInput(pass) ? pass.texture : GLuint(m_targets[pass.target]->texture);
+}
+
+std::shared_ptr<GLShader> GLFilterGraph::getProgram(const std::string& fshSrc)
+{
+    auto& shader = m_programs[fshSrc];
+    if (!shader)
+    {
+        shader = std::make_shared<GLShader>();
+        auto status = shader->buildFromSrc(GLQuad::getVertexShader(), fshSrc.c_str(), GLQuad::getAttributes());
+        throw_assert(status, "GLFilterGraph::getProgram() : GLShader::buildFromSrc()");
+    }
+    return shader;
+}
+
+// Generate the program for a chain of elementwise stages, the source is the
+// stage signature used as the program cache key:
+std::string GLFilterGraph::generate(const std::vector<Node>& chain) const
+{
+    std::stringstream ss;
+    ss << "#ifdef GL_ES\n"
+       << "precision highp float;\n"
+       << "#endif\n"
+       << "varying vec2 vTexCoord;\n"
+       << "uniform sampler2D uInputTex;\n";
+    for (std::size_t k = 0; k < chain.size(); k++)
+    {
+        ss << "uniform vec4 uParams" << k << ";\n"
+           << "#define process aglet_stage" << k << "\n"
+           << m_passes[chain[k]].fshSrc << "\n"
+           << "#undef process\n";
+    }
+    ss << "void main() {\n"
+       << "    vec4 color = texture2D(uInputTex, vTexCoord);\n";
+    for (std::size_t k = 0; k < chain.size(); k++)
+    {
+        ss << "    color = aglet_stage" << k << "(color, uParams" << k << ");\n";
+    }
+    ss << "    gl_FragColor = color;\n"
+       << "}\n";
+    return ss.str();
+}
+
+void GLFilterGraph::compile()
+{
+    throw_assert(m_output >= 0, "GLFilterGraph::compile() : no output node");
+
+    // Mark passes that contribute to the output (reverse topological order):
+    for (auto& pass : m_passes)
+    {
+        pass.live = false;
+        pass.fused = false;
+        pass.consumers = 0;
+        pass.lastUse = -1;
+        pass.target = -1;
+        pass.sources = pass.inputs;
+        pass.chain.clear();
+    }
+    m_passes[m_output].live = true;
+    for (int i = m_output; i >= 0; i--)
+    {
+        if (m_passes[i].live)
+        {
+            for (const auto& node : m_passes[i].inputs)
+            {
+                m_passes[node].live = true;
+                m_passes[node].consumers++;
+            }
+        }
+    }
+
+    // Elementwise chains: a stage whose predecessor is an elementwise stage
+    // with no other consumer absorbs the predecessor's chain and source:
+    for (int i = 0; i < int(m_passes.size()); i++)
+    {
+        auto& pass = m_passes[i];
+        if (!pass.live || (pass.kind != kElementwise))
+        {
+            continue;
+        }
+
+        pass.chain = { i };
+        auto& source = m_passes[pass.inputs.front()];
+        if (m_fusion && (source.kind == kElementwise) && (source.consumers == 1) && (pass.inputs.front() != m_output))
+        {
+            source.fused = true;
+            pass.chain.insert(pass.chain.begin(), source.chain.begin(), source.chain.end());
+            pass.sources = source.sources;
+        }
+    }
+
+    // Lifetime analysis: allocate the output before releasing the inputs, so a
+    // pass never renders to a texture it samples from:
+    m_passes[m_output].lastUse = std::numeric_limits<int>::max();
+    for (int i = 0; i < int(m_passes.size()); i++)
+    {
+        if (isDrawn(m_passes[i]))
+        {
+            for (const auto& node : m_passes[i].sources)
+            {
+                m_passes[node].lastUse = std::max(m_passes[node].lastUse, i);
+            }
+        }
+    }
+
+    std::vector<int> available;
+    int targetCount = 0;
+    for (int i = 0; i < int(m_passes.size()); i++)
+    {
+        auto& pass = m_passes[i];
+        if (!isDrawn(pass))
+        {
+            continue;
+        }
+
+        if (available.empty())
+        {
+            pass.target = targetCount++;
+        }
+        else
+        {
+            pass.target = available.back();
+            available.pop_back();
+        }
+
+        std::vector<Node> sources = pass.sources;
+        std::sort(sources.begin(), sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+        for (const auto& node : sources)
+        {
+            const auto& source = m_passes[node];
+            if (!isInput(source) && (source.lastUse == i))
+            {
+                available.push_back(source.target);
+            }
+        }
+    }
+
+    m_targets.clear();
+    for (int i = 0; i < targetCount; i++)
+    {
+        m_targets.emplace_back(new Target(m_width, m_height));
+    }
+
+    // Compile shaders (passes with identical sources share a program):
+    for (auto& pass : m_passes)
+    {
+        if (!isDrawn(pass))
+        {
+            continue;
+        }
+
+        pass.shader = getProgram((pass.kind == kElementwise) ? generate(pass.chain) : pass.fshSrc);
+
+        // Sampler bindings are program state, assign texture units once:
+        const GLuint program = pass.shader->getProgramId();
+        glUseProgram(program);
+        for (std::size_t k = 0; k < pass.sources.size(); k++)
+        {
+            std::stringstream name;
+            name << "uInputTex";
+            if (k > 0)
+            {
+                name << k;
+            }
+            glUniform1i(glGetUniformLocation(program, name.str().c_str()), GLint(k));
+        }
+
+        pass.locations.clear();
+        for (std::size_t k = 0; k < pass.chain.size(); k++)
+        {
+            std::stringstream name;
+            name << "uParams" << k;
+            pass.locations.push_back(glGetUniformLocation(program, name.str().c_str()));
+        }
+    }
+    glUseProgram(0);
+
+    checkGLError("GLFilterGraph::compile() : glUniform1i()");
+    m_dirty = false;
+}
+
+GLuint GLFilterGraph::operator()()
+{
+    AGLET_TRACE_GPU_SCOPE("GLFilterGraph", "filter");
+    if (m_dirty)
+    {
+        compile();
+    }
+
+    glViewport(0, 0, m_width, m_height);
+
+    m_quad.bind();
+
+    for (auto& pass : m_passes)
+    {
+        if (!isDrawn(pass))
+        {
+            continue;
+        }
+
+        m_targets[pass.target]->fbo.bind();
+        pass.shader->use();
+        for (std::size_t k = 0; k < pass.sources.size(); k++)
+        {
+            glActiveTexture(GL_TEXTURE0 + GLenum(k));
+            glBindTexture(GL_TEXTURE_2D, getTexture(pass.sources[k]));
+        }
+
+        for (std::size_t k = 0; k < pass.chain.size(); k++)
+        {
+            glUniform4fv(pass.locations[k], 1, m_passes[pass.chain[k]].params.data());
+        }
+
+        if (pass.uniforms)
+        {
+            pass.uniforms(*pass.shader);
+        }
+
+        m_quad.draw();
+    }
+
+    m_quad.unbind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    checkGLError("GLFilterGraph::operator()() : glDrawArrays()");
+
+    return getTexture(m_output);
+}
+
+void GLFilterGraph::read(GLubyte* pixels)
+{
+    throw_assert(!m_dirty, "GLFilterGraph::read() : graph has not been executed");
+
+    auto& target = *m_targets[m_passes[m_output].target];
+    target.fbo.bind();
+    target.texture.read(pixels);
+    target.fbo.unbind();
+}
+
+AGLET_END
@@ -0,0 +1,166 @@
+/*!
+  @file   GLFilterGraph.h
+  @brief  Declaration of a multi-pass GPGPU filter graph with recycled render targets.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLFilterGraph_h__
+#define __aglet_GLFilterGraph_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLQuad.h"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+AGLET_BEGIN
+
+class GLShader;
+class GLTexture;
+class GLFrameBufferObject;
+
+/*
+ * Graph of full screen fragment shader passes executed in the current context:
+ *
+ *   aglet::GLFilterGraph graph(width, height);
+ *   auto src = graph.input(texture);
+ *   auto luv = graph.pass(fshaderRgb2LuvSrc, { src });
+ *   auto out = graph.pass(fshaderBlurSrc, { luv });
+ *   graph.output(out);
+ *   graph();            // one FBO bind + draw per live pass
+ *   graph.read(pixels); // one readback
+ *
+ * Fragment shaders receive the interpolated "varying vec2 vTexCoord" and
+ * sample their inputs through "uniform sampler2D uInputTex", "uInputTex1",
+ * "uInputTex2", ... in the order given to pass().  Nodes may only consume
+ * nodes created before them, so insertion order is a topological order.
+ *
+ * Intermediate RGBA render targets are assigned by lifetime analysis: a
+ * target returns to the pool after the last pass that reads it, so a
+ * linear chain of any length ping-pongs between two textures.  Passes
+ * that do not contribute to the output are skipped.
+ *
+ * Elementwise stages only map a color to a color.  Each stage source
+ * defines "vec4 process(vec4 color, vec4 params)", where params is set
+ * per stage through elementwise() or setParams():
+ *
+ *   auto gain = graph.elementwise("vec4 process(vec4 c, vec4 p) { return c * p.x; }", luv, { { 2.f } });
+ *
+ * With setFusion(true), a chain of elementwise stages where each stage is
+ * the only consumer of its predecessor is concatenated into a single
+ * generated program, so the chain costs one full screen write instead of
+ * one per stage.  Generated programs are cached by their stage signature.
+ * Stage sources are concatenated as is (process is renamed per stage),
+ * so other global declarations must have names unique to the stage.
+ */
+
+class GLFilterGraph
+{
+public:
+    using Node = int;
+    using Params = std::array<GLfloat, 4>;
+    using UniformDelegate = std::function<void(GLShader& shader)>;
+
+    GLFilterGraph(int width, int height);
+    ~GLFilterGraph();
+
+    // Add an external RGBA texture of size width x height (not owned):
+    Node input(GLuint texture);
+
+    // Add a fragment shader pass, the optional delegate sets custom uniforms
+    // each time the pass is executed (program is in use):
+    Node pass(const std::string& fshSrc, const std::vector<Node>& inputs, const UniformDelegate& uniforms = {});
+
+    // Add an elementwise stage (see above) applied to input:
+    Node elementwise(const std::string& stageSrc, Node input, const Params& params = {});
+
+    // Update the params of an elementwise stage (e.g., per frame):
+    void setParams(Node node, const Params& params);
+
+    // Fuse chains of elementwise stages into single passes:
+    void setFusion(bool flag);
+    bool getFusion() const { return m_fusion; }
+
+    // Select the node that is rendered to the output texture:
+    void output(Node node);
+
+    // Execute all live passes, return the output texture:
+    GLuint operator()();
+
+    // Read the output (RGBA) after operator()():
+    void read(GLubyte* pixels);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    // Number of render targets allocated by the lifetime analysis:
+    std::size_t getTargetCount() const { return m_targets.size(); }
+
+    // Number of passes (draws) per execution after dead pass elimination and fusion:
+    std::size_t getPassCount() const;
+
+    // Common vertex shader for all passes (aPos, aTexCoord -> vTexCoord):
+    static const char* getVertexShader();
+
+protected:
+    struct Target;
+
+    enum Kind
+    {
+        kInput,
+        kShader,
+        kElementwise
+    };
+
+    struct Pass
+    {
+        Kind kind = kInput;
+        GLuint texture = 0;  // kInput: external texture
+        std::string fshSrc;  // kShader: fragment shader, kElementwise: stage
+        std::vector<Node> inputs;
+        UniformDelegate uniforms;
+        Params params = {};  // kElementwise: stage params
+
+        // compile() state:
+        std::vector<Node> sources; // textures sampled by the draw
+        std::vector<Node> chain;   // kElementwise: stages applied by the draw
+        std::shared_ptr<GLShader> shader;
+        std::vector<GLint> locations; // kElementwise: uParams<k>
+        int target = -1;    // render target index (passes)
+        int lastUse = -1;   // index of the last pass reading this node
+        int consumers = 0;  // number of live passes reading this node
+        bool live = false;  // contributes to the output
+        bool fused = false; // kElementwise: applied by a later pass
+    };
+
+    bool isInput(const Pass& pass) const { return (pass.kind == kInput); }
+    bool isDrawn(const Pass& pass) const { return pass.live && !pass.fused && !isInput(pass); }
+    GLuint getTexture(Node node) const;
+    std::shared_ptr<GLShader> getProgram(const std::string& fshSrc);
+    std::string generate(const std::vector<Node>& chain) const;
+
+    void compile(); // lifetime analysis + shader compilation
+
+    int m_width = 0;
+    int m_height = 0;
+    Node m_output = -1;
+    bool m_dirty = true;
+    bool m_fusion = false;
+
+    std::vector<Pass> m_passes;
+    std::vector<std::unique_ptr<Target>> m_targets;
+    std::map<std::string, std::shared_ptr<GLShader>> m_programs; // by source
+    GLQuad m_quad;
+};
+
+AGLET_END
+
+#endif // __aglet_GLFilterGraph_h__
@@ -0,0 +1,50 @@
+/*!
+  @file   GLFrameBufferObject.cpp
+  @brief  Implementation of a minimal OpenGL framebuffer object wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+
+AGLET_BEGIN
+
+GLFrameBufferObject::GLFrameBufferObject()
+{
+    id = GLNamePool::generate(GLNamePool::kFramebuffer);
+    checkGLError("GLFrameBufferObject::GLFrameBufferObject() : glGenFramebuffers()");
+}
+
+GLFrameBufferObject::~GLFrameBufferObject()
+{
+    if (id > 0)
+    {
+        owner.release(GLDeletionQueue::kFramebuffer, id);
+        id = 0;
+    }
+}
+
+void GLFrameBufferObject::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, id);
+}
+
+void GLFrameBufferObject::unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GLFrameBufferObject::attach(GLuint texId, GLenum attachment, GLenum target, GLint level)
+{
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, target, texId, level);
+    checkGLError("GLFrameBufferObject::attach() : glFramebufferTexture2D()");
+
+    const GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    throw_assert((fboStatus == GL_FRAMEBUFFER_COMPLETE), "GLFrameBufferObject::attach() : incomplete framebuffer " << int(fboStatus));
+}
+
+AGLET_END
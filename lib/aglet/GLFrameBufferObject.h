@@ -0,0 +1,47 @@
+/*!
+  @file   GLFrameBufferObject.h
+  @brief  Declaration of a minimal OpenGL framebuffer object wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLFrameBufferObject_h__
+#define __aglet_GLFrameBufferObject_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLDeletionQueue.h"
+
+AGLET_BEGIN
+
+class GLFrameBufferObject
+{
+public:
+    GLFrameBufferObject();
+    ~GLFrameBufferObject();
+
+    GLFrameBufferObject(const GLFrameBufferObject&) = delete;
+    GLFrameBufferObject& operator=(const GLFrameBufferObject&) = delete;
+
+    void bind();
+    void unbind();
+
+    // Attach texture (FBO must be bound), throws if the FBO is incomplete,
+    // note OpenGL ES 2.0 only supports level 0:
+    void attach(GLuint texId, GLenum attachment = GL_COLOR_ATTACHMENT0, GLenum target = GL_TEXTURE_2D, GLint level = 0);
+
+    operator GLuint() const
+    {
+        return id;
+    }
+
+protected:
+    GLuint id = 0;
+    GLOwner owner;
+};
+
+AGLET_END
+
+#endif // __aglet_GLFrameBufferObject_h__
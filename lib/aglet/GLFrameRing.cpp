@@ -0,0 +1,131 @@
+/*!
+  @file   GLFrameRing.cpp
+  @brief  Implementation of a frame readback producer for a shared memory frame ring.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLFrameRing.h"
+
+#if defined(AGLET_HAS_POSIX)
+
+#include "aglet/GLError.h"
+#include "aglet/GLPBO.h"
+#include "aglet/GLTexture.h"
+
+#include <algorithm>
+#include <climits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+AGLET_BEGIN
+
+GLFrameRing::GLFrameRing(const std::string& name, int width, int height, std::size_t slots, std::size_t depth, GLenum format, GLenum type)
+    : m_width(width)
+    , m_height(height)
+    , m_format(format)
+    , m_type(type)
+    , m_ring(name, std::uint32_t(std::max(width, 0)), std::uint32_t(std::max(height, 0)), format, type, std::uint32_t(getPixelSize(format, type)), slots)
+{
+    throw_assert(depth > 0, "GLFrameRing::GLFrameRing() : invalid depth");
+
+#if defined(AGLET_HAS_PBO)
+    for (std::size_t i = 0; i < depth; i++)
+    {
+        m_pbos.emplace_back(new IPBO(width, height, format, type));
+    }
+#endif
+}
+
+GLFrameRing::~GLFrameRing()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // Pending frames are not published, the ring is still consistent
+    }
+}
+
+GLubyte* GLFrameRing::begin(std::uint64_t frame)
+{
+    const std::size_t slot = std::size_t(frame % m_ring.getHeader().slotCount);
+    m_ring.getSlot(slot).sequence.store(frame * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // odd sequence before the data
+    return m_ring.getData(slot);
+}
+
+void GLFrameRing::publish(std::uint64_t frame, std::uint64_t timestamp)
+{
+    auto& header = m_ring.getHeader();
+    auto& slot = m_ring.getSlot(std::size_t(frame % header.slotCount));
+    slot.frame = frame;
+    slot.timestamp = timestamp;
+    slot.sequence.store(frame * 2 + 2, std::memory_order_release);
+    header.count.store(frame + 1, std::memory_order_release);
+
+    header.futex.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    // Shared (not FUTEX_PRIVATE) wake, the waiters are in other processes:
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header.futex), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void GLFrameRing::operator()(std::uint64_t timestamp)
+{
+    const std::uint64_t frame = m_next++;
+
+#if defined(AGLET_HAS_PBO)
+    if (m_pending.size() == m_pbos.size())
+    {
+        finish();
+    }
+
+    const std::size_t pbo = std::size_t(frame % m_pbos.size());
+    m_pbos[pbo]->bind();
+    m_pbos[pbo]->start();
+    m_pbos[pbo]->unbind();
+    m_pending.push_back({ pbo, frame, timestamp });
+#else
+    readPixels(0, 0, m_width, m_height, begin(frame), 0, m_format, m_type);
+    publish(frame, timestamp);
+#endif
+}
+
+#if defined(AGLET_HAS_PBO)
+void GLFrameRing::finish()
+{
+    const Pending pending = m_pending.front();
+    m_pending.pop_front();
+
+    // Only the copy from the mapped PBO is inside the slot's write window:
+    auto& pbo = *m_pbos[pending.pbo];
+    pbo.bind();
+    pbo.finish(begin(pending.frame)); // mapped PBO -> shared memory
+    pbo.unbind();
+
+    publish(pending.frame, pending.timestamp);
+}
+#endif
+
+void GLFrameRing::flush()
+{
+#if defined(AGLET_HAS_PBO)
+    while (!m_pending.empty())
+    {
+        finish();
+    }
+#endif
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
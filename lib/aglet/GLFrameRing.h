@@ -0,0 +1,103 @@
+/*!
+  @file   GLFrameRing.h
+  @brief  Declaration of a frame readback producer for a shared memory frame ring.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLFrameRing_h__
+#define __aglet_GLFrameRing_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#if defined(AGLET_HAS_POSIX) // shared memory
+
+#include "aglet/FrameRing.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+AGLET_BEGIN
+
+class IPBO;
+
+/*
+ * Publish frames read from the bound framebuffer to other processes through
+ * a shared memory FrameRing (see FrameRing.h for the layout and protocol):
+ *
+ *   aglet::GLFrameRing ring("/camera", width, height); // shm_open("/camera")
+ *   while (render())
+ *   {
+ *       ring(timestamp); // reads the bound framebuffer
+ *   }
+ *
+ * Consumers open the same name with aglet::FrameRingConsumer (no OpenGL
+ * needed) and use frames in place.  Readbacks go through a ring of depth
+ * PBOs as in GLFrameSink: a frame is copied from the mapped PBO into its
+ * shared memory slot and published depth - 1 frames later (without PBOs,
+ * on OpenGL ES 2.0, glReadPixels writes into the slot directly).  The
+ * producer never waits for consumers: slow consumers skip frames, and
+ * FrameRingConsumer::isValid() tells them when a slot was overwritten.
+ */
+
+class GLFrameRing
+{
+public:
+    // Create (replace) the shared memory ring name with slots frames, throws on failure:
+    GLFrameRing(const std::string& name, int width, int height, std::size_t slots = 4, std::size_t depth = 2, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+    // Publish pending frames and unlink the ring (mapped consumers are unaffected):
+    ~GLFrameRing();
+
+    GLFrameRing(const GLFrameRing&) = delete;
+    GLFrameRing& operator=(const GLFrameRing&) = delete;
+
+    // Read the bound framebuffer into the next slot:
+    void operator()(std::uint64_t timestamp = 0);
+
+    // Complete and publish pending readbacks:
+    void flush();
+
+    // Number of frames read (including pending readbacks):
+    std::uint64_t getCount() const { return m_next; }
+
+    const std::string& getName() const { return m_ring.getName(); }
+
+protected:
+    struct Pending
+    {
+        std::size_t pbo;
+        std::uint64_t frame;
+        std::uint64_t timestamp;
+    };
+
+    GLubyte* begin(std::uint64_t frame);                        // mark the slot as being written
+    void publish(std::uint64_t frame, std::uint64_t timestamp); // complete the slot + wake consumers
+
+    int m_width = 0;
+    int m_height = 0;
+    GLenum m_format = GL_RGBA;
+    GLenum m_type = GL_UNSIGNED_BYTE;
+    std::uint64_t m_next = 0;
+
+    FrameRing m_ring;
+
+#if defined(AGLET_HAS_PBO)
+    void finish(); // oldest pending readback
+
+    std::vector<std::unique_ptr<IPBO>> m_pbos;
+    std::deque<Pending> m_pending;
+#endif
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
+
+#endif // __aglet_GLFrameRing_h__
@@ -0,0 +1,322 @@
+/*!
+  @file   GLFrameSink.cpp
+  @brief  Implementation of a memory mapped file sink for continuous frame readback.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLFrameSink.h"
+
+#if defined(AGLET_HAS_POSIX)
+
+#include "aglet/GLError.h"
+#include "aglet/GLPBO.h"
+#include "aglet/GLTexture.h"
+#include "aglet/GLTrace.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AGLET_BEGIN
+
+static const char kMagic[8] = { 'A', 'G', 'L', 'E', 'T', 'F', 'R', 'M' };
+
+static std::size_t alignToPage(std::size_t size)
+{
+    const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    return ((size + page - 1) / page) * page;
+}
+
+GLFrameSink::GLFrameSink(const std::string& filename, int width, int height, std::size_t capacity, std::size_t depth, GLenum format, GLenum type)
+    : m_width(width)
+    , m_height(height)
+    , m_format(format)
+    , m_type(type)
+    , m_capacity(capacity)
+{
+    throw_assert((width > 0) && (height > 0) && (capacity > 0) && (depth > 0), "GLFrameSink::GLFrameSink() : invalid size");
+
+    const std::size_t pixelSize = getPixelSize(format, type);
+    const std::size_t frameSize = std::size_t(width) * std::size_t(height) * pixelSize;
+    const std::size_t slotSize = alignToPage(frameSize);
+    const std::size_t dataOffset = alignToPage(sizeof(GLFrameFileHeader) + capacity * sizeof(GLFrameFileEntry));
+    m_size = dataOffset + capacity * slotSize;
+
+    m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    throw_assert(m_fd >= 0, "GLFrameSink::GLFrameSink() : open() " << filename << " : " << std::strerror(errno));
+
+#if defined(__linux__)
+    // Reserve the blocks now, a full disk would otherwise raise SIGBUS on a mapped write:
+    const int status = posix_fallocate(m_fd, 0, off_t(m_size));
+#else
+    const int status = ftruncate(m_fd, off_t(m_size)) ? errno : 0;
+#endif
+    if (status != 0)
+    {
+        close(m_fd);
+        throw_assert(false, "GLFrameSink::GLFrameSink() : allocation of " << m_size << " bytes : " << std::strerror(status));
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(m_fd);
+        throw_assert(false, "GLFrameSink::GLFrameSink() : mmap() : " << std::strerror(errno));
+    }
+
+    m_data = static_cast<GLubyte*>(data);
+    m_header = reinterpret_cast<GLFrameFileHeader*>(m_data);
+    m_entries = reinterpret_cast<GLFrameFileEntry*>(m_data + sizeof(GLFrameFileHeader));
+
+    std::memcpy(m_header->magic, kMagic, sizeof(kMagic));
+    m_header->version = 1;
+    m_header->width = std::uint32_t(width);
+    m_header->height = std::uint32_t(height);
+    m_header->format = std::uint32_t(format);
+    m_header->type = std::uint32_t(type);
+    m_header->pixelSize = std::uint32_t(pixelSize);
+    m_header->frameSize = frameSize;
+    m_header->slotSize = slotSize;
+    m_header->capacity = capacity;
+    m_header->count = 0;
+    m_header->dataOffset = dataOffset;
+
+    try
+    {
+#if defined(AGLET_HAS_PBO)
+        for (std::size_t i = 0; i < depth; i++)
+        {
+            m_pbos.emplace_back(new IPBO(width, height, format, type));
+        }
+#endif
+
+        m_thread = std::thread([this]() { sync(); });
+    }
+    catch (...)
+    {
+        munmap(m_data, m_size);
+        close(m_fd);
+        throw;
+    }
+}
+
+GLFrameSink::~GLFrameSink()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // Frames with pending readbacks are not counted, the file is still valid
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+
+    msync(m_data, m_size, MS_SYNC);
+    munmap(m_data, m_size);
+    close(m_fd);
+}
+
+GLubyte* GLFrameSink::getSlot(std::size_t slot) const
+{
+    return m_data + m_header->dataOffset + slot * m_header->slotSize;
+}
+
+bool GLFrameSink::operator()(std::uint64_t timestamp)
+{
+    if (m_next >= m_capacity)
+    {
+        return false;
+    }
+
+    const std::size_t slot = m_next++;
+
+#if defined(AGLET_HAS_PBO)
+    if (m_pending.size() == m_pbos.size())
+    {
+        finish();
+    }
+
+    // The PBO of slot - depth has been finished above:
+    const std::size_t pbo = slot % m_pbos.size();
+    m_pbos[pbo]->bind();
+    m_pbos[pbo]->start();
+    m_pbos[pbo]->unbind();
+    m_pending.push_back({ pbo, slot, timestamp });
+#else
+    readPixels(0, 0, m_width, m_height, getSlot(slot), 0, m_format, m_type);
+    commit(slot, timestamp);
+#endif
+
+    return true;
+}
+
+#if defined(AGLET_HAS_PBO)
+void GLFrameSink::finish()
+{
+    const Pending pending = m_pending.front();
+    m_pending.pop_front();
+
+    auto& pbo = *m_pbos[pending.pbo];
+    pbo.bind();
+    pbo.finish(getSlot(pending.slot)); // mapped PBO -> mapped file
+    pbo.unbind();
+
+    commit(pending.slot, pending.timestamp);
+}
+#endif
+
+void GLFrameSink::commit(std::size_t slot, std::uint64_t timestamp)
+{
+    m_entries[slot].offset = m_header->dataOffset + slot * m_header->slotSize;
+    m_entries[slot].timestamp = timestamp;
+    m_header->count = slot + 1; // slots complete in order
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(slot);
+    }
+    m_cv.notify_all();
+}
+
+void GLFrameSink::sync()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty())
+        {
+            break; // m_stop
+        }
+
+        const std::size_t slot = m_queue.front();
+        m_queue.pop_front();
+        m_syncing++;
+        lock.unlock();
+
+        // Write the slot back, then drop its pages from this process:
+        GLubyte* data = getSlot(slot);
+        msync(data, std::size_t(m_header->slotSize), MS_SYNC);
+        madvise(data, std::size_t(m_header->slotSize), MADV_DONTNEED);
+
+        lock.lock();
+        m_syncing--;
+        m_cv.notify_all();
+    }
+}
+
+void GLFrameSink::flush()
+{
+    AGLET_TRACE_SCOPE("GLFrameSink::flush", "wait");
+#if defined(AGLET_HAS_PBO)
+    while (!m_pending.empty())
+    {
+        finish();
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return m_queue.empty() && (m_syncing == 0); });
+    lock.unlock();
+
+    msync(m_data, std::size_t(m_header->dataOffset), MS_SYNC); // header + index
+}
+
+GLFrameFile::GLFrameFile(const std::string& filename)
+{
+    m_fd = open(filename.c_str(), O_RDONLY);
+    throw_assert(m_fd >= 0, "GLFrameFile::GLFrameFile() : open() " << filename << " : " << std::strerror(errno));
+
+    struct stat info;
+    if ((fstat(m_fd, &info) != 0) || (std::size_t(info.st_size) < sizeof(GLFrameFileHeader)))
+    {
+        close(m_fd);
+        throw_assert(false, "GLFrameFile::GLFrameFile() : invalid file " << filename);
+    }
+
+    m_size = std::size_t(info.st_size);
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(m_fd);
+        throw_assert(false, "GLFrameFile::GLFrameFile() : mmap() : " << std::strerror(errno));
+    }
+
+    m_data = static_cast<const GLubyte*>(data);
+    m_header = reinterpret_cast<const GLFrameFileHeader*>(m_data);
+    m_entries = reinterpret_cast<const GLFrameFileEntry*>(m_data + sizeof(GLFrameFileHeader));
+
+    if (!isValid())
+    {
+        munmap(const_cast<GLubyte*>(m_data), m_size);
+        close(m_fd);
+        throw_assert(false, "GLFrameFile::GLFrameFile() : not a frame file " << filename);
+    }
+}
+
+bool GLFrameFile::isValid() const
+{
+    // Overflow safe: every size is checked against the remaining bytes of the file
+    const GLFrameFileHeader& header = *m_header;
+    if ((std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) || (header.version != 1))
+    {
+        return false;
+    }
+    if ((header.dataOffset < sizeof(GLFrameFileHeader)) || (header.dataOffset > m_size) || (header.slotSize == 0) || (header.frameSize > header.slotSize))
+    {
+        return false;
+    }
+
+    const std::uint64_t entries = (header.dataOffset - sizeof(GLFrameFileHeader)) / sizeof(GLFrameFileEntry); // index room
+    const std::uint64_t slots = (m_size - header.dataOffset) / header.slotSize;
+    if ((header.capacity > entries) || (header.capacity > slots) || (header.count > header.capacity))
+    {
+        return false;
+    }
+
+    for (std::uint64_t i = 0; i < header.count; i++)
+    {
+        const std::uint64_t offset = m_entries[i].offset;
+        if ((offset < header.dataOffset) || (offset > m_size) || (header.slotSize > (m_size - offset)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+GLFrameFile::~GLFrameFile()
+{
+    munmap(const_cast<GLubyte*>(m_data), m_size);
+    close(m_fd);
+}
+
+const GLubyte* GLFrameFile::getFrame(std::size_t index) const
+{
+    throw_assert(index < getCount(), "GLFrameFile::getFrame() : invalid index " << index);
+    return m_data + m_entries[index].offset;
+}
+
+std::uint64_t GLFrameFile::getTimestamp(std::size_t index) const
+{
+    throw_assert(index < getCount(), "GLFrameFile::getTimestamp() : invalid index " << index);
+    return m_entries[index].timestamp;
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
@@ -0,0 +1,176 @@
+/*!
+  @file   GLFrameSink.h
+  @brief  Declaration of a memory mapped file sink for continuous frame readback.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLFrameSink_h__
+#define __aglet_GLFrameSink_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#if defined(AGLET_HAS_POSIX) // mmap
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+AGLET_BEGIN
+
+class IPBO;
+
+/*
+ * Frame file layout: a header and an index of capacity entries, padded to
+ * the page size, followed by capacity page aligned frame slots of slotSize
+ * bytes.  Frames are stored as read by glReadPixels (rows bottom up).
+ */
+
+struct GLFrameFileHeader
+{
+    char magic[8];           // "AGLETFRM"
+    std::uint32_t version;   // 1
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t format;    // GL_RGBA, ...
+    std::uint32_t type;      // GL_UNSIGNED_BYTE, ...
+    std::uint32_t pixelSize; // bytes
+    std::uint64_t frameSize; // width * height * pixelSize
+    std::uint64_t slotSize;  // frameSize rounded up to the page size
+    std::uint64_t capacity;  // number of slots
+    std::uint64_t count;     // number of complete frames
+    std::uint64_t dataOffset;
+};
+
+struct GLFrameFileEntry
+{
+    std::uint64_t offset; // of the frame in the file
+    std::uint64_t timestamp;
+};
+
+/*
+ * Stream frames from the bound framebuffer into a preallocated, memory
+ * mapped file, for offline rendering and dataset capture:
+ *
+ *   aglet::GLFrameSink sink("capture.agf", width, height, 1000);
+ *   while (render())
+ *   {
+ *       sink(timestamp); // reads the bound framebuffer
+ *   }
+ *   sink.flush();
+ *
+ * Readbacks go through a ring of depth PBOs: a frame is copied from the
+ * mapped PBO straight into its mapped file slot depth - 1 frames later,
+ * so there is no heap buffer and no write() call (without PBOs, on
+ * OpenGL ES 2.0, glReadPixels writes into the slot directly).  A
+ * background thread msync()s each completed slot and releases its pages
+ * with madvise(), so resident memory stays bounded during multi-GB
+ * captures.
+ */
+
+class GLFrameSink
+{
+public:
+    // Create (truncate) filename with capacity slots, throws on failure:
+    GLFrameSink(const std::string& filename, int width, int height, std::size_t capacity, std::size_t depth = 2, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+    // Flush and close the file:
+    ~GLFrameSink();
+
+    GLFrameSink(const GLFrameSink&) = delete;
+    GLFrameSink& operator=(const GLFrameSink&) = delete;
+
+    // Read the bound framebuffer into the next slot, false if the file is full:
+    bool operator()(std::uint64_t timestamp = 0);
+
+    // Complete pending readbacks and wait until all frames are synced to the file:
+    void flush();
+
+    // Number of frames captured (including pending readbacks):
+    std::size_t getCount() const { return m_next; }
+    std::size_t getCapacity() const { return m_capacity; }
+
+protected:
+    struct Pending
+    {
+        std::size_t pbo;
+        std::size_t slot;
+        std::uint64_t timestamp;
+    };
+
+    GLubyte* getSlot(std::size_t slot) const;
+    void commit(std::size_t slot, std::uint64_t timestamp); // index + background sync
+    void sync();                                            // background thread
+
+    int m_width = 0;
+    int m_height = 0;
+    GLenum m_format = GL_RGBA;
+    GLenum m_type = GL_UNSIGNED_BYTE;
+    std::size_t m_capacity = 0;
+    std::size_t m_next = 0;
+
+    int m_fd = -1;
+    GLubyte* m_data = nullptr; // mapping
+    std::size_t m_size = 0;
+    GLFrameFileHeader* m_header = nullptr;
+    GLFrameFileEntry* m_entries = nullptr;
+
+#if defined(AGLET_HAS_PBO)
+    void finish(); // oldest pending readback
+
+    std::vector<std::unique_ptr<IPBO>> m_pbos;
+    std::deque<Pending> m_pending;
+#endif
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::size_t> m_queue; // slots to sync
+    std::size_t m_syncing = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+/*
+ * Read only view of a frame file written by GLFrameSink:
+ *
+ *   aglet::GLFrameFile file("capture.agf");
+ *   for (std::size_t i = 0; i < file.getCount(); i++) use(file.getFrame(i));
+ */
+
+class GLFrameFile
+{
+public:
+    explicit GLFrameFile(const std::string& filename); // throws on failure
+    ~GLFrameFile();
+
+    GLFrameFile(const GLFrameFile&) = delete;
+    GLFrameFile& operator=(const GLFrameFile&) = delete;
+
+    const GLFrameFileHeader& getHeader() const { return *m_header; }
+    std::size_t getCount() const { return std::size_t(m_header->count); }
+    const GLubyte* getFrame(std::size_t index) const;
+    std::uint64_t getTimestamp(std::size_t index) const;
+
+protected:
+    bool isValid() const; // header, index and frame offsets within the file
+
+    int m_fd = -1;
+    const GLubyte* m_data = nullptr;
+    std::size_t m_size = 0;
+    const GLFrameFileHeader* m_header = nullptr;
+    const GLFrameFileEntry* m_entries = nullptr;
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
+
+#endif // __aglet_GLFrameSink_h__
@@ -0,0 +1,125 @@
+/*!
+  @file   GLIncrementalUploader.cpp
+  @brief  Implementation of dirty region texture uploads for mostly static frames.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLIncrementalUploader.h"
+#include "aglet/GLError.h"
+#include "aglet/GLTexture.h"
+
+#include <algorithm>
+#include <cstring>
+
+AGLET_BEGIN
+
+GLIncrementalUploader::GLIncrementalUploader(GLTexture& texture, int tileSize)
+    : m_texture(texture)
+    , m_width(int(texture.getWidth()))
+    , m_height(int(texture.getHeight()))
+    , m_tileSize(tileSize)
+    , m_pixelSize(getPixelSize(texture.getFormat(), texture.getType()))
+{
+    throw_assert(tileSize > 0, "GLIncrementalUploader::GLIncrementalUploader() : invalid tile size " << tileSize);
+}
+
+void GLIncrementalUploader::upload(const GLubyte* pixels, std::size_t stride)
+{
+    const std::size_t rowSize = std::size_t(m_width) * m_pixelSize;
+    stride = stride ? stride : rowSize;
+
+    std::vector<Rect> dirty;
+    if (!m_valid)
+    {
+        Rect rect;
+        rect.width = m_width;
+        rect.height = m_height;
+        dirty.push_back(rect);
+    }
+    else
+    {
+        const int cols = (m_width + m_tileSize - 1) / m_tileSize;
+        std::vector<bool> changed(cols);
+        for (int y0 = 0; y0 < m_height; y0 += m_tileSize)
+        {
+            const int rows = std::min(m_tileSize, m_height - y0);
+
+            // Compare each tile row by row until the first difference:
+            std::fill(changed.begin(), changed.end(), false);
+            for (int tx = 0; tx < cols; tx++)
+            {
+                const std::size_t offset = std::size_t(tx * m_tileSize) * m_pixelSize;
+                const std::size_t size = std::size_t(std::min(m_tileSize, m_width - tx * m_tileSize)) * m_pixelSize;
+                for (int y = y0; (y < (y0 + rows)) && !changed[tx]; y++)
+                {
+                    changed[tx] = (std::memcmp(pixels + y * stride + offset, m_previous.data() + y * rowSize + offset, size) != 0);
+                }
+            }
+
+            // Merge runs of dirty tiles into spans:
+            for (int tx = 0; tx < cols;)
+            {
+                if (!changed[tx])
+                {
+                    tx++;
+                    continue;
+                }
+
+                Rect rect;
+                rect.x = tx * m_tileSize;
+                rect.y = y0;
+                rect.height = rows;
+                while ((tx < cols) && changed[tx])
+                {
+                    tx++;
+                }
+                rect.width = std::min(tx * m_tileSize, m_width) - rect.x;
+                dirty.push_back(rect);
+            }
+        }
+    }
+
+    upload(pixels, stride, dirty);
+}
+
+void GLIncrementalUploader::upload(const GLubyte* pixels, std::size_t stride, const std::vector<Rect>& dirty)
+{
+    const std::size_t rowSize = std::size_t(m_width) * m_pixelSize;
+    stride = stride ? stride : rowSize;
+
+    if (m_previous.empty())
+    {
+        m_previous.resize(rowSize * std::size_t(m_height));
+    }
+
+    m_dirty = dirty;
+    m_uploadSize = 0;
+
+    m_texture.bind();
+    for (const auto& rect : m_dirty)
+    {
+        throw_assert((rect.x >= 0) && (rect.y >= 0) && ((rect.x + rect.width) <= m_width) && ((rect.y + rect.height) <= m_height), "GLIncrementalUploader::upload() : invalid rectangle");
+        write(pixels, stride, rect);
+    }
+    m_texture.unbind();
+
+    // The copy is complete after a full upload, or if it was already:
+    m_valid |= ((m_dirty.size() == 1) && (m_dirty.front().width == m_width) && (m_dirty.front().height == m_height));
+}
+
+void GLIncrementalUploader::write(const GLubyte* pixels, std::size_t stride, const Rect& rect)
+{
+    const std::size_t rowSize = std::size_t(m_width) * m_pixelSize;
+    const std::size_t offset = std::size_t(rect.x) * m_pixelSize;
+    const std::size_t size = std::size_t(rect.width) * m_pixelSize;
+    const GLubyte* src = pixels + std::size_t(rect.y) * stride + offset;
+
+    writePixels(rect.x, rect.y, rect.width, rect.height, src, stride, m_texture.getFormat(), m_texture.getType());
+    copyRows(m_previous.data() + std::size_t(rect.y) * rowSize + offset, rowSize, src, stride, size, std::size_t(rect.height));
+    m_uploadSize += size * std::size_t(rect.height);
+}
+
+AGLET_END
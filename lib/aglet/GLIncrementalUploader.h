@@ -0,0 +1,88 @@
+/*!
+  @file   GLIncrementalUploader.h
+  @brief  Declaration of dirty region texture uploads for mostly static frames.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLIncrementalUploader_h__
+#define __aglet_GLIncrementalUploader_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#include <cstddef>
+#include <vector>
+
+AGLET_BEGIN
+
+class GLTexture;
+
+/*
+ * Upload only the changed regions of a frame to a texture (i.e., screen
+ * capture, where a few percent of the pixels change per frame):
+ *
+ *   aglet::GLIncrementalUploader uploader(texture, 64);
+ *   uploader.upload(frame, stride);        // diff against the previous frame
+ *   uploader.upload(frame, stride, dirty); // caller provided dirty rectangles
+ *
+ * In diff mode the frame is compared to a copy of the previous frame in
+ * tiles of tileSize x tileSize pixels (memcmp per tile row, which is SIMD
+ * in common C libraries, stopping at the first difference), horizontally
+ * adjacent dirty tiles are merged into one span and each span is uploaded
+ * with one glTexSubImage2D directly from the strided frame.  The first
+ * frame is uploaded in full.
+ *
+ * The texture is not owned and must outlive the uploader.
+ */
+
+class GLIncrementalUploader
+{
+public:
+    struct Rect
+    {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    GLIncrementalUploader(GLTexture& texture, int tileSize = 64);
+
+    // Diff against the previous frame and upload the changed tiles:
+    void upload(const GLubyte* pixels, std::size_t stride = 0);
+
+    // Upload the given rectangles (the previous frame copy is updated as well):
+    void upload(const GLubyte* pixels, std::size_t stride, const std::vector<Rect>& dirty);
+
+    // Force a full upload on the next diff (i.e., after the texture was modified):
+    void invalidate() { m_valid = false; }
+
+    // Rectangles uploaded by the last call:
+    const std::vector<Rect>& getDirty() const { return m_dirty; }
+
+    // Bytes uploaded by the last call:
+    std::size_t getUploadSize() const { return m_uploadSize; }
+
+    int getTileSize() const { return m_tileSize; }
+
+protected:
+    void write(const GLubyte* pixels, std::size_t stride, const Rect& rect);
+
+    GLTexture& m_texture;
+    int m_width = 0;
+    int m_height = 0;
+    int m_tileSize = 64;
+    std::size_t m_pixelSize = 4;
+
+    bool m_valid = false;
+    std::vector<GLubyte> m_previous; // tightly packed
+    std::vector<Rect> m_dirty;
+    std::size_t m_uploadSize = 0;
+};
+
+AGLET_END
+
+#endif // __aglet_GLIncrementalUploader_h__
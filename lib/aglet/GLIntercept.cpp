@@ -0,0 +1,153 @@
+/*!
+  @file   GLIntercept.cpp
+  @brief  GL call interception for GLStats (AGLET_GL_STATS builds).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#define AGLET_GL_INTERCEPT_IMPL 1 // call the real entry points below
+
+#include "aglet/gl_includes.h"
+
+#if defined(AGLET_HAS_GL_STATS)
+
+#include "aglet/GLIntercept.h"
+#include "aglet/GLContext.h"
+
+#include <chrono>
+
+AGLET_BEGIN
+
+static std::int64_t now()
+{
+    const auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+GLCallScope::GLCallScope(GLStats::Call call)
+    : m_call(call)
+{
+    GLContext* context = GLContext::current();
+    if (context && context->getStats().isEnabled())
+    {
+        m_stats = &context->getStats();
+        m_begin = now();
+    }
+}
+
+GLCallScope::~GLCallScope()
+{
+    if (m_stats)
+    {
+        m_stats->record(m_call, now() - m_begin);
+    }
+}
+
+static void bind(GLCallScope& scope, GLStats::Binding kind, GLenum target, GLuint unit, GLuint name)
+{
+    if (scope.getStats() && scope.getStats()->bind(kind, target, unit, name))
+    {
+        scope.getStats()->warn(GLStats::kWarnRedundantBind);
+    }
+}
+
+static void forget(GLCallScope& scope, GLStats::Binding kind, GLsizei n, const GLuint* names)
+{
+    for (GLsizei i = 0; scope.getStats() && names && (i < n); i++)
+    {
+        scope.getStats()->forget(kind, names[i]);
+    }
+}
+
+void GLIntercept::activeTexture(GLenum texture)
+{
+    GLCallScope scope(GLStats::kActiveTexture);
+    if (scope.getStats())
+    {
+        scope.getStats()->setActiveTexture(texture - GL_TEXTURE0);
+    }
+    glActiveTexture(texture);
+}
+
+void GLIntercept::bindTexture(GLenum target, GLuint texture)
+{
+    GLCallScope scope(GLStats::kBindTexture);
+    if (scope.getStats())
+    {
+        bind(scope, GLStats::kTextureBinding, target, scope.getStats()->getActiveTexture(), texture);
+    }
+    glBindTexture(target, texture);
+}
+
+void GLIntercept::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLCallScope scope(GLStats::kBindBuffer);
+    bind(scope, GLStats::kBufferBinding, target, 0, buffer);
+    glBindBuffer(target, buffer);
+}
+
+void GLIntercept::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    GLCallScope scope(GLStats::kBindFramebuffer);
+    bind(scope, GLStats::kFramebufferBinding, target, 0, framebuffer);
+    glBindFramebuffer(target, framebuffer);
+}
+
+void GLIntercept::useProgram(GLuint program)
+{
+    GLCallScope scope(GLStats::kUseProgram);
+    bind(scope, GLStats::kProgramBinding, 0, 0, program);
+    glUseProgram(program);
+}
+
+void GLIntercept::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+    GLCallScope scope(GLStats::kReadPixels);
+    if (scope.getStats())
+    {
+#if defined(AGLET_HAS_PBO)
+        const bool packBuffer = scope.getStats()->getBinding(GLStats::kBufferBinding, GL_PIXEL_PACK_BUFFER, 0) != 0;
+#else
+        const bool packBuffer = false;
+#endif
+        if (!packBuffer)
+        {
+            scope.getStats()->warn(GLStats::kWarnSyncReadPixels);
+        }
+    }
+    glReadPixels(x, y, width, height, format, type, pixels);
+}
+
+void GLIntercept::deleteTextures(GLsizei n, const GLuint* textures)
+{
+    GLCallScope scope(GLStats::kDeleteTextures);
+    forget(scope, GLStats::kTextureBinding, n, textures);
+    glDeleteTextures(n, textures);
+}
+
+void GLIntercept::deleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    GLCallScope scope(GLStats::kDeleteBuffers);
+    forget(scope, GLStats::kBufferBinding, n, buffers);
+    glDeleteBuffers(n, buffers);
+}
+
+void GLIntercept::deleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    GLCallScope scope(GLStats::kDeleteFramebuffers);
+    forget(scope, GLStats::kFramebufferBinding, n, framebuffers);
+    glDeleteFramebuffers(n, framebuffers);
+}
+
+void GLIntercept::deleteProgram(GLuint program)
+{
+    // The program stays in use until another one is installed:
+    GLCallScope scope(GLStats::kDeleteProgram);
+    glDeleteProgram(program);
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_GL_STATS)
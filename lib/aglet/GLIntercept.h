@@ -0,0 +1,138 @@
+/*!
+  @file   GLIntercept.h
+  @brief  GL call interception for GLStats (AGLET_GL_STATS builds).
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLIntercept_h__
+#define __aglet_GLIntercept_h__
+
+#include "aglet/aglet.h"
+#include "aglet/GLStats.h"
+#include "aglet/gl_includes.h"
+
+#include <cstdint>
+
+/*
+ * Included by gl_includes.h when aglet is built with AGLET_GL_STATS: the
+ * GL entry points listed in AGLET_GL_STATS_CALLS are replaced by function
+ * like macros, so that aglet and all code including aglet/gl_includes.h
+ * (after any other GL header) report to the GLStats of the current
+ * context.  Taking the address of an entry point is not affected.
+ *
+ * The CPU time of a call is measured until the end of the enclosing full
+ * expression, nested intercepted calls (glUniform1i(glGetUniformLocation(..)))
+ * are counted separately with overlapping times.
+ *
+ * Not available with GLEW (Windows), where the entry points are macros.
+ */
+
+AGLET_BEGIN
+
+// Charges the lifetime of the temporary to call in the current context:
+class GLCallScope
+{
+public:
+    explicit GLCallScope(GLStats::Call call);
+    ~GLCallScope();
+
+    GLCallScope(const GLCallScope&) = delete;
+    GLCallScope& operator=(const GLCallScope&) = delete;
+
+    GLStats* getStats() const { return m_stats; } // nullptr if not recording
+
+protected:
+    GLStats* m_stats = nullptr;
+    GLStats::Call m_call;
+    std::int64_t m_begin = 0;
+};
+
+// Entry points with state tracking for the anti-pattern warnings:
+struct GLIntercept
+{
+    static void activeTexture(GLenum texture);
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void bindFramebuffer(GLenum target, GLuint framebuffer);
+    static void useProgram(GLuint program);
+    static void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels);
+    static void deleteTextures(GLsizei n, const GLuint* textures);
+    static void deleteBuffers(GLsizei n, const GLuint* buffers);
+    static void deleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+    static void deleteProgram(GLuint program);
+};
+
+AGLET_END
+
+// GLIntercept.cpp calls the real entry points:
+#if !defined(AGLET_GL_INTERCEPT_IMPL)
+
+// clang-format off
+#define AGLET_GL_CALL(name, ...) (::aglet::GLCallScope(::aglet::GLStats::k##name), gl##name(__VA_ARGS__))
+
+#define glActiveTexture(...) ::aglet::GLIntercept::activeTexture(__VA_ARGS__)
+#define glBindTexture(...) ::aglet::GLIntercept::bindTexture(__VA_ARGS__)
+#define glBindBuffer(...) ::aglet::GLIntercept::bindBuffer(__VA_ARGS__)
+#define glBindFramebuffer(...) ::aglet::GLIntercept::bindFramebuffer(__VA_ARGS__)
+#define glUseProgram(...) ::aglet::GLIntercept::useProgram(__VA_ARGS__)
+#define glReadPixels(...) ::aglet::GLIntercept::readPixels(__VA_ARGS__)
+#define glDeleteTextures(...) ::aglet::GLIntercept::deleteTextures(__VA_ARGS__)
+#define glDeleteBuffers(...) ::aglet::GLIntercept::deleteBuffers(__VA_ARGS__)
+#define glDeleteFramebuffers(...) ::aglet::GLIntercept::deleteFramebuffers(__VA_ARGS__)
+#define glDeleteProgram(...) ::aglet::GLIntercept::deleteProgram(__VA_ARGS__)
+
+#define glBufferData(...) AGLET_GL_CALL(BufferData, __VA_ARGS__)
+#define glBufferSubData(...) AGLET_GL_CALL(BufferSubData, __VA_ARGS__)
+#define glTexImage2D(...) AGLET_GL_CALL(TexImage2D, __VA_ARGS__)
+#define glTexSubImage2D(...) AGLET_GL_CALL(TexSubImage2D, __VA_ARGS__)
+#define glCopyTexSubImage2D(...) AGLET_GL_CALL(CopyTexSubImage2D, __VA_ARGS__)
+#define glPixelStorei(...) AGLET_GL_CALL(PixelStorei, __VA_ARGS__)
+#define glTexParameteri(...) AGLET_GL_CALL(TexParameteri, __VA_ARGS__)
+#define glGenerateMipmap(...) AGLET_GL_CALL(GenerateMipmap, __VA_ARGS__)
+#define glClear(...) AGLET_GL_CALL(Clear, __VA_ARGS__)
+#define glDrawArrays(...) AGLET_GL_CALL(DrawArrays, __VA_ARGS__)
+#define glDrawElements(...) AGLET_GL_CALL(DrawElements, __VA_ARGS__)
+#define glViewport(...) AGLET_GL_CALL(Viewport, __VA_ARGS__)
+#define glFramebufferTexture2D(...) AGLET_GL_CALL(FramebufferTexture2D, __VA_ARGS__)
+#define glCheckFramebufferStatus(...) AGLET_GL_CALL(CheckFramebufferStatus, __VA_ARGS__)
+#define glGetError(...) AGLET_GL_CALL(GetError, __VA_ARGS__)
+#define glGetIntegerv(...) AGLET_GL_CALL(GetIntegerv, __VA_ARGS__)
+#define glGetUniformLocation(...) AGLET_GL_CALL(GetUniformLocation, __VA_ARGS__)
+#define glUniform1i(...) AGLET_GL_CALL(Uniform1i, __VA_ARGS__)
+#define glUniform1f(...) AGLET_GL_CALL(Uniform1f, __VA_ARGS__)
+#define glUniform2f(...) AGLET_GL_CALL(Uniform2f, __VA_ARGS__)
+#define glUniform3f(...) AGLET_GL_CALL(Uniform3f, __VA_ARGS__)
+#define glUniform4fv(...) AGLET_GL_CALL(Uniform4fv, __VA_ARGS__)
+#define glUniformMatrix3fv(...) AGLET_GL_CALL(UniformMatrix3fv, __VA_ARGS__)
+#define glVertexAttribPointer(...) AGLET_GL_CALL(VertexAttribPointer, __VA_ARGS__)
+#define glEnableVertexAttribArray(...) AGLET_GL_CALL(EnableVertexAttribArray, __VA_ARGS__)
+#define glDisableVertexAttribArray(...) AGLET_GL_CALL(DisableVertexAttribArray, __VA_ARGS__)
+#define glGenTextures(...) AGLET_GL_CALL(GenTextures, __VA_ARGS__)
+#define glGenBuffers(...) AGLET_GL_CALL(GenBuffers, __VA_ARGS__)
+#define glGenFramebuffers(...) AGLET_GL_CALL(GenFramebuffers, __VA_ARGS__)
+#define glFinish(...) AGLET_GL_CALL(Finish, __VA_ARGS__)
+#define glFlush(...) AGLET_GL_CALL(Flush, __VA_ARGS__)
+
+#if defined(AGLET_HAS_PBO)
+#  define glMapBufferRange(...) AGLET_GL_CALL(MapBufferRange, __VA_ARGS__)
+#  define glUnmapBuffer(...) AGLET_GL_CALL(UnmapBuffer, __VA_ARGS__)
+#endif
+
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+#  define glTexImage3D(...) AGLET_GL_CALL(TexImage3D, __VA_ARGS__)
+#  define glTexSubImage3D(...) AGLET_GL_CALL(TexSubImage3D, __VA_ARGS__)
+#  define glDrawArraysInstanced(...) AGLET_GL_CALL(DrawArraysInstanced, __VA_ARGS__)
+#endif
+
+#if defined(AGLET_HAS_COMPUTE)
+#  define glDispatchCompute(...) AGLET_GL_CALL(DispatchCompute, __VA_ARGS__)
+#  define glMemoryBarrier(...) AGLET_GL_CALL(MemoryBarrier, __VA_ARGS__)
+#endif
+// clang-format on
+
+#endif // !defined(AGLET_GL_INTERCEPT_IMPL)
+
+#endif // __aglet_GLIntercept_h__
@@ -0,0 +1,163 @@
+/*!
+  @file   GLMappedImage.cpp
+  @brief  Implementation of texture uploads from memory mapped raw image files.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLMappedImage.h"
+
+#if defined(AGLET_HAS_POSIX)
+
+#include "aglet/GLError.h"
+#include "aglet/GLPBO.h"
+#include "aglet/GLTexture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AGLET_BEGIN
+
+static const std::size_t kBandSize = 4 << 20; // bytes
+
+GLMappedImage::GLMappedImage(const std::string& filename, std::size_t offset, int width, int height, std::size_t stride, GLenum format, GLenum type)
+    : m_width(width)
+    , m_height(height)
+    , m_format(format)
+    , m_type(type)
+{
+    throw_assert((width > 0) && (height > 0), "GLMappedImage::GLMappedImage() : invalid size");
+
+    const std::size_t rowSize = std::size_t(width) * getPixelSize(format, type);
+    m_stride = stride ? stride : rowSize;
+    throw_assert(m_stride >= rowSize, "GLMappedImage::GLMappedImage() : stride " << m_stride << " < row size " << rowSize);
+
+    m_fd = open(filename.c_str(), O_RDONLY);
+    throw_assert(m_fd >= 0, "GLMappedImage::GLMappedImage() : open() " << filename << " : " << std::strerror(errno));
+
+    // The last row may end before the stride:
+    const std::size_t end = offset + m_stride * std::size_t(height - 1) + rowSize;
+    struct stat info;
+    if ((fstat(m_fd, &info) != 0) || (std::size_t(info.st_size) < end))
+    {
+        close(m_fd);
+        throw_assert(false, "GLMappedImage::GLMappedImage() : " << filename << " is smaller than " << end << " bytes");
+    }
+
+    // mmap() offsets must be page aligned:
+    const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    const std::size_t start = (offset / page) * page;
+    m_size = end - start;
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, off_t(start));
+    if (data == MAP_FAILED)
+    {
+        close(m_fd);
+        throw_assert(false, "GLMappedImage::GLMappedImage() : mmap() : " << std::strerror(errno));
+    }
+
+    m_data = static_cast<GLubyte*>(data);
+    m_pixels = m_data + (offset - start);
+    madvise(m_data, m_size, MADV_SEQUENTIAL);
+}
+
+GLMappedImage::~GLMappedImage()
+{
+    munmap(m_data, m_size);
+    close(m_fd);
+}
+
+void GLMappedImage::advise(int row, int rows, int advice) const
+{
+    if ((rows <= 0) || (row >= m_height))
+    {
+        return;
+    }
+
+    // Round the band out to whole pages of the mapping:
+    const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    const std::size_t begin = std::size_t(m_pixels - m_data) + std::size_t(row) * m_stride;
+    const std::size_t end = std::min(begin + std::size_t(rows) * m_stride, m_size);
+    const std::size_t first = (begin / page) * page;
+    madvise(m_data + first, end - first, advice);
+}
+
+void GLMappedImage::upload(GLTexture& texture, Transfer transfer, int bandRows)
+{
+    throw_assert((texture.getWidth() == std::size_t(m_width)) && (texture.getHeight() == std::size_t(m_height)), "GLMappedImage::upload() : texture size mismatch");
+    throw_assert((texture.getFormat() == m_format) && (texture.getType() == m_type), "GLMappedImage::upload() : texture format mismatch");
+
+#if defined(AGLET_HAS_PBO)
+    if (transfer == kAuto)
+    {
+        // The calibrated upload method of the current context, PBOs otherwise:
+        const GLContext* context = GLContext::current();
+        const bool direct = context && (context->getTransferStrategy().upload == GLContext::kTransferDirect) && context->isTransferCalibrated();
+        transfer = direct ? kClientPointer : kPBO;
+    }
+#else
+    throw_assert(transfer != kPBO, "GLMappedImage::upload() : pixel buffer objects are not supported");
+    transfer = kClientPointer;
+#endif
+
+    if (bandRows <= 0)
+    {
+        bandRows = int(std::max(std::size_t(1), kBandSize / m_stride));
+    }
+    bandRows = std::min(bandRows, m_height);
+
+#if defined(AGLET_HAS_PBO)
+    std::unique_ptr<OPBO> pbo, last; // full bands, shorter last band
+    if (transfer == kPBO)
+    {
+        pbo.reset(new OPBO(std::size_t(m_width), std::size_t(bandRows), m_format, m_type));
+        if (m_height % bandRows)
+        {
+            last.reset(new OPBO(std::size_t(m_width), std::size_t(m_height % bandRows), m_format, m_type));
+        }
+    }
+#endif
+
+    advise(0, bandRows, MADV_WILLNEED);
+    for (int y = 0; y < m_height; y += bandRows)
+    {
+        const int rows = std::min(bandRows, m_height - y);
+        advise(y + rows, bandRows, MADV_WILLNEED); // read ahead
+
+        const GLubyte* band = m_pixels + std::size_t(y) * m_stride;
+#if defined(AGLET_HAS_PBO)
+        if (transfer == kPBO)
+        {
+            auto& target = (rows == bandRows) ? *pbo : *last;
+            target.bind();
+            target.write(band, texture, m_stride, 0, y);
+            target.unbind();
+        }
+        else
+#endif
+        {
+            texture.bind();
+            writePixels(GLContext::kTransferDirect, 0, y, m_width, rows, band, m_stride, m_format, m_type);
+        }
+
+        // The driver has its copy (client memory or the PBO), drop the pages:
+        advise(y, rows, MADV_DONTNEED);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkGLError("GLMappedImage::upload() : glTexSubImage2D()");
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
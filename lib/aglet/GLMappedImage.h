@@ -0,0 +1,92 @@
+/*!
+  @file   GLMappedImage.h
+  @brief  Declaration of texture uploads from memory mapped raw image files.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLMappedImage_h__
+#define __aglet_GLMappedImage_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#if defined(AGLET_HAS_POSIX) // mmap
+
+#include <cstddef>
+#include <string>
+
+AGLET_BEGIN
+
+class GLTexture;
+
+/*
+ * Read only mapping of a raw image stored in a file region (e.g., a frame
+ * of a dataset file behind a header), uploaded without reading the file
+ * into a heap buffer first:
+ *
+ *   aglet::GLMappedImage image("frames.raw", header + i * frameSize, width, height);
+ *   aglet::GLTexture texture(width, height);
+ *   image.upload(texture);
+ *
+ * The upload proceeds in bands of rows.  Before a band is transferred the
+ * next one is requested with madvise(MADV_WILLNEED), so the kernel reads
+ * the file ahead while the driver consumes the current band, and pages of
+ * completed bands are released with MADV_DONTNEED (they stay in the page
+ * cache), so resident memory is bounded by a few bands.
+ *
+ * With kClientPointer the mapping is passed to glTexSubImage2D as the
+ * client pointer, and with kPBO each band is copied from the mapping into
+ * a mapped (orphaned) pixel buffer object and unpacked from there.  Rows
+ * are stored bottom up (first row -> texture row 0), as read by glReadPixels.
+ */
+
+class GLMappedImage
+{
+public:
+    enum Transfer
+    {
+        kAuto,          // calibrated method of the current context, else kPBO where available
+        kClientPointer, // glTexSubImage2D from the mapping
+        kPBO            // mapping -> mapped PBO -> glTexSubImage2D
+    };
+
+    // Map height rows of width pixels, stride bytes apart (0: tightly packed),
+    // at offset in filename, throws if the file is too small:
+    GLMappedImage(const std::string& filename, std::size_t offset, int width, int height, std::size_t stride = 0, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+    ~GLMappedImage();
+
+    GLMappedImage(const GLMappedImage&) = delete;
+    GLMappedImage& operator=(const GLMappedImage&) = delete;
+
+    // Upload to a texture with the same size, format and type, bandRows == 0
+    // selects bands of about 4 MB:
+    void upload(GLTexture& texture, Transfer transfer = kAuto, int bandRows = 0);
+
+    const GLubyte* getData() const { return m_pixels; }
+    std::size_t getStride() const { return m_stride; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+protected:
+    void advise(int row, int rows, int advice) const; // page aligned madvise() over rows
+
+    int m_width = 0;
+    int m_height = 0;
+    std::size_t m_stride = 0;
+    GLenum m_format = GL_RGBA;
+    GLenum m_type = GL_UNSIGNED_BYTE;
+
+    int m_fd = -1;
+    GLubyte* m_data = nullptr; // page aligned mapping
+    std::size_t m_size = 0;
+    const GLubyte* m_pixels = nullptr; // first row
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_POSIX)
+
+#endif // __aglet_GLMappedImage_h__
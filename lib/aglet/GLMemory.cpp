@@ -0,0 +1,290 @@
+/*!
+  @file   GLMemory.cpp
+  @brief  Implementation of per context GPU memory accounting and budgets.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLMemory.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLContext.h"
+#include "aglet/gl_includes.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+// GL_NVX_gpu_memory_info (kilobytes):
+#define AGLET_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define AGLET_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define AGLET_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX 0x904B
+
+// GL_ATI_meminfo (kilobytes, 4 values: total free, largest free block, total auxiliary free, largest auxiliary block):
+#define AGLET_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+AGLET_BEGIN
+
+// Process totals, the last counter is the sum of all resources:
+static std::array<GLMemory::Counter, GLMemory::kResourceCount + 1>& getGlobal()
+{
+    static std::array<GLMemory::Counter, GLMemory::kResourceCount + 1> global;
+    return global;
+}
+
+void GLMemory::Counter::add(std::size_t size)
+{
+    const std::size_t value = (bytes += size);
+    count++;
+
+    std::size_t previous = peak;
+    while ((value > previous) && !peak.compare_exchange_weak(previous, value))
+    {
+    }
+}
+
+void GLMemory::Counter::sub(std::size_t size)
+{
+    bytes -= size;
+    count--;
+}
+
+void GLMemory::allocate(Resource resource, std::size_t bytes)
+{
+    m_usage[resource].add(bytes);
+    m_total.add(bytes);
+
+    if (m_budget && (getBytes() > m_budget) && !m_evicting)
+    {
+        evict(getBytes() - m_budget);
+        if (getBytes() > m_budget)
+        {
+            m_overBudget++;
+        }
+    }
+}
+
+void GLMemory::release(Resource resource, std::size_t bytes)
+{
+    m_usage[resource].sub(bytes);
+    m_total.sub(bytes);
+}
+
+void GLMemory::resetPeak()
+{
+    for (auto& usage : m_usage)
+    {
+        usage.peak = std::size_t(usage.bytes);
+    }
+    m_total.peak = std::size_t(m_total.bytes);
+}
+
+void GLMemory::setBudget(std::size_t bytes)
+{
+    m_budget = bytes;
+    if (m_budget && (getBytes() > m_budget))
+    {
+        evict(getBytes() - m_budget);
+    }
+}
+
+int GLMemory::addEvictor(const Evictor& evictor)
+{
+    m_evictors.emplace_back(m_nextEvictor, evictor);
+    return m_nextEvictor++;
+}
+
+void GLMemory::removeEvictor(int id)
+{
+    m_evictors.erase(std::remove_if(m_evictors.begin(), m_evictors.end(), [id](const std::pair<int, Evictor>& entry) {
+        return entry.first == id;
+    }),
+        m_evictors.end());
+}
+
+std::size_t GLMemory::evict(std::size_t bytes)
+{
+    if (m_evicting)
+    {
+        return 0;
+    }
+
+    struct Evicting // reset if an evictor throws
+    {
+        explicit Evicting(bool& flag)
+            : flag(flag)
+        {
+            flag = true;
+        }
+        ~Evicting() { flag = false; }
+        bool& flag;
+    } evicting(m_evicting);
+
+    // Evictors may add or remove evictors (themselves included), run the ones
+    // registered now, in order, unless they have been removed in the meantime:
+    std::vector<int> ids;
+    for (const auto& entry : m_evictors)
+    {
+        ids.push_back(entry.first);
+    }
+
+    const std::size_t start = getBytes();
+    for (int id : ids)
+    {
+        const std::size_t freed = start - std::min(start, std::size_t(getBytes()));
+        if (freed >= bytes)
+        {
+            break;
+        }
+        const auto entry = std::find_if(m_evictors.begin(), m_evictors.end(), [id](const std::pair<int, Evictor>& entry) {
+            return entry.first == id;
+        });
+        if (entry != m_evictors.end())
+        {
+            const Evictor evictor = entry->second; // may remove itself
+            evictor(bytes - freed);
+        }
+    }
+
+    return start - std::min(start, std::size_t(getBytes()));
+}
+
+std::size_t GLMemory::getGlobalBytes()
+{
+    return getGlobal()[kResourceCount].bytes;
+}
+
+std::size_t GLMemory::getGlobalBytes(Resource resource)
+{
+    return getGlobal()[resource].bytes;
+}
+
+std::size_t GLMemory::getGlobalPeak()
+{
+    return getGlobal()[kResourceCount].peak;
+}
+
+auto GLMemory::queryDriver(const GLCapabilities& capabilities) -> Driver
+{
+    Driver driver;
+    if (capabilities.has(GLCapabilities::kNVX_gpu_memory_info))
+    {
+        GLint dedicated = 0, available = 0, evicted = 0;
+        glGetIntegerv(AGLET_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+        glGetIntegerv(AGLET_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        glGetIntegerv(AGLET_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+        driver.valid = (glGetError() == GL_NO_ERROR);
+        driver.dedicated = std::size_t(dedicated) * 1024;
+        driver.available = std::size_t(available) * 1024;
+        driver.evicted = std::size_t(evicted) * 1024;
+    }
+    else if (capabilities.has(GLCapabilities::kATI_meminfo))
+    {
+        GLint info[4] = {};
+        glGetIntegerv(AGLET_TEXTURE_FREE_MEMORY_ATI, info);
+        driver.valid = (glGetError() == GL_NO_ERROR);
+        driver.available = std::size_t(info[0]) * 1024;
+    }
+    return driver;
+}
+
+const char* GLMemory::getName(Resource resource)
+{
+    static const char* names[] = { "texture", "renderbuffer", "buffer", "surface" };
+    return (resource < kResourceCount) ? names[resource] : "unknown";
+}
+
+void GLMemory::print(std::ostream& os) const
+{
+    os << "memory : " << getBytes() << " bytes (peak " << getPeak() << ")";
+    if (m_budget)
+    {
+        os << " budget " << m_budget;
+    }
+    os << " process " << getGlobalBytes() << " bytes (peak " << getGlobalPeak() << ")\n";
+    for (int i = 0; i < kResourceCount; i++)
+    {
+        const auto& usage = m_usage[i];
+        if (usage.count || usage.peak)
+        {
+            os << "  " << std::left << std::setw(16) << getName(Resource(i)) << std::right << std::setw(8) << usage.count
+               << std::setw(14) << usage.bytes << std::setw(14) << usage.peak << " bytes\n";
+        }
+    }
+    if (m_overBudget)
+    {
+        os << "  warning: over budget x " << m_overBudget << "\n";
+    }
+}
+
+GLAllocation::GLAllocation(GLMemory::Resource resource, std::size_t bytes)
+    : GLAllocation(GLContext::current(), resource, bytes)
+{
+}
+
+GLAllocation::GLAllocation(GLContext* context, GLMemory::Resource resource, std::size_t bytes)
+    : m_resource(resource)
+    , m_bytes(bytes)
+{
+    if (!bytes)
+    {
+        return;
+    }
+
+    getGlobal()[resource].add(bytes);
+    getGlobal()[GLMemory::kResourceCount].add(bytes);
+
+    if (context)
+    {
+        context->getMemory().allocate(resource, bytes);
+        m_memory = context->m_memory;
+    }
+}
+
+GLAllocation::~GLAllocation()
+{
+    reset();
+}
+
+GLAllocation::GLAllocation(GLAllocation&& other)
+    : m_memory(std::move(other.m_memory))
+    , m_resource(other.m_resource)
+    , m_bytes(other.m_bytes)
+{
+    other.m_memory.reset();
+    other.m_bytes = 0;
+}
+
+GLAllocation& GLAllocation::operator=(GLAllocation&& other)
+{
+    if (this != &other)
+    {
+        reset();
+        m_memory = std::move(other.m_memory);
+        m_resource = other.m_resource;
+        m_bytes = other.m_bytes;
+        other.m_memory.reset();
+        other.m_bytes = 0;
+    }
+    return *this;
+}
+
+void GLAllocation::reset()
+{
+    if (m_bytes)
+    {
+        getGlobal()[m_resource].sub(m_bytes);
+        getGlobal()[GLMemory::kResourceCount].sub(m_bytes);
+
+        if (auto memory = m_memory.lock())
+        {
+            memory->release(m_resource, m_bytes);
+        }
+
+        m_memory.reset();
+        m_bytes = 0;
+    }
+}
+
+AGLET_END
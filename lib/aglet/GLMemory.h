@@ -0,0 +1,171 @@
+/*!
+  @file   GLMemory.h
+  @brief  Declaration of per context GPU memory accounting and budgets.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLMemory_h__
+#define __aglet_GLMemory_h__
+
+#include "aglet/aglet.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+ * Bytes held by the GL resources aglet creates (GLTexture, GLBuffer, IPBO,
+ * OPBO, GLBatch and the EGL pbuffer surface), per context and for the
+ * whole process, with high water marks.  Surfaces are charged on EGL only,
+ * the default framebuffers of GLFW windows and iOS contexts are not:
+ *
+ *   auto& memory = gl->getMemory();
+ *   memory.setBudget(512 << 20);
+ *   auto id = memory.addEvictor([&](std::size_t bytes) { pool.trim(bytes); });
+ *   ...
+ *   memory.print(std::cout);
+ *
+ * Resources are charged to the context that is current through aglet when
+ * they are created (GLAllocation) and released when they are destroyed,
+ * even after the context is gone (process totals only).  Sizes are the
+ * nominal storage (width * height * pixel size, buffer size), drivers add
+ * padding and mipmaps on top.
+ *
+ * When an allocation leaves a context above its budget the evictors are
+ * called in the order they were added, with the number of bytes to free,
+ * until the context is within its budget.  The caches of the context (the
+ * recycled textures of GLNamePool, then the PBOs of the kTransferPBO
+ * methods) are evicted first, then the evictors of the application.
+ * Evictors release cached and pooled resources and must not allocate.
+ * Allocations are never refused, getOverBudgetCount() counts the
+ * allocations that remained over budget.
+ *
+ * Counters are atomic (resources may be destroyed on any thread), budgets
+ * and evictors belong to the thread that owns the context.
+ */
+
+AGLET_BEGIN
+
+class GLCapabilities;
+class GLContext;
+
+class GLMemory
+{
+public:
+    enum Resource
+    {
+        kTexture,
+        kRenderbuffer,
+        kBuffer,
+        kSurface,
+        kResourceCount
+    };
+
+    // Driver reported video memory (bytes), see queryDriver():
+    struct Driver
+    {
+        bool valid = false;
+        std::size_t dedicated = 0; // GL_NVX_gpu_memory_info only
+        std::size_t available = 0; // free video memory (GL_ATI_meminfo: texture pool)
+        std::size_t evicted = 0;   // GL_NVX_gpu_memory_info only
+    };
+
+    using Evictor = std::function<void(std::size_t bytes)>;
+
+    void allocate(Resource resource, std::size_t bytes);
+    void release(Resource resource, std::size_t bytes);
+
+    std::size_t getBytes() const { return m_total.bytes; }
+    std::size_t getBytes(Resource resource) const { return m_usage[resource].bytes; }
+    std::size_t getPeak() const { return m_total.peak; }
+    std::size_t getPeak(Resource resource) const { return m_usage[resource].peak; }
+    std::size_t getCount(Resource resource) const { return m_usage[resource].count; } // live objects
+
+    // Restart the high water marks from the current usage:
+    void resetPeak();
+
+    // Budget in bytes (0: unlimited):
+    void setBudget(std::size_t bytes);
+    std::size_t getBudget() const { return m_budget; }
+    std::uint64_t getOverBudgetCount() const { return m_overBudget; }
+
+    int addEvictor(const Evictor& evictor);
+    void removeEvictor(int id);
+
+    // Ask the evictors to free bytes, return the bytes actually freed:
+    std::size_t evict(std::size_t bytes);
+
+    // All contexts, including resources of destroyed contexts:
+    static std::size_t getGlobalBytes();
+    static std::size_t getGlobalBytes(Resource resource);
+    static std::size_t getGlobalPeak();
+
+    // Query GL_NVX_gpu_memory_info or GL_ATI_meminfo (context current), invalid if neither is supported:
+    static Driver queryDriver(const GLCapabilities& capabilities);
+
+    void print(std::ostream& os) const;
+
+    static const char* getName(Resource resource);
+
+    struct Counter
+    {
+        std::atomic<std::size_t> bytes{ 0 };
+        std::atomic<std::size_t> peak{ 0 };
+        std::atomic<std::size_t> count{ 0 };
+
+        void add(std::size_t size);
+        void sub(std::size_t size);
+    };
+
+protected:
+    std::array<Counter, kResourceCount> m_usage;
+    Counter m_total;
+
+    std::size_t m_budget = 0;
+    std::uint64_t m_overBudget = 0;
+    bool m_evicting = false;
+
+    int m_nextEvictor = 0;
+    std::vector<std::pair<int, Evictor>> m_evictors;
+};
+
+/*
+ * Handle of the bytes charged for one resource, released on destruction:
+ */
+
+class GLAllocation
+{
+public:
+    GLAllocation() = default;
+    GLAllocation(GLMemory::Resource resource, std::size_t bytes);                     // current aglet context
+    GLAllocation(GLContext* context, GLMemory::Resource resource, std::size_t bytes); // context may be nullptr
+    ~GLAllocation();
+
+    GLAllocation(GLAllocation&& other);
+    GLAllocation& operator=(GLAllocation&& other);
+
+    GLAllocation(const GLAllocation&) = delete;
+    GLAllocation& operator=(const GLAllocation&) = delete;
+
+    void reset(); // release now
+
+    std::size_t getBytes() const { return m_bytes; }
+
+protected:
+    std::weak_ptr<GLMemory> m_memory;
+    GLMemory::Resource m_resource = GLMemory::kTexture;
+    std::size_t m_bytes = 0;
+};
+
+AGLET_END
+
+#endif // __aglet_GLMemory_h__
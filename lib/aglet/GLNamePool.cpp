@@ -0,0 +1,213 @@
+/*!
+  @file   GLNamePool.cpp
+  @brief  Implementation of per context pools of GL object names and immutable textures.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLNamePool.h"
+#include "aglet/GLContext.h"
+#include "aglet/GLDispatch.h"
+#include "aglet/GLError.h"
+
+#include <algorithm>
+
+// Sized formats (not in all headers):
+#define AGLET_RGBA8 0x8058
+#define AGLET_RGB8 0x8051
+#define AGLET_R8 0x8229
+#define AGLET_RG8 0x822B
+#define AGLET_R16F 0x822D
+#define AGLET_R32F 0x822E
+#define AGLET_RG16F 0x822F
+#define AGLET_RG32F 0x8230
+#define AGLET_RGBA16F 0x881A
+#define AGLET_RGBA32F 0x8814
+#define AGLET_RED 0x1903
+#define AGLET_RG 0x8227
+
+AGLET_BEGIN
+
+GLNamePool::GLNamePool(std::size_t batch, std::size_t capacity)
+    : m_batch(std::max(batch, std::size_t(1)))
+    , m_capacity(capacity)
+{
+}
+
+GLNamePool::~GLNamePool() = default;
+
+void GLNamePool::create(Kind kind, GLsizei count, GLuint* names)
+{
+    switch (kind)
+    {
+        case kTexture:
+            glGenTextures(count, names);
+            break;
+        case kBuffer:
+            glGenBuffers(count, names);
+            break;
+        case kFramebuffer:
+            glGenFramebuffers(count, names);
+            break;
+        default:
+            break;
+    }
+}
+
+GLuint GLNamePool::acquire(Kind kind)
+{
+    auto& names = m_free[kind];
+    if (names.empty())
+    {
+        names.resize(m_batch);
+        create(kind, GLsizei(m_batch), names.data());
+        checkGLError("GLNamePool::acquire() : glGen*()");
+        std::reverse(names.begin(), names.end()); // hand out in generation order
+        m_generateCalls[kind]++;
+    }
+
+    const GLuint name = names.back();
+    names.pop_back();
+    return name;
+}
+
+GLuint GLNamePool::generate(Kind kind)
+{
+    if (GLContext* context = GLContext::current())
+    {
+        return context->getNamePool().acquire(kind);
+    }
+
+    GLuint name = 0;
+    create(kind, 1, &name);
+    return name;
+}
+
+GLuint GLNamePool::acquireTexture(GLsizei width, GLsizei height, GLenum internalFormat, GLAllocation& allocation)
+{
+    for (std::size_t i = m_recycled.size(); i > 0; i--) // most recently recycled first
+    {
+        auto& texture = m_recycled[i - 1];
+        if ((texture.width == width) && (texture.height == height) && (texture.internalFormat == internalFormat))
+        {
+            const GLuint name = texture.name;
+            m_recycledBytes -= texture.allocation.getBytes();
+            allocation = std::move(texture.allocation);
+            m_recycled.erase(m_recycled.begin() + std::ptrdiff_t(i - 1));
+            m_hits++;
+            return name;
+        }
+    }
+
+    GLContext* context = GLContext::current();
+    throw_assert(context && context->getDispatch().hasTextureStorage(), "GLNamePool::acquireTexture() : texture storage is unsupported");
+
+    const GLuint name = acquire(kTexture);
+    glBindTexture(GL_TEXTURE_2D, name);
+    context->getDispatch().texStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkGLError("GLNamePool::acquireTexture() : glTexStorage2D()");
+    return name;
+}
+
+void GLNamePool::recycle(GLuint texture, GLsizei width, GLsizei height, GLenum internalFormat, GLAllocation&& allocation)
+{
+    const std::size_t bytes = allocation.getBytes();
+    if (bytes > m_capacity)
+    {
+        glDeleteTextures(1, &texture);
+        return;
+    }
+
+    m_recycled.push_back({ texture, width, height, internalFormat, std::move(allocation) });
+    m_recycledBytes += bytes;
+
+    while (m_recycledBytes > m_capacity)
+    {
+        erase(0);
+    }
+}
+
+void GLNamePool::erase(std::size_t index)
+{
+    auto& texture = m_recycled[index];
+    glDeleteTextures(1, &texture.name);
+    m_recycledBytes -= texture.allocation.getBytes();
+    m_recycled.erase(m_recycled.begin() + std::ptrdiff_t(index)); // releases the allocation
+}
+
+std::size_t GLNamePool::trim(std::size_t bytes)
+{
+    const std::size_t start = m_recycledBytes;
+    while (!m_recycled.empty() && ((start - m_recycledBytes) < bytes))
+    {
+        erase(0);
+    }
+    return start - m_recycledBytes;
+}
+
+void GLNamePool::clear()
+{
+    while (!m_recycled.empty())
+    {
+        erase(m_recycled.size() - 1);
+    }
+
+    if (!m_free[kTexture].empty())
+    {
+        glDeleteTextures(GLsizei(m_free[kTexture].size()), m_free[kTexture].data());
+    }
+    if (!m_free[kBuffer].empty())
+    {
+        glDeleteBuffers(GLsizei(m_free[kBuffer].size()), m_free[kBuffer].data());
+    }
+    if (!m_free[kFramebuffer].empty())
+    {
+        glDeleteFramebuffers(GLsizei(m_free[kFramebuffer].size()), m_free[kFramebuffer].data());
+    }
+    for (auto& names : m_free)
+    {
+        names.clear();
+    }
+}
+
+void GLNamePool::setCapacity(std::size_t bytes)
+{
+    m_capacity = bytes;
+    while (m_recycledBytes > m_capacity)
+    {
+        erase(0);
+    }
+}
+
+GLenum GLNamePool::getSizedFormat(GLenum internalFormat, GLenum type)
+{
+    switch (internalFormat)
+    {
+        case GL_RGBA:
+            return (type == GL_UNSIGNED_BYTE) ? AGLET_RGBA8 : 0;
+        case GL_RGB:
+            return (type == GL_UNSIGNED_BYTE) ? AGLET_RGB8 : 0;
+        case AGLET_RED:
+            return (type == GL_UNSIGNED_BYTE) ? AGLET_R8 : 0;
+        case AGLET_RG:
+            return (type == GL_UNSIGNED_BYTE) ? AGLET_RG8 : 0;
+        case AGLET_RGBA8:
+        case AGLET_RGB8:
+        case AGLET_R8:
+        case AGLET_RG8:
+        case AGLET_R16F:
+        case AGLET_R32F:
+        case AGLET_RG16F:
+        case AGLET_RG32F:
+        case AGLET_RGBA16F:
+        case AGLET_RGBA32F:
+            return internalFormat; // sized
+        default:
+            return 0; // unsized (i.e., GL_BGRA) or legacy formats: glTexImage2D
+    }
+}
+
+AGLET_END
@@ -0,0 +1,130 @@
+/*!
+  @file   GLNamePool.h
+  @brief  Declaration of per context pools of GL object names and immutable textures.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLNamePool_h__
+#define __aglet_GLNamePool_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLMemory.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+AGLET_BEGIN
+
+/*
+ * Names of the objects aglet creates (GLTexture, GLBuffer, IPBO, OPBO,
+ * GLFrameBufferObject, GLQuad) come from the pool of the current aglet
+ * context, which generates them in batches (one glGen* call per batch)
+ * and hands them out from a free list:
+ *
+ *   GLuint name = GLNamePool::generate(GLNamePool::kFramebuffer);
+ *
+ * Textures created with GLTexture::kImmutable get a single level of
+ * glTexStorage2D storage where the context supports it (GLDispatch).  With
+ * a recycle bin (setCapacity(), none by default), when such a texture is
+ * destroyed while its context is current, the name and its storage go to
+ * the bin instead of glDeleteTextures, and the next immutable texture of
+ * the same size and format reuses them without any allocation:
+ *
+ *   gl->getNamePool().setCapacity(64 << 20);
+ *   for (...)
+ *   {
+ *       GLTexture texture(width, height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, nullptr, GLTexture::kImmutable);
+ *       ... // steady state: no glGenTextures, no glTexStorage2D
+ *   }
+ *
+ * The bin keeps the most recently recycled textures up to getCapacity()
+ * bytes, recycled textures stay charged to GLMemory and are the first
+ * thing the context's memory budget evicts.  The context deletes the free
+ * names and recycled textures when it is destroyed while current.
+ * Recycled textures keep their contents (undefined for the new owner).
+ * Deleted names of other objects are not reused, core profiles only
+ * accept names returned by glGen*.
+ *
+ * A pool belongs to the thread that owns its context.
+ */
+
+class GLNamePool
+{
+public:
+    enum Kind
+    {
+        kTexture,
+        kBuffer,
+        kFramebuffer,
+        kKindCount
+    };
+
+    explicit GLNamePool(std::size_t batch = 32, std::size_t capacity = 0);
+    ~GLNamePool(); // remaining names are dropped (see clear())
+
+    GLNamePool(const GLNamePool&) = delete;
+    GLNamePool& operator=(const GLNamePool&) = delete;
+
+    // A new name of kind (context current):
+    GLuint acquire(Kind kind);
+
+    // A texture with immutable storage (sized internalFormat, one level), recycled if possible,
+    // the allocation of a recycled texture is moved to allocation (context current, see hasTextureStorage()):
+    GLuint acquireTexture(GLsizei width, GLsizei height, GLenum internalFormat, GLAllocation& allocation);
+
+    // Return a texture from acquireTexture() to the recycle bin:
+    void recycle(GLuint texture, GLsizei width, GLsizei height, GLenum internalFormat, GLAllocation&& allocation);
+
+    // Delete recycled textures (least recently recycled first) until bytes are freed, return the bytes freed:
+    std::size_t trim(std::size_t bytes);
+
+    // Delete all free names and recycled textures (context current):
+    void clear();
+
+    // Recycle bin size in bytes (0: no recycling):
+    void setCapacity(std::size_t bytes);
+    std::size_t getCapacity() const { return m_capacity; }
+    std::size_t getRecycledBytes() const { return m_recycledBytes; }
+    std::size_t getRecycledCount() const { return m_recycled.size(); }
+
+    std::uint64_t getGenerateCount(Kind kind) const { return m_generateCalls[kind]; } // glGen* calls
+    std::uint64_t getRecycleHits() const { return m_hits; }
+
+    // Name from the pool of the current aglet context, glGen* without one:
+    static GLuint generate(Kind kind);
+
+    // Sized internal format for glTexStorage2D (i.e., GL_RGBA + GL_UNSIGNED_BYTE -> GL_RGBA8), 0 if not supported:
+    static GLenum getSizedFormat(GLenum internalFormat, GLenum type);
+
+protected:
+    struct Texture
+    {
+        GLuint name;
+        GLsizei width;
+        GLsizei height;
+        GLenum internalFormat;
+        GLAllocation allocation;
+    };
+
+    static void create(Kind kind, GLsizei count, GLuint* names);
+    void erase(std::size_t index); // delete a recycled texture
+
+    std::size_t m_batch = 32;
+    std::array<std::vector<GLuint>, kKindCount> m_free;
+    std::array<std::uint64_t, kKindCount> m_generateCalls = { { 0, 0, 0 } };
+
+    std::size_t m_capacity = 0;
+    std::size_t m_recycledBytes = 0;
+    std::vector<Texture> m_recycled; // least recently recycled first
+    std::uint64_t m_hits = 0;
+};
+
+AGLET_END
+
+#endif // __aglet_GLNamePool_h__
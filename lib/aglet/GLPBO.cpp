@@ -0,0 +1,214 @@
+/*!
+  @file   GLPBO.cpp
+  @brief  Implementation of pixel buffer objects for asynchronous pixel transfers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLPBO.h"
+
+#if defined(AGLET_HAS_PBO)
+
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+#include "aglet/GLTexture.h"
+#include "aglet/GLTrace.h"
+
+#include <cstring>
+
+AGLET_BEGIN
+
+IPBO::IPBO(std::size_t width, std::size_t height, GLenum format, GLenum type)
+    : width(width)
+    , height(height)
+    , format(format)
+    , type(type)
+{
+    pbo = GLNamePool::generate(GLNamePool::kBuffer);
+    checkGLError("IPBO::IPBO() : glGenBuffers()");
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, getSize(), 0, GL_DYNAMIC_READ);
+    checkGLError("IPBO::IPBO() : glBufferData()");
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    allocation = GLAllocation(GLMemory::kBuffer, getSize());
+}
+
+IPBO::~IPBO()
+{
+    if (pbo > 0)
+    {
+        owner.release(GLDeletionQueue::kBuffer, pbo, std::move(allocation));
+        pbo = 0;
+    }
+}
+
+std::size_t IPBO::getSize() const
+{
+    return width * height * getPixelSize(format, type);
+}
+
+bool IPBO::isReadingAsynchronously() const
+{
+    return isReadingAsynchronously_;
+}
+
+void IPBO::bind()
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+}
+
+void IPBO::unbind()
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void IPBO::start()
+{
+    start(0, 0);
+}
+
+void IPBO::start(GLint x, GLint y)
+{
+    AGLET_TRACE_GPU_SCOPE("IPBO::start", "transfer");
+    if (!isReadingAsynchronously_)
+    {
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        checkGLError("IPBO::start() : glReadBuffer()");
+
+        // Note glReadPixels last argument == 0 for PBO reads
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(x, y, GLsizei(width), GLsizei(height), format, type, 0);
+        checkGLError("IPBO::start() : glReadPixels()");
+
+        isReadingAsynchronously_ = true;
+    }
+}
+
+void IPBO::finish(GLubyte* buffer)
+{
+    finish(buffer, 0);
+}
+
+void IPBO::finish(GLubyte* buffer, std::size_t stride)
+{
+    AGLET_TRACE_SCOPE("IPBO::finish", "wait"); // mapping waits for the readback
+    if (isReadingAsynchronously_)
+    {
+#if defined(AGLET_OSX)
+        // Note: glMapBufferRange does not seem to work in OS X
+        GLubyte* ptr = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+#else
+        GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, getSize(), GL_MAP_READ_BIT));
+#endif
+        checkGLError("IPBO::finish() : glMapBufferRange()");
+
+        isReadingAsynchronously_ = false;
+        throw_assert(ptr, "IPBO::finish() : glMapBufferRange()"); // the frame is lost, don't report it as read
+
+        const std::size_t rowSize = width * getPixelSize(format, type);
+        copyRows(buffer, stride ? stride : rowSize, ptr, rowSize, rowSize, height);
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        checkGLError("IPBO::finish() : glUnmapBuffer()");
+    }
+}
+
+void IPBO::read(GLubyte* buffer)
+{
+    start();        // Use start() and
+    finish(buffer); // finish() pair for consistent internal state
+}
+
+// ::: output/write  :::
+
+OPBO::OPBO(std::size_t width, std::size_t height, GLenum format, GLenum type)
+    : width(width)
+    , height(height)
+    , format(format)
+    , type(type)
+{
+    pbo = GLNamePool::generate(GLNamePool::kBuffer);
+    checkGLError("OPBO::OPBO() : glGenBuffers()");
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, getSize(), 0, GL_STREAM_DRAW);
+    checkGLError("OPBO::OPBO() : glBufferData()");
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    allocation = GLAllocation(GLMemory::kBuffer, getSize());
+}
+
+OPBO::~OPBO()
+{
+    if (pbo > 0)
+    {
+        owner.release(GLDeletionQueue::kBuffer, pbo, std::move(allocation));
+        pbo = 0;
+    }
+}
+
+std::size_t OPBO::getSize() const
+{
+    return width * height * getPixelSize(format, type);
+}
+
+void OPBO::bind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+}
+
+void OPBO::unbind()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void OPBO::write(const GLubyte* buffer, GLuint texId)
+{
+    write(buffer, texId, 0);
+}
+
+void OPBO::write(const GLubyte* buffer, GLuint texId, std::size_t stride)
+{
+    write(buffer, texId, stride, 0, 0);
+}
+
+void OPBO::write(const GLubyte* buffer, GLuint texId, std::size_t stride, GLint x, GLint y)
+{
+    AGLET_TRACE_GPU_SCOPE("OPBO::write", "transfer");
+    const std::size_t pbo_size = getSize();
+
+    // Orphan the previous storage, so the upload doesn't wait for pending reads:
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size, NULL, GL_STREAM_DRAW);
+    checkGLError("OPBO::write() : glBufferData()");
+
+#if defined(AGLET_OSX)
+    // TODO: glMapBufferRange does not seem to work in OS X
+    GLubyte* ptr = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    checkGLError("OPBO::write() : glMapBuffer()");
+#else
+    GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pbo_size, GL_MAP_WRITE_BIT));
+    checkGLError("OPBO::write() : glMapBufferRange()");
+#endif
+    throw_assert(ptr, "OPBO::write() : glMapBufferRange()");
+
+    const std::size_t rowSize = width * getPixelSize(format, type);
+    copyRows(ptr, rowSize, buffer, stride ? stride : rowSize, rowSize, height);
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    checkGLError("OPBO::write() : glUnmapBuffer()");
+
+    glBindTexture(GL_TEXTURE_2D, texId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, GLsizei(width), GLsizei(height), format, type, 0);
+    checkGLError("OPBO::write() : glTexSubImage2D()");
+}
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_PBO)
@@ -0,0 +1,156 @@
+/*!
+  @file   GLPBO.h
+  @brief  Declaration of pixel buffer objects for asynchronous pixel transfers.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLPBO_h__
+#define __aglet_GLPBO_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLDeletionQueue.h"
+#include "aglet/GLMemory.h"
+
+#if defined(AGLET_HAS_PBO)
+
+#include <cstddef>
+
+AGLET_BEGIN
+
+class IPBO
+{
+public:
+    /**
+     * Constructor.
+     */
+    IPBO(std::size_t width, std::size_t height, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+    /**
+     * Destructor.
+     */
+    ~IPBO();
+
+    IPBO(const IPBO&) = delete;
+    IPBO& operator=(const IPBO&) = delete;
+
+    /**
+     * Bind the PBO (GL_PIXEL_PACK_BUFFER)
+     */
+    void bind();
+
+    /**
+     * Unbind the PBO (GL_PIXEL_PACK_BUFFER).
+     */
+    void unbind();
+
+    /**
+     * Start read operation (asynchronous/non-blocking).
+     */
+    void start(); // asynchronous
+
+    /**
+     * Start reading the width x height region at (x, y) (asynchronous/non-blocking).
+     */
+    void start(GLint x, GLint y); // asynchronous
+
+    /**
+     * Pack/read pixels to <buffer> (blocking call) after a call to start().
+     */
+    void finish(GLubyte* buffer); // asynchronous
+
+    /**
+     * Pack/read pixels to rows of <stride> bytes in <buffer> (blocking call) after a call to start().
+     */
+    void finish(GLubyte* buffer, std::size_t stride); // asynchronous
+
+    /**
+     * Perform a blocking pack from the PBO.
+     */
+    void read(GLubyte* buffer); // synchronous (start, finish)
+
+    /**
+     * Returns current processing state for asynchronous read.
+     */
+    bool isReadingAsynchronously() const;
+
+    /**
+     * Returns the size of the PBO in bytes.
+     */
+    std::size_t getSize() const;
+
+protected:
+    std::size_t width;                     // width of PBO
+    std::size_t height;                    // head of PBO
+    GLenum format;                         // pixel format
+    GLenum type;                           // pixel type
+    bool isReadingAsynchronously_ = false; // read state (async API)
+    GLuint pbo = 0;                        // ID of created PBO
+    GLAllocation allocation;               // GLMemory::kBuffer
+    GLOwner owner;
+};
+
+class OPBO
+{
+public:
+    /**
+     * Constructor.
+     */
+    OPBO(std::size_t width, std::size_t height, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+    /**
+     * Destructor.
+     */
+    ~OPBO();
+
+    OPBO(const OPBO&) = delete;
+    OPBO& operator=(const OPBO&) = delete;
+
+    /**
+     * Bind the PBO (GL_PIXEL_UNPACK_BUFFER)
+     */
+    void bind();
+
+    /**
+     * Unbind the PBO (GL_PIXEL_UNPACK_BUFFER)
+     */
+    void unbind();
+
+    /**
+     * Unpack/write pixels in <buffer> to texture <texId>.
+     */
+    void write(const GLubyte* buffer, GLuint texId = 0);
+
+    /**
+     * Unpack/write pixels in rows of <stride> bytes in <buffer> to texture <texId>.
+     */
+    void write(const GLubyte* buffer, GLuint texId, std::size_t stride);
+
+    /**
+     * Unpack/write pixels in rows of <stride> bytes in <buffer> to the width x height region at (x, y) of texture <texId>.
+     */
+    void write(const GLubyte* buffer, GLuint texId, std::size_t stride, GLint x, GLint y);
+
+    /**
+     * Returns the size of the PBO in bytes.
+     */
+    std::size_t getSize() const;
+
+protected:
+    std::size_t width;  // width of PBO
+    std::size_t height; // head of PBO
+    GLenum format;      // pixel format
+    GLenum type;             // pixel type
+    GLuint pbo = 0;          // ID of created PBO
+    GLAllocation allocation; // GLMemory::kBuffer
+    GLOwner owner;
+};
+
+AGLET_END
+
+#endif // defined(AGLET_HAS_PBO)
+
+#endif // __aglet_GLPBO_h__
@@ -0,0 +1,186 @@
+/*!
+  @file   GLPackedReader.cpp
+  @brief  Implementation of reduced bandwidth readback through GPU side packing.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLPackedReader.h"
+#include "aglet/GLError.h"
+#include "aglet/GLPBO.h"
+
+#include <sstream>
+#include <string>
+
+AGLET_BEGIN
+
+// clang-format off
+static const char* kPackSrc =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "precision highp sampler2D;\n"
+    "#endif\n"
+    "uniform sampler2D uInputTex;\n"
+    "uniform vec2 uSize;\n"   // input size (pixels)
+    "uniform vec3 uLuma;\n"   // Kr, Kg, Kb
+    "uniform vec2 uChroma;\n" // 1 / (2 (1 - Kb)), 1 / (2 (1 - Kr))
+    "uniform vec3 uScale;\n"  // Y, U, V
+    "uniform vec3 uOffset;\n" // Y, U, V
+    "vec4 fetch(float x, float y) {\n"
+    "    return texture2D(uInputTex, (vec2(x, y) + 0.5) / uSize);\n"
+    "}\n"
+    "float luma(vec4 c) {\n"
+    "    return dot(c.rgb, uLuma) * uScale.x + uOffset.x;\n"
+    "}\n"
+    "vec2 chroma(vec4 c) {\n"
+    "    float y = dot(c.rgb, uLuma);\n"
+    "    return vec2(c.b - y, c.r - y) * uChroma * uScale.yz + uOffset.yz;\n"
+    "}\n"
+    "void main() {\n"
+    "    vec2 q = floor(gl_FragCoord.xy);\n"
+    "    float x = q.x * 4.0;\n"
+    "#if LAYOUT == 0\n"
+    "    gl_FragColor = vec4(fetch(x, q.y).r, fetch(x + 1.0, q.y).r, fetch(x + 2.0, q.y).r, fetch(x + 3.0, q.y).r);\n"
+    "#elif LAYOUT == 1\n"
+    "    gl_FragColor = vec4(luma(fetch(x, q.y)), luma(fetch(x + 1.0, q.y)), luma(fetch(x + 2.0, q.y)), luma(fetch(x + 3.0, q.y)));\n"
+    "#elif LAYOUT == 2\n"
+    "    if (q.y < uSize.y) {\n"
+    "        gl_FragColor = vec4(luma(fetch(x, q.y)), luma(fetch(x + 1.0, q.y)), luma(fetch(x + 2.0, q.y)), luma(fetch(x + 3.0, q.y)));\n"
+    "    } else {\n" // two 2x2 blocks per texel
+    "        float y = (q.y - uSize.y) * 2.0;\n"
+    "        vec4 c0 = (fetch(x, y) + fetch(x + 1.0, y) + fetch(x, y + 1.0) + fetch(x + 1.0, y + 1.0)) * 0.25;\n"
+    "        vec4 c1 = (fetch(x + 2.0, y) + fetch(x + 3.0, y) + fetch(x + 2.0, y + 1.0) + fetch(x + 3.0, y + 1.0)) * 0.25;\n"
+    "        gl_FragColor = vec4(chroma(c0), chroma(c1));\n"
+    "    }\n"
+    "#else\n"
+    "    gl_FragColor = fetch(q.x, q.y);\n"
+    "#endif\n"
+    "}\n";
+// clang-format on
+
+GLPackedReader::GLPackedReader(int width, int height, Layout layout, GLYUV::ColorSpace colorSpace, GLYUV::Range range)
+    : m_width(width)
+    , m_height(height)
+    , m_layout(layout)
+{
+    throw_assert((width > 0) && (height > 0), "GLPackedReader::GLPackedReader() : invalid size");
+
+    if (layout == kHalfFloat)
+    {
+#if defined(AGLET_OPENGL_ES2) || !defined(GL_RGBA16F)
+        throw_assert(false, "GLPackedReader::GLPackedReader() : kHalfFloat is not supported");
+#else
+        throw_assert(hasFloatRenderTargets(), "GLPackedReader::GLPackedReader() : no float render targets");
+        m_type = GL_HALF_FLOAT;
+        m_packed.reset(new GLTexture(width, height, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT));
+        m_packed->setFilter(GL_NEAREST);
+#endif
+    }
+    else
+    {
+        throw_assert((width % 4) == 0, "GLPackedReader::GLPackedReader() : width must be a multiple of 4");
+        throw_assert((layout != kNV12) || ((height % 2) == 0), "GLPackedReader::GLPackedReader() : NV12 requires an even height");
+        m_packed.reset(new GLTexture(width / 4, (layout == kNV12) ? (height + height / 2) : height));
+    }
+
+    m_fbo.bind();
+    m_fbo.attach(*m_packed);
+#if defined(AGLET_OPENGL_ES3)
+    if (layout == kHalfFloat)
+    {
+        // OpenGL ES only guarantees GL_RGBA/GL_FLOAT for float color buffers:
+        GLint format = 0, type = 0;
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &format);
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &type);
+        throw_assert((format == GL_RGBA) && (type == GL_HALF_FLOAT), "GLPackedReader::GLPackedReader() : no GL_HALF_FLOAT readback");
+    }
+#endif
+    m_fbo.unbind();
+
+    std::stringstream ss;
+    ss << "#define LAYOUT " << int(layout) << "\n"
+       << kPackSrc;
+    const std::string fshSrc = ss.str();
+    auto status = m_shader.buildFromSrc(GLQuad::getVertexShader(), fshSrc.c_str(), GLQuad::getAttributes());
+    throw_assert(status, "GLPackedReader::GLPackedReader() : GLShader::buildFromSrc()");
+
+    // Forward transform of GLYUV::getConversion():
+    const float kr = (colorSpace == GLYUV::kBT709) ? 0.2126f : 0.299f;
+    const float kb = (colorSpace == GLYUV::kBT709) ? 0.0722f : 0.114f;
+    const float ys = (range == GLYUV::kVideo) ? (219.f / 255.f) : 1.f;
+    const float cs = (range == GLYUV::kVideo) ? (224.f / 255.f) : 1.f;
+    const float yo = (range == GLYUV::kVideo) ? (16.f / 255.f) : 0.f;
+
+    const GLuint program = m_shader.getProgramId();
+    m_shader.use();
+    glUniform1i(glGetUniformLocation(program, "uInputTex"), 0);
+    glUniform2f(glGetUniformLocation(program, "uSize"), GLfloat(width), GLfloat(height));
+    glUniform3f(glGetUniformLocation(program, "uLuma"), kr, 1.f - kr - kb, kb);
+    glUniform2f(glGetUniformLocation(program, "uChroma"), 0.5f / (1.f - kb), 0.5f / (1.f - kr));
+    glUniform3f(glGetUniformLocation(program, "uScale"), ys, cs, cs);
+    glUniform3f(glGetUniformLocation(program, "uOffset"), yo, 128.f / 255.f, 128.f / 255.f);
+    glUseProgram(0);
+
+#if defined(AGLET_HAS_PBO)
+    m_pbo.reset(new IPBO(m_packed->getWidth(), m_packed->getHeight(), GL_RGBA, m_type));
+#endif
+
+    checkGLError("GLPackedReader::GLPackedReader() : glUniform3f()");
+}
+
+GLPackedReader::~GLPackedReader() = default;
+
+std::size_t GLPackedReader::getSize() const
+{
+    return m_packed->getWidth() * m_packed->getHeight() * getPixelSize(GL_RGBA, m_type);
+}
+
+void GLPackedReader::start(GLuint texture)
+{
+    m_fbo.bind();
+    glViewport(0, 0, getPackedWidth(), getPackedHeight());
+    m_shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    m_quad.bind();
+    m_quad.draw();
+    m_quad.unbind();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+
+#if defined(AGLET_HAS_PBO)
+    m_pbo->bind();
+    m_pbo->start();
+    m_pbo->unbind();
+#endif
+
+    m_fbo.unbind();
+    checkGLError("GLPackedReader::start() : glDrawArrays()");
+}
+
+void GLPackedReader::finish(void* data)
+{
+#if defined(AGLET_HAS_PBO)
+    m_pbo->bind();
+    m_pbo->finish(static_cast<GLubyte*>(data));
+    m_pbo->unbind();
+#else
+    m_fbo.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, getPackedWidth(), getPackedHeight(), GL_RGBA, m_type, data);
+    m_fbo.unbind();
+    checkGLError("GLPackedReader::finish() : glReadPixels()");
+#endif
+}
+
+void GLPackedReader::read(GLuint texture, void* data)
+{
+    start(texture);
+    finish(data);
+}
+
+AGLET_END
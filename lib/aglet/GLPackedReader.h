@@ -0,0 +1,102 @@
+/*!
+  @file   GLPackedReader.h
+  @brief  Declaration of reduced bandwidth readback through GPU side packing.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLPackedReader_h__
+#define __aglet_GLPackedReader_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTexture.h"
+#include "aglet/GLYUV.h"
+
+#include <memory>
+
+AGLET_BEGIN
+
+class IPBO;
+
+/*
+ * Read a width x height RGBA texture back in a compact layout: one pass
+ * packs the texture on the GPU, then only the packed bytes are read:
+ *
+ *   kRed       : R channel, 1 byte per pixel (i.e., masks)
+ *   kLuma      : Y = Kr R + Kg G + Kb B, 1 byte per pixel
+ *   kNV12      : Y plane followed by interleaved UV at half resolution, 1.5 bytes per pixel
+ *   kHalfFloat : RGBA16F, 8 bytes per pixel instead of 16 for RGBA32F
+ *
+ * Byte layouts pack 4 pixels per RGBA8 texel, so they work with the
+ * GL_RGBA/GL_UNSIGNED_BYTE readback every OpenGL ES 2.0 implementation
+ * supports, and require a width that is a multiple of 4 (kNV12 also
+ * requires an even height).  kHalfFloat requires float render targets
+ * and half float readback (not available on OpenGL ES 2.0).
+ *
+ *   aglet::GLPackedReader reader(width, height, aglet::GLPackedReader::kNV12);
+ *   std::vector<GLubyte> nv12(reader.getSize());
+ *   reader.start(texture); // pack + asynchronous readback (PBO)
+ *   ...
+ *   reader.finish(nv12.data());
+ *
+ * Rows are in texture order (row 0 is the first row uploaded).
+ */
+
+class GLPackedReader
+{
+public:
+    enum Layout
+    {
+        kRed,
+        kLuma,
+        kNV12,
+        kHalfFloat
+    };
+
+    GLPackedReader(int width, int height, Layout layout, GLYUV::ColorSpace colorSpace = GLYUV::kBT601, GLYUV::Range range = GLYUV::kVideo);
+    ~GLPackedReader();
+
+    // Pack texture and start the readback (non-blocking where PBOs are available):
+    void start(GLuint texture);
+
+    // Wait for the packed data (getSize() bytes) from the last start():
+    void finish(void* data);
+
+    // Synchronous readback (start + finish):
+    void read(GLuint texture, void* data);
+
+    // Size of the packed data in bytes:
+    std::size_t getSize() const;
+
+    Layout getLayout() const { return m_layout; }
+
+    // Packed texture and its size in texels:
+    GLuint getTexture() const { return *m_packed; }
+    int getPackedWidth() const { return int(m_packed->getWidth()); }
+    int getPackedHeight() const { return int(m_packed->getHeight()); }
+
+protected:
+    int m_width = 0;
+    int m_height = 0;
+    Layout m_layout = kLuma;
+    GLenum m_type = GL_UNSIGNED_BYTE;
+
+    std::unique_ptr<GLTexture> m_packed;
+    GLFrameBufferObject m_fbo;
+    GLQuad m_quad;
+    GLShader m_shader;
+
+#if defined(AGLET_HAS_PBO)
+    std::unique_ptr<IPBO> m_pbo;
+#endif
+};
+
+AGLET_END
+
+#endif // __aglet_GLPackedReader_h__
@@ -0,0 +1,243 @@
+/*!
+  @file   GLPyramid.cpp
+  @brief  Implementation of a GPU image pyramid packed in a single atlas texture.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLPyramid.h"
+#include "aglet/GLError.h"
+#include "aglet/GLPBO.h"
+
+#include <algorithm>
+
+AGLET_BEGIN
+
+// clang-format off
+static const char* kBoxSrc =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "#endif\n"
+    "varying vec2 vTexCoord;\n"
+    "uniform sampler2D uInputTex;\n"
+    "void main() {\n" // bilinear tap between the 2x2 source texels
+    "    gl_FragColor = texture2D(uInputTex, vTexCoord);\n"
+    "}\n";
+
+static const char* kGaussianSrc =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "#endif\n"
+    "varying vec2 vTexCoord;\n"
+    "uniform sampler2D uInputTex;\n"
+    "uniform vec2 uTexelSize;\n" // source texel size
+    "void main() {\n"
+    "    vec4 w = vec4(1.0, 3.0, 3.0, 1.0) / 8.0;\n"
+    "    vec4 color = vec4(0.0);\n"
+    "    for (int j = 0; j < 4; j++) {\n"
+    "        for (int i = 0; i < 4; i++) {\n"
+    "            vec2 offset = (vec2(float(i), float(j)) - 1.5) * uTexelSize;\n"
+    "            color += texture2D(uInputTex, vTexCoord + offset) * (w[i] * w[j]);\n"
+    "        }\n"
+    "    }\n"
+    "    gl_FragColor = color;\n"
+    "}\n";
+// clang-format on
+
+static std::vector<GLPyramid::Rect> getLevels(int width, int height, int levels)
+{
+    throw_assert((width > 0) && (height > 0) && (levels > 0), "GLPyramid::GLPyramid() : invalid size");
+
+    std::vector<GLPyramid::Rect> rects;
+    GLPyramid::Rect rect;
+    rect.width = width;
+    rect.height = height;
+    rects.push_back(rect);
+
+    rect.x = width;
+    while ((int(rects.size()) < levels) && ((rect.width > 1) || (rect.height > 1)))
+    {
+        rect.width = std::max(rect.width / 2, 1);
+        rect.height = std::max(rect.height / 2, 1);
+        rects.push_back(rect);
+        rect.y += rect.height;
+    }
+    return rects;
+}
+
+static int getAtlasCols(const std::vector<GLPyramid::Rect>& levels)
+{
+    return levels[0].width + ((levels.size() > 1) ? levels[1].width : 0);
+}
+
+static int getAtlasRows(const std::vector<GLPyramid::Rect>& levels)
+{
+    return std::max(levels[0].height, levels.back().y + levels.back().height);
+}
+
+GLPyramid::GLPyramid(int width, int height, int levels, Filter filter)
+    : m_filter(filter)
+    , m_levels(getLevels(width, height, levels))
+    , m_atlas(getAtlasCols(m_levels), getAtlasRows(m_levels))
+{
+    m_atlasWidth = int(m_atlas.getWidth());
+    m_atlasHeight = int(m_atlas.getHeight());
+
+    m_atlasFbo.bind();
+    m_atlasFbo.attach(m_atlas);
+    glClearColor(0.f, 0.f, 0.f, 0.f); // unused atlas area
+    glClear(GL_COLOR_BUFFER_BIT);
+    m_atlasFbo.unbind();
+
+#if defined(AGLET_OPENGL_ES2)
+    m_isMipmapped = false; // no framebuffer attachment of levels > 0
+#else
+    m_isMipmapped = (filter == kBox);
+#endif
+
+    if (m_isMipmapped)
+    {
+        m_mipmap.reset(new GLTexture(width, height));
+        m_mipmap->bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+        glGenerateMipmap(GL_TEXTURE_2D); // allocate the chain
+        m_mipmap->unbind();
+    }
+    else
+    {
+        m_shader.reset(new GLShader);
+        auto status = m_shader->buildFromSrc(GLQuad::getVertexShader(), (filter == kBox) ? kBoxSrc : kGaussianSrc, GLQuad::getAttributes());
+        throw_assert(status, "GLPyramid::GLPyramid() : GLShader::buildFromSrc()");
+
+        const GLuint program = m_shader->getProgramId();
+        m_shader->use();
+        glUniform1i(glGetUniformLocation(program, "uInputTex"), 0);
+        m_texelSize = glGetUniformLocation(program, "uTexelSize");
+        glUseProgram(0);
+
+        for (std::size_t i = 1; i < m_levels.size(); i++)
+        {
+            m_textures.emplace_back(new GLTexture(m_levels[i].width, m_levels[i].height));
+            m_fbos.emplace_back(new GLFrameBufferObject);
+            m_fbos.back()->bind();
+            m_fbos.back()->attach(*m_textures.back());
+            m_fbos.back()->unbind();
+        }
+    }
+
+#if defined(AGLET_HAS_PBO)
+    m_pbo.reset(new IPBO(m_atlasWidth, m_atlasHeight));
+#endif
+
+    checkGLError("GLPyramid::GLPyramid() : glGenerateMipmap()");
+}
+
+GLPyramid::~GLPyramid() = default;
+
+void GLPyramid::copy(std::size_t level)
+{
+    const auto& rect = m_levels[level];
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, 0, 0, rect.width, rect.height);
+}
+
+GLuint GLPyramid::operator()(GLuint texture)
+{
+    // Level 0 is the input:
+    m_readFbo.bind();
+    m_readFbo.attach(texture);
+    m_atlas.bind();
+    copy(0);
+
+    if (m_isMipmapped)
+    {
+        buildMipmap();
+    }
+    else
+    {
+        buildShader(texture);
+    }
+
+    m_atlas.unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    checkGLError("GLPyramid::operator()() : glCopyTexSubImage2D()");
+    return m_atlas;
+}
+
+// Read framebuffer is the input texture, the atlas is bound:
+void GLPyramid::buildMipmap()
+{
+    m_mipmap->bind();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, m_levels[0].width, m_levels[0].height);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    m_atlas.bind();
+    for (std::size_t i = 1; i < m_levels.size(); i++)
+    {
+        m_readFbo.attach(*m_mipmap, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, GLint(i));
+        copy(i);
+    }
+}
+
+// Read framebuffer is the input texture, the atlas is bound:
+void GLPyramid::buildShader(GLuint texture)
+{
+    m_quad.bind();
+    m_shader->use();
+    glActiveTexture(GL_TEXTURE0);
+
+    GLuint input = texture;
+    for (std::size_t i = 1; i < m_levels.size(); i++)
+    {
+        const auto& source = m_levels[i - 1];
+        const auto& rect = m_levels[i];
+
+        m_fbos[i - 1]->bind();
+        glViewport(0, 0, rect.width, rect.height);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glUniform2f(m_texelSize, 1.f / GLfloat(source.width), 1.f / GLfloat(source.height));
+        m_quad.draw();
+
+        m_atlas.bind();
+        copy(i);
+
+        input = *m_textures[i - 1];
+    }
+
+    m_quad.unbind();
+    glUseProgram(0);
+}
+
+void GLPyramid::start()
+{
+#if defined(AGLET_HAS_PBO)
+    m_atlasFbo.bind();
+    m_pbo->bind();
+    m_pbo->start();
+    m_pbo->unbind();
+    m_atlasFbo.unbind();
+#endif
+}
+
+void GLPyramid::finish(GLubyte* pixels)
+{
+#if defined(AGLET_HAS_PBO)
+    m_pbo->bind();
+    m_pbo->finish(pixels);
+    m_pbo->unbind();
+#else
+    m_atlasFbo.bind();
+    m_atlas.read(pixels);
+    m_atlasFbo.unbind();
+#endif
+}
+
+void GLPyramid::read(GLubyte* pixels)
+{
+    start();
+    finish(pixels);
+}
+
+AGLET_END
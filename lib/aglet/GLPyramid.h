@@ -0,0 +1,131 @@
+/*!
+  @file   GLPyramid.h
+  @brief  Declaration of a GPU image pyramid packed in a single atlas texture.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLPyramid_h__
+#define __aglet_GLPyramid_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTexture.h"
+
+#include <memory>
+#include <vector>
+
+AGLET_BEGIN
+
+class IPBO;
+
+/*
+ * Build an RGBA pyramid on the GPU and read all levels back with one
+ * (asynchronous) transfer:
+ *
+ *   aglet::GLPyramid pyramid(width, height, 4, aglet::GLPyramid::kGaussian);
+ *   pyramid(texture);       // build the levels into the atlas
+ *   pyramid.start();        // one readback for all levels
+ *   ...                     // other work
+ *   pyramid.finish(pixels); // getAtlasWidth() * getAtlasHeight() RGBA
+ *
+ * Level sizes follow the mip chain (max(1, size / 2)).  Level 0 is at the
+ * atlas origin and levels 1...N-1 are stacked in a column to its right:
+ *
+ *   +---------+-----+
+ *   |         |  1  |
+ *   |    0    +--+--+
+ *   |         |2 |
+ *   +---------+--+
+ *
+ * so pixel (x, y) of level i is pixels[(rect.y + y) * atlasWidth + rect.x + x]
+ * with rect = getLevel(i).
+ *
+ * kBox levels are produced by glGenerateMipmap when mipmap levels can be
+ * attached to a framebuffer (OpenGL ES 3.0, desktop), kGaussian levels
+ * (and kBox on OpenGL ES 2.0) by one 4x4 tap shader pass per level with
+ * the binomial kernel [1 3 3 1] / 8.  Levels are copied to the atlas with
+ * glCopyTexSubImage2D, so nothing leaves the GPU before start().
+ */
+
+class GLPyramid
+{
+public:
+    enum Filter
+    {
+        kBox,
+        kGaussian
+    };
+
+    struct Rect
+    {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Number of levels is clamped to the full mip chain:
+    GLPyramid(int width, int height, int levels, Filter filter = kBox);
+    ~GLPyramid();
+
+    // Build all levels of texture (width x height RGBA), return the atlas:
+    GLuint operator()(GLuint texture);
+
+    // Start reading the atlas back (non-blocking where PBOs are available):
+    void start();
+
+    // Wait for the atlas pixels from the last start():
+    void finish(GLubyte* pixels);
+
+    // Synchronous readback (start + finish):
+    void read(GLubyte* pixels);
+
+    std::size_t getLevelCount() const { return m_levels.size(); }
+    const Rect& getLevel(std::size_t level) const { return m_levels[level]; }
+
+    int getAtlasWidth() const { return m_atlasWidth; }
+    int getAtlasHeight() const { return m_atlasHeight; }
+    GLuint getAtlas() const { return m_atlas; }
+
+    // True if levels are produced by glGenerateMipmap:
+    bool isMipmapped() const { return m_isMipmapped; }
+
+protected:
+    void buildMipmap();
+    void buildShader(GLuint texture);
+    void copy(std::size_t level); // read framebuffer -> atlas rect
+
+    Filter m_filter = kBox;
+    bool m_isMipmapped = false;
+    int m_atlasWidth = 0;
+    int m_atlasHeight = 0;
+    std::vector<Rect> m_levels;
+
+    GLTexture m_atlas;
+    GLFrameBufferObject m_atlasFbo;
+    GLFrameBufferObject m_readFbo;
+
+    // kBox + mipmap: texture with the full mip chain
+    std::unique_ptr<GLTexture> m_mipmap;
+
+    // Shader passes: one texture per level > 0
+    GLQuad m_quad;
+    std::unique_ptr<GLShader> m_shader;
+    GLint m_texelSize = -1;
+    std::vector<std::unique_ptr<GLTexture>> m_textures;
+    std::vector<std::unique_ptr<GLFrameBufferObject>> m_fbos;
+
+#if defined(AGLET_HAS_PBO)
+    std::unique_ptr<IPBO> m_pbo;
+#endif
+};
+
+AGLET_END
+
+#endif // __aglet_GLPyramid_h__
@@ -0,0 +1,92 @@
+/*!
+  @file   GLQuad.cpp
+  @brief  Implementation of a full screen quad for fragment shader passes.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLQuad.h"
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+
+AGLET_BEGIN
+
+// clang-format off
+static const char* kVertexShaderSrc =
+    "attribute vec4 aPos;\n"
+    "attribute vec2 aTexCoord;\n"
+    "varying vec2 vTexCoord;\n"
+    "void main() {\n"
+    "    gl_Position = aPos;\n"
+    "    vTexCoord = aTexCoord;\n"
+    "}\n";
+
+// Interleaved position (xy) and texture coordinates (uv) for a triangle strip:
+static const GLfloat kQuad[] = {
+    -1.f, -1.f, 0.f, 0.f,
+    +1.f, -1.f, 1.f, 0.f,
+    -1.f, +1.f, 0.f, 1.f,
+    +1.f, +1.f, 1.f, 1.f
+};
+// clang-format on
+
+GLQuad::GLQuad()
+{
+    m_vbo = GLNamePool::generate(GLNamePool::kBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kQuad), kQuad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    checkGLError("GLQuad::GLQuad() : glBufferData()");
+}
+
+GLQuad::~GLQuad()
+{
+    if (m_vbo > 0)
+    {
+        m_owner.release(GLDeletionQueue::kBuffer, m_vbo);
+        m_vbo = 0;
+    }
+}
+
+const char* GLQuad::getVertexShader()
+{
+    return kVertexShaderSrc;
+}
+
+const GLShader::Attributes& GLQuad::getAttributes()
+{
+    static const GLShader::Attributes attributes = { { 0, "aPos" }, { 1, "aTexCoord" } };
+    return attributes;
+}
+
+void GLQuad::bind()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const GLvoid*)(0));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+}
+
+void GLQuad::draw()
+{
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+void GLQuad::draw(GLsizei count)
+{
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+}
+#endif
+
+void GLQuad::unbind()
+{
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+AGLET_END
@@ -0,0 +1,58 @@
+/*!
+  @file   GLQuad.h
+  @brief  Declaration of a full screen quad for fragment shader passes.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLQuad_h__
+#define __aglet_GLQuad_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLShader.h"
+
+AGLET_BEGIN
+
+/*
+ * Full screen triangle strip with positions at attribute 0 (aPos) and
+ * texture coordinates at attribute 1 (aTexCoord):
+ *
+ *   shader.buildFromSrc(GLQuad::getVertexShader(), fshSrc, GLQuad::getAttributes());
+ *   quad.bind();
+ *   quad.draw(); // per pass
+ *   quad.unbind();
+ */
+
+class GLQuad
+{
+public:
+    GLQuad();
+    ~GLQuad();
+
+    GLQuad(const GLQuad&) = delete;
+    GLQuad& operator=(const GLQuad&) = delete;
+
+    void bind();
+    void draw();
+    void unbind();
+
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+    // One draw of count instances (gl_InstanceID):
+    void draw(GLsizei count);
+#endif
+
+    // Vertex shader: aPos, aTexCoord -> varying vec2 vTexCoord
+    static const char* getVertexShader();
+    static const GLShader::Attributes& getAttributes();
+
+protected:
+    GLuint m_vbo = 0;
+    GLOwner m_owner;
+};
+
+AGLET_END
+
+#endif // __aglet_GLQuad_h__
@@ -0,0 +1,263 @@
+/*!
+  @file   GLReduction.cpp
+  @brief  Implementation of on-GPU reductions with tiny (asynchronous) readbacks.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLReduction.h"
+#include "aglet/GLError.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLPBO.h"
+#include "aglet/GLTexture.h"
+
+#include <sstream>
+#include <string>
+
+AGLET_BEGIN
+
+// clang-format off
+static const char* kReductionSrc =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "precision highp sampler2D;\n" // default lowp may be fp16
+    "#endif\n"
+    "uniform sampler2D uInputTex;\n"
+    "uniform vec2 uInputSize;\n" // input level size (texels)
+    "uniform vec2 uImageSize;\n" // image size (pixels)
+    "uniform float uBlock;\n"    // image pixels per input texel (per axis)
+    "void main() {\n"
+    "    vec2 origin = floor(gl_FragCoord.xy) * 4.0;\n"
+    "    vec4 result = INIT;\n"
+    "    float total = 0.0;\n"
+    "    for (int j = 0; j < 4; j++) {\n"
+    "        for (int i = 0; i < 4; i++) {\n"
+    "            vec2 p = origin + vec2(float(i), float(j));\n"
+    "            if (p.x < uInputSize.x && p.y < uInputSize.y) {\n"
+    "                vec4 value = texture2D(uInputTex, (p + 0.5) / uInputSize);\n"
+    "                vec2 extent = min(vec2(uBlock), uImageSize - p * uBlock);\n"
+    "                float weight = extent.x * extent.y;\n"
+    "                ACCUMULATE;\n"
+    "                total += weight;\n"
+    "            }\n"
+    "        }\n"
+    "    }\n"
+    "    gl_FragColor = RESULT;\n"
+    "}\n";
+// clang-format on
+
+static std::string getReductionShader(GLReduction::Operation operation)
+{
+    std::string defines;
+    switch (operation)
+    {
+        case GLReduction::kMean:
+        case GLReduction::kSum:
+            defines = "#define INIT vec4(0.0)\n#define ACCUMULATE result += value * weight\n#define RESULT (result / total)\n";
+            break;
+        case GLReduction::kMin:
+            defines = "#define INIT vec4(1e30)\n#define ACCUMULATE result = min(result, value)\n#define RESULT result\n";
+            break;
+        case GLReduction::kMax:
+            defines = "#define INIT vec4(-1e30)\n#define ACCUMULATE result = max(result, value)\n#define RESULT result\n";
+            break;
+    }
+    return defines + kReductionSrc;
+}
+
+struct GLReduction::Level
+{
+    Level(int width, int height, bool isFloat)
+        : width(width)
+        , height(height)
+        , texture(isFloat ? makeFloatTexture(width, height) : new GLTexture(width, height))
+    {
+        texture->setFilter(GL_NEAREST);
+        fbo.bind();
+        fbo.attach(*texture);
+        fbo.unbind();
+    }
+
+    static GLTexture* makeFloatTexture(int width, int height)
+    {
+#if defined(GL_RGBA32F)
+        return new GLTexture(width, height, GL_RGBA32F, GL_RGBA, GL_FLOAT);
+#else
+        throw_assert(false, "GLReduction::Level::makeFloatTexture() : GL_RGBA32F is unavailable");
+#endif
+    }
+
+    int width;
+    int height;
+    std::unique_ptr<GLTexture> texture;
+    GLFrameBufferObject fbo;
+};
+
+GLReduction::GLReduction(int width, int height, Operation operation)
+    : m_width(width)
+    , m_height(height)
+    , m_operation(operation)
+    , m_isFloat(hasFloatRenderTargets())
+{
+    throw_assert((width > 0) && (height > 0), "GLReduction::GLReduction() : invalid size");
+
+    const auto fshSrc = getReductionShader(operation);
+    auto status = m_shader.buildFromSrc(GLQuad::getVertexShader(), fshSrc.c_str(), GLQuad::getAttributes());
+    throw_assert(status, "GLReduction::GLReduction() : GLShader::buildFromSrc()");
+
+    const GLuint program = m_shader.getProgramId();
+    m_shader.use();
+    glUniform1i(glGetUniformLocation(program, "uInputTex"), 0);
+    glUniform2f(glGetUniformLocation(program, "uImageSize"), GLfloat(width), GLfloat(height));
+    m_inputSize = glGetUniformLocation(program, "uInputSize");
+    m_block = glGetUniformLocation(program, "uBlock");
+    glUseProgram(0);
+
+    // log4(max(width, height)) levels, at least one (readback target):
+    do
+    {
+        width = (width + 3) / 4;
+        height = (height + 3) / 4;
+        m_levels.emplace_back(new Level(width, height, m_isFloat));
+    } while ((width > 1) || (height > 1));
+
+#if defined(AGLET_HAS_PBO)
+    m_pbo.reset(new IPBO(1, 1, GL_RGBA, m_isFloat ? GL_FLOAT : GL_UNSIGNED_BYTE));
+#endif
+
+    checkGLError("GLReduction::GLReduction() : glUniform1i()");
+}
+
+GLReduction::~GLReduction() = default;
+
+void GLReduction::start(GLuint texture)
+{
+    m_quad.bind();
+    m_shader.use();
+    glActiveTexture(GL_TEXTURE0);
+
+    GLfloat block = 1.f;
+    GLuint input = texture;
+    int inputWidth = m_width, inputHeight = m_height;
+    for (auto& level : m_levels)
+    {
+        level->fbo.bind();
+        glViewport(0, 0, level->width, level->height);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glUniform2f(m_inputSize, GLfloat(inputWidth), GLfloat(inputHeight));
+        glUniform1f(m_block, block);
+        m_quad.draw();
+
+        input = *level->texture;
+        inputWidth = level->width;
+        inputHeight = level->height;
+        block *= 4.f;
+    }
+    m_quad.unbind();
+
+#if defined(AGLET_HAS_PBO)
+    m_pbo->bind();
+    m_pbo->start();
+    m_pbo->unbind();
+#else
+    GLubyte pixel[sizeof(GLfloat) * 4] = {};
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, 1, 1, GL_RGBA, m_isFloat ? GL_FLOAT : GL_UNSIGNED_BYTE, pixel);
+    for (int i = 0; i < 4; i++)
+    {
+        m_value[i] = m_isFloat ? reinterpret_cast<const GLfloat*>(pixel)[i] : (float(pixel[i]) / 255.f);
+    }
+#endif
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+
+    checkGLError("GLReduction::start() : glReadPixels()");
+}
+
+auto GLReduction::finish() -> Value
+{
+#if defined(AGLET_HAS_PBO)
+    if (m_pbo->isReadingAsynchronously())
+    {
+        GLubyte pixel[sizeof(GLfloat) * 4] = {};
+        m_pbo->bind();
+        m_pbo->finish(pixel);
+        m_pbo->unbind();
+        for (int i = 0; i < 4; i++)
+        {
+            m_value[i] = m_isFloat ? reinterpret_cast<const GLfloat*>(pixel)[i] : (float(pixel[i]) / 255.f);
+        }
+    }
+#endif
+
+    Value value = m_value;
+    if (m_operation == kSum)
+    {
+        for (auto& channel : value)
+        {
+            channel *= float(m_width) * float(m_height);
+        }
+    }
+    return value;
+}
+
+#if defined(AGLET_HAS_COMPUTE)
+
+static std::string getHistogramShader(GLuint bins, int channel)
+{
+    const auto localSize = GLComputeProgram::getDefaultLocalSize(2);
+    std::stringstream ss;
+    ss << GLComputeProgram::getVersionDeclaration()
+       << GLComputeProgram::getLocalSizeDeclaration(localSize)
+       << "uniform highp sampler2D uInputTex;\n"
+       << "uniform ivec2 uSize;\n"
+       << "layout(std430, binding = 0) buffer Histogram { uint bins[" << bins << "]; };\n"
+       << "void main() {\n"
+       << "    ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+       << "    if (p.x < uSize.x && p.y < uSize.y) {\n"
+       << "        float value = texelFetch(uInputTex, p, 0)[" << channel << "];\n"
+       << "        atomicAdd(bins[uint(clamp(value * " << bins << ".0, 0.0, " << (bins - 1) << ".0))], 1u);\n"
+       << "    }\n"
+       << "}\n";
+    return ss.str();
+}
+
+GLHistogram::GLHistogram(GLuint bins, int channel)
+    : m_bins(bins)
+    , m_program(getHistogramShader(bins, channel))
+    , m_buffer(GL_SHADER_STORAGE_BUFFER, bins * sizeof(GLuint), GL_DYNAMIC_READ)
+{
+    throw_assert((channel >= 0) && (channel < 4), "GLHistogram::GLHistogram() : invalid channel " << channel);
+}
+
+void GLHistogram::start(GLuint texture, int width, int height)
+{
+    const std::vector<GLuint> zeros(m_bins, 0);
+    m_buffer.write(zeros.data(), zeros.size() * sizeof(GLuint));
+
+    m_program.use();
+    glUniform2i(m_program.getUniform("uSize"), width, height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    GLComputeProgram::bindStorageBuffer(0, m_buffer);
+    m_program.run(GLuint(width), GLuint(height), 1, &m_barrier);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    checkGLError("GLHistogram::start() : glDispatchCompute()");
+}
+
+std::vector<GLuint> GLHistogram::finish()
+{
+    std::vector<GLuint> bins(m_bins, 0);
+    m_barrier.read(GL_BUFFER_UPDATE_BARRIER_BIT);
+    m_buffer.read(bins.data(), bins.size() * sizeof(GLuint));
+    return bins;
+}
+
+#endif // defined(AGLET_HAS_COMPUTE)
+
+AGLET_END
@@ -0,0 +1,147 @@
+/*!
+  @file   GLReduction.h
+  @brief  Declaration of on-GPU reductions with tiny (asynchronous) readbacks.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLReduction_h__
+#define __aglet_GLReduction_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+
+#if defined(AGLET_HAS_COMPUTE)
+#include "aglet/GLBuffer.h"
+#include "aglet/GLComputeProgram.h"
+#endif
+
+#include <array>
+#include <memory>
+#include <vector>
+
+AGLET_BEGIN
+
+class GLTexture;
+class GLFrameBufferObject;
+class IPBO;
+
+/*
+ * Collapse an RGBA texture to a single value per channel on the GPU:
+ *
+ *   aglet::GLReduction mean(width, height, aglet::GLReduction::kMean);
+ *   mean.start(texture); // log4(N) passes + asynchronous 1 texel readback
+ *   ...                  // other work
+ *   auto value = mean.finish();
+ *
+ * Each pass reduces 4x4 texel blocks, weighting partial blocks at the
+ * right and top borders by the number of image pixels they cover, so
+ * the mean is exact for any image size.  Intermediate levels are float
+ * render targets where supported (desktop, EXT_color_buffer_float) and
+ * RGBA8 otherwise (OpenGL ES 2.0), which rounds each level to 1/255.
+ *
+ * Values are normalized, i.e., kSum returns the sum of texel values in
+ * [0, 1] (multiply by 255 for 8 bit units).
+ */
+
+class GLReduction
+{
+public:
+    using Value = std::array<float, 4>;
+
+    enum Operation
+    {
+        kMean,
+        kSum,
+        kMin,
+        kMax
+    };
+
+    GLReduction(int width, int height, Operation operation);
+    ~GLReduction();
+
+    // Reduce texture (width x height) and start reading back the result:
+    void start(GLuint texture);
+
+    // Wait for the result of the last start():
+    Value finish();
+
+    // Synchronous reduction:
+    Value operator()(GLuint texture)
+    {
+        start(texture);
+        return finish();
+    }
+
+    // Number of reduction passes per texture:
+    std::size_t getLevelCount() const { return m_levels.size(); }
+
+    // True if intermediate levels are float render targets:
+    bool isFloat() const { return m_isFloat; }
+
+protected:
+    struct Level;
+
+    int m_width = 0;
+    int m_height = 0;
+    Operation m_operation = kMean;
+    bool m_isFloat = false;
+
+    GLQuad m_quad;
+    GLShader m_shader;
+    GLint m_inputSize = -1;
+    GLint m_block = -1;
+
+    std::vector<std::unique_ptr<Level>> m_levels;
+#if defined(AGLET_HAS_PBO)
+    std::unique_ptr<IPBO> m_pbo; // asynchronous readback
+#endif
+    Value m_value = { { 0.f, 0.f, 0.f, 0.f } };
+};
+
+#if defined(AGLET_HAS_COMPUTE)
+
+/*
+ * Histogram of one channel of an RGBA8 texture accumulated with compute
+ * shader atomics in an SSBO, only the bins are read back:
+ *
+ *   aglet::GLHistogram histogram(256);
+ *   histogram.start(texture, width, height);
+ *   auto bins = histogram.finish();
+ */
+
+class GLHistogram
+{
+public:
+    explicit GLHistogram(GLuint bins = 256, int channel = 0);
+
+    // Clear the bins and dispatch the accumulation (non-blocking):
+    void start(GLuint texture, int width, int height);
+
+    // Wait for and read back the bins of the last start():
+    std::vector<GLuint> finish();
+
+    std::vector<GLuint> operator()(GLuint texture, int width, int height)
+    {
+        start(texture, width, height);
+        return finish();
+    }
+
+    GLuint getBinCount() const { return m_bins; }
+
+protected:
+    GLuint m_bins = 256;
+    GLComputeProgram m_program;
+    GLBuffer m_buffer;
+    GLMemoryBarrier m_barrier;
+};
+
+#endif // defined(AGLET_HAS_COMPUTE)
+
+AGLET_END
+
+#endif // __aglet_GLReduction_h__
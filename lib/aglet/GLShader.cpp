@@ -0,0 +1,149 @@
+/*!
+  @file   GLShader.cpp
+  @brief  Implementation of a minimal OpenGL shader program wrapper.
+
+  Source: https://github.com/hunter-packages/ogles_gpgpu/blob/hunter/ogles_gpgpu/common/gl/shader.cpp
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLShader.h"
+#include "aglet/GLTrace.h"
+
+#include <iostream>
+
+AGLET_BEGIN
+
+GLShader::~GLShader()
+{
+    if (programId > 0)
+    {
+        owner.release(GLDeletionQueue::kProgram, programId);
+    }
+    if (vshId > 0)
+    {
+        owner.release(GLDeletionQueue::kShader, vshId);
+    }
+    if (fshId > 0)
+    {
+        owner.release(GLDeletionQueue::kShader, fshId);
+    }
+}
+
+bool GLShader::buildFromSrc(const char* vshSrc, const char* fshSrc, const Attributes& attributes)
+{
+    AGLET_TRACE_SCOPE("GLShader::buildFromSrc", "shader");
+    vshId = compile(GL_VERTEX_SHADER, vshSrc);
+    fshId = compile(GL_FRAGMENT_SHADER, fshSrc);
+    if (!vshId || !fshId)
+    {
+        return false;
+    }
+
+    programId = link({ vshId, fshId }, attributes);
+    return (programId > 0);
+}
+
+void GLShader::use()
+{
+    glUseProgram(programId);
+}
+
+GLint GLShader::getParam(ParamType type, const char* name) const
+{
+    // get position according to type and name
+    GLint id = (type == kAttribute) ? glGetAttribLocation(programId, name) : glGetUniformLocation(programId, name);
+
+    if (id < 0)
+    {
+        std::cerr << "aglet::GLShader - could not get parameter id for param " << name << std::endl;
+    }
+
+    return id;
+}
+
+GLuint GLShader::link(const std::vector<GLuint>& shaders, const Attributes& attributes)
+{
+    // create shader program
+    GLuint programId = glCreateProgram();
+
+    if (programId == 0)
+    {
+        std::cerr << "aglet::GLShader - could not create shader program" << std::endl;
+        return 0;
+    }
+
+    for (const auto& shader : shaders)
+    {
+        glAttachShader(programId, shader);
+    }
+
+    // Bind attribute locations
+    // this needs to be done prior to linking
+    for (const auto& attribute : attributes)
+    {
+        glBindAttribLocation(programId, attribute.first, attribute.second);
+    }
+
+    glLinkProgram(programId); // link all shaders to a full program
+
+    // check link status
+    GLint linkStatus;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        GLchar infoLogBuf[1024];
+        GLsizei infoLogLen;
+        glGetProgramInfoLog(programId, 1024, &infoLogLen, infoLogBuf);
+        std::cerr << "aglet::GLShader - could not link shader program. error log:" << std::endl
+                  << infoLogBuf << std::endl
+                  << std::endl;
+
+        glDeleteProgram(programId);
+
+        return 0;
+    }
+
+    return programId;
+}
+
+GLuint GLShader::compile(GLenum type, const char* src)
+{
+    // create a shader
+    GLuint shId = glCreateShader(type);
+    if (shId == 0)
+    {
+        std::cerr << "aglet::GLShader - could not create shader" << std::endl;
+        return 0;
+    }
+
+    // set shader source
+    glShaderSource(shId, 1, (const GLchar**)&src, NULL);
+
+    // compile the shader
+    glCompileShader(shId);
+
+    // check compile status
+    GLint compileStatus;
+    glGetShaderiv(shId, GL_COMPILE_STATUS, &compileStatus);
+    if (compileStatus != GL_TRUE)
+    {
+        GLchar infoLogBuf[1024];
+        GLsizei infoLogLen;
+        glGetShaderInfoLog(shId, 1024, &infoLogLen, infoLogBuf);
+        std::cerr << "aglet::GLShader - could not compile shader program. error log:" << std::endl
+                  << infoLogBuf << std::endl
+                  << std::endl
+                  << "shader source:" << std::endl
+                  << src << std::endl
+                  << std::endl;
+
+        glDeleteShader(shId);
+        return 0;
+    }
+    return shId;
+}
+
+AGLET_END
@@ -0,0 +1,93 @@
+/*!
+  @file   GLShader.h
+  @brief  Declaration of a minimal OpenGL shader program wrapper.
+
+  Source: https://github.com/hunter-packages/ogles_gpgpu/blob/hunter/ogles_gpgpu/common/gl/shader.cpp
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLShader_h__
+#define __aglet_GLShader_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLDeletionQueue.h"
+
+#include <utility>
+#include <vector>
+
+AGLET_BEGIN
+
+/** 
+ * Shader helper class for creating and managing an OpenGL shader.
+ */
+class GLShader
+{
+public:
+    enum ParamType
+    {
+        kAttribute,
+        kUniform
+    };
+
+    typedef std::pair<int, const char*> Attribute;
+    typedef std::vector<Attribute> Attributes;
+
+    /**
+     * Constructor.
+     */
+    GLShader() = default;
+
+    /**
+     * Deconstructor.
+     */
+    ~GLShader();
+
+    GLShader(const GLShader&) = delete;
+    GLShader& operator=(const GLShader&) = delete;
+
+    /**
+     * Build an OpenGL shader object from vertex and fragment shader source code
+     * <vshSrc> and <fshSrc>.
+     */
+    bool buildFromSrc(const char* vshSrc, const char* fshSrc, const Attributes& attributes = {});
+
+    /**
+     * Use the shader program.
+     */
+    void use();
+
+    /**
+     * Get a shader parameter position for a parameter of type <type> and with
+     * <name>.
+     */
+    GLint getParam(ParamType type, const char* name) const;
+
+    /**
+     * Get the shader program id.
+     */
+    GLuint getProgramId() const { return programId; }
+
+    /**
+     * Compile a shader of type <type> and source <src> and return its id.
+     */
+    static GLuint compile(GLenum type, const char* src);
+
+protected:
+    /**
+     * Link a shader program from compiled shaders <shaders>, binding <attributes>.
+     */
+    static GLuint link(const std::vector<GLuint>& shaders, const Attributes& attributes = {});
+
+    GLuint programId = 0; // full shader program id
+    GLuint vshId = 0;     // vertex shader id
+    GLuint fshId = 0;     // fragment shader id
+    GLOwner owner;
+};
+
+AGLET_END
+
+#endif // __aglet_GLShader_h__
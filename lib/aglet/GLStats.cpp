@@ -0,0 +1,170 @@
+/*!
+  @file   GLStats.cpp
+  @brief  Implementation of per context GL call statistics.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLStats.h"
+#include "aglet/gl_includes.h"
+
+#include <iomanip>
+#include <ostream>
+
+AGLET_BEGIN
+
+GLStats::Frame::Frame()
+{
+    warnings.fill(0);
+}
+
+std::uint64_t GLStats::Frame::getCalls() const
+{
+    std::uint64_t total = 0;
+    for (const auto& counter : calls)
+    {
+        total += counter.calls;
+    }
+    return total;
+}
+
+std::int64_t GLStats::Frame::getTime() const
+{
+    std::int64_t total = 0;
+    for (const auto& counter : calls)
+    {
+        total += counter.time;
+    }
+    return total;
+}
+
+bool GLStats::isCompiled()
+{
+#if defined(AGLET_HAS_GL_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GLStats::frame()
+{
+    for (std::size_t i = 0; i < m_current.calls.size(); i++)
+    {
+        m_total.calls[i].calls += m_current.calls[i].calls;
+        m_total.calls[i].time += m_current.calls[i].time;
+    }
+    for (std::size_t i = 0; i < m_current.warnings.size(); i++)
+    {
+        m_total.warnings[i] += m_current.warnings[i];
+    }
+
+    m_last = m_current;
+    m_current = Frame();
+    m_getErrors = 0;
+    m_frames++;
+}
+
+void GLStats::reset()
+{
+    m_current = m_last = m_total = Frame();
+    m_getErrors = 0;
+    m_frames = 0;
+    m_activeTexture = 0;
+    m_bindings.clear();
+}
+
+void GLStats::record(Call call, std::int64_t time)
+{
+    auto& counter = m_current.calls[call];
+    counter.calls++;
+    counter.time += time;
+
+    if (call == kFinish)
+    {
+        warn(kWarnFinish);
+    }
+
+    // Not every entry point is intercepted, so a few error checks in a row are normal:
+    if (call != kGetError)
+    {
+        m_getErrors = 0;
+    }
+    else if (++m_getErrors == kGetErrorLoop)
+    {
+        warn(kWarnGetErrorLoop); // once per run
+    }
+}
+
+bool GLStats::bind(Binding kind, unsigned int target, unsigned int unit, unsigned int name)
+{
+    auto result = m_bindings.emplace(std::make_tuple(kind, target, unit), name);
+    if (result.second)
+    {
+        return false; // first bind seen by the layer
+    }
+
+    const bool redundant = (result.first->second == name);
+    result.first->second = name;
+    return redundant;
+}
+
+void GLStats::forget(Binding kind, unsigned int name)
+{
+    // Deleting a bound object reverts the binding to zero:
+    for (auto& binding : m_bindings)
+    {
+        if ((std::get<0>(binding.first) == kind) && (binding.second == name))
+        {
+            binding.second = 0;
+        }
+    }
+}
+
+unsigned int GLStats::getBinding(Binding kind, unsigned int target, unsigned int unit) const
+{
+    auto iter = m_bindings.find(std::make_tuple(kind, target, unit));
+    return (iter != m_bindings.end()) ? iter->second : 0;
+}
+
+const char* GLStats::getName(Call call)
+{
+    // clang-format off
+#define AGLET_GL_STATS_NAME(name) "gl" #name,
+    static const char* names[] = { AGLET_GL_STATS_CALLS(AGLET_GL_STATS_NAME) };
+#undef AGLET_GL_STATS_NAME
+    // clang-format on
+
+    return (call < kCallCount) ? names[call] : "unknown";
+}
+
+const char* GLStats::getName(Warning warning)
+{
+    static const char* names[] = { "redundant bind", "glGetError loop", "glFinish", "synchronous glReadPixels" };
+    return (warning < kWarningCount) ? names[warning] : "unknown";
+}
+
+void GLStats::print(std::ostream& os) const
+{
+    os << "frame " << m_frames << " : " << m_last.getCalls() << " calls " << (double(m_last.getTime()) * 1e-6) << " ms\n";
+    for (int i = 0; i < kCallCount; i++)
+    {
+        const auto& counter = m_last.calls[i];
+        if (counter.calls)
+        {
+            os << "  " << std::left << std::setw(28) << getName(Call(i)) << std::right << std::setw(8) << counter.calls
+               << std::setw(12) << (double(counter.time) * 1e-3) << " us\n";
+        }
+    }
+    for (int i = 0; i < kWarningCount; i++)
+    {
+        if (m_last.warnings[i])
+        {
+            os << "  warning: " << getName(Warning(i)) << " x " << m_last.warnings[i] << "\n";
+        }
+    }
+}
+
+AGLET_END
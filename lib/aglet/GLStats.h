@@ -0,0 +1,165 @@
+/*!
+  @file   GLStats.h
+  @brief  Declaration of per context GL call statistics.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLStats_h__
+#define __aglet_GLStats_h__
+
+#include "aglet/aglet.h"
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <tuple>
+
+/*
+ * Per frame counts and CPU time of the GL entry points called by aglet
+ * and by code including aglet/gl_includes.h, to see where the driver
+ * overhead goes without an external tracer:
+ *
+ *   auto gl = aglet::GLContext::create(aglet::GLContext::kAuto);
+ *   ...                         // render a frame
+ *   gl->getStats().frame();     // frame boundary (GLContextLoop does this)
+ *   gl->getStats().print(std::cout);
+ *
+ * The calls are intercepted (see GLIntercept.h) only when aglet is built
+ * with the AGLET_GL_STATS CMake option, otherwise all counts stay zero.
+ * Calls are charged to the context that is current through aglet, and
+ * recording can be turned off per context with setEnabled(false).
+ *
+ * Anti-patterns are counted alongside the calls:
+ *
+ *   kWarnRedundantBind  : glBindTexture/Buffer/Framebuffer or glUseProgram of
+ *                         the object that is already bound (as seen by the layer)
+ *   kWarnGetErrorLoop   : kGetErrorLoop glGetError calls with no other intercepted
+ *                         call in between, i.e., polling the error flag in a loop
+ *                         (once per run, entry points outside the layer such as
+ *                         glCompileShader make shorter runs of error checks normal)
+ *   kWarnFinish         : glFinish, a full pipeline stall
+ *   kWarnSyncReadPixels : glReadPixels to client memory (no pack buffer bound),
+ *                         the CPU waits for the GPU
+ */
+
+// clang-format off
+#define AGLET_GL_STATS_CALLS(X) \
+    X(ActiveTexture) X(BindBuffer) X(BindFramebuffer) X(BindTexture) X(UseProgram) \
+    X(BufferData) X(BufferSubData) X(TexImage2D) X(TexSubImage2D) X(CopyTexSubImage2D) \
+    X(ReadPixels) X(PixelStorei) X(TexParameteri) X(GenerateMipmap) \
+    X(Clear) X(DrawArrays) X(DrawElements) X(Viewport) X(FramebufferTexture2D) \
+    X(CheckFramebufferStatus) X(GetError) X(GetIntegerv) X(GetUniformLocation) \
+    X(Uniform1i) X(Uniform1f) X(Uniform2f) X(Uniform3f) X(Uniform4fv) X(UniformMatrix3fv) \
+    X(VertexAttribPointer) X(EnableVertexAttribArray) X(DisableVertexAttribArray) \
+    X(GenTextures) X(DeleteTextures) X(GenBuffers) X(DeleteBuffers) X(GenFramebuffers) \
+    X(DeleteFramebuffers) X(DeleteProgram) X(Finish) X(Flush) \
+    X(MapBufferRange) X(UnmapBuffer) X(TexImage3D) X(TexSubImage3D) X(DrawArraysInstanced) \
+    X(DispatchCompute) X(MemoryBarrier)
+// clang-format on
+
+AGLET_BEGIN
+
+class GLStats
+{
+public:
+    // clang-format off
+#define AGLET_GL_STATS_ENUM(name) k##name,
+    enum Call
+    {
+        AGLET_GL_STATS_CALLS(AGLET_GL_STATS_ENUM)
+        kCallCount
+    };
+#undef AGLET_GL_STATS_ENUM
+    // clang-format on
+
+    enum Warning
+    {
+        kWarnRedundantBind,
+        kWarnGetErrorLoop,
+        kWarnFinish,
+        kWarnSyncReadPixels,
+        kWarningCount
+    };
+
+    // Consecutive glGetError calls reported as kWarnGetErrorLoop:
+    static const int kGetErrorLoop = 16;
+
+    // Bound object kinds tracked for kWarnRedundantBind:
+    enum Binding
+    {
+        kTextureBinding,
+        kBufferBinding,
+        kFramebufferBinding,
+        kProgramBinding
+    };
+
+    struct Counter
+    {
+        std::uint64_t calls = 0;
+        std::int64_t time = 0; // CPU nanoseconds
+    };
+
+    struct Frame
+    {
+        Frame();
+
+        std::uint64_t getCalls() const; // all entry points
+        std::int64_t getTime() const;   // all entry points
+
+        std::array<Counter, kCallCount> calls;
+        std::array<std::uint64_t, kWarningCount> warnings;
+    };
+
+    // True if aglet was built with AGLET_GL_STATS (counts are recorded):
+    static bool isCompiled();
+
+    void setEnabled(bool flag) { m_enabled = flag; }
+    bool isEnabled() const { return m_enabled; }
+
+    // Mark the end of a frame, getFrame() returns the completed frame:
+    void frame();
+
+    const Frame& getFrame() const { return m_last; }      // last completed frame
+    const Frame& getCurrent() const { return m_current; } // frame in progress
+    const Frame& getTotal() const { return m_total; }     // all completed frames
+    std::uint64_t getFrameCount() const { return m_frames; }
+
+    // Drop all counts and tracked bindings:
+    void reset();
+
+    // Print the non zero counts of the last completed frame:
+    void print(std::ostream& os) const;
+
+    static const char* getName(Call call);
+    static const char* getName(Warning warning);
+
+    // Interception layer (GLIntercept.h):
+    void record(Call call, std::int64_t time);
+    void warn(Warning warning) { m_current.warnings[warning]++; }
+    bool bind(Binding kind, unsigned int target, unsigned int unit, unsigned int name); // true if redundant
+    void forget(Binding kind, unsigned int name);                                       // deleted object
+    unsigned int getBinding(Binding kind, unsigned int target, unsigned int unit) const; // 0 if unknown
+    void setActiveTexture(unsigned int unit) { m_activeTexture = unit; }
+    unsigned int getActiveTexture() const { return m_activeTexture; }
+
+protected:
+    bool m_enabled = true;
+    std::uint64_t m_frames = 0;
+
+    Frame m_current;
+    Frame m_last;
+    Frame m_total;
+
+    int m_getErrors = 0; // glGetError calls since the last other call in this frame
+
+    unsigned int m_activeTexture = 0;
+    std::map<std::tuple<Binding, unsigned int, unsigned int>, unsigned int> m_bindings; // (kind, target, unit) -> name
+};
+
+AGLET_END
+
+#endif // __aglet_GLStats_h__
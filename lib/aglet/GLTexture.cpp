@@ -0,0 +1,410 @@
+/*!
+  @file   GLTexture.cpp
+  @brief  Implementation of a minimal RGBA OpenGL texture wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLTexture.h"
+#include "aglet/GLBuffer.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLDispatch.h"
+#include "aglet/GLError.h"
+#include "aglet/GLNamePool.h"
+#include "aglet/GLTrace.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+AGLET_BEGIN
+
+std::size_t getPixelSize(GLenum format, GLenum type)
+{
+    std::size_t channels = 4;
+    switch (format)
+    {
+        case GL_RGBA:
+#if defined(GL_BGRA)
+        case GL_BGRA:
+#else
+        case 0x80E1: // GL_BGRA_EXT (GL_EXT_texture_format_BGRA8888)
+#endif
+            channels = 4;
+            break;
+        case GL_RGB:
+            channels = 3;
+            break;
+#if defined(GL_RG)
+        case GL_RG:
+#endif
+#if defined(GL_LUMINANCE_ALPHA)
+        case GL_LUMINANCE_ALPHA:
+#endif
+            channels = 2;
+            break;
+#if defined(GL_RED)
+        case GL_RED:
+#endif
+#if defined(GL_LUMINANCE)
+        case GL_LUMINANCE:
+#endif
+        case GL_ALPHA:
+            channels = 1;
+            break;
+        default:
+            throw_assert(false, "getPixelSize() : unsupported format " << int(format));
+    }
+
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:
+            return channels;
+        case GL_UNSIGNED_SHORT:
+#if defined(GL_HALF_FLOAT)
+        case GL_HALF_FLOAT:
+#endif
+            return channels * 2;
+        case GL_FLOAT:
+            return channels * 4;
+        default:
+            throw_assert(false, "getPixelSize() : unsupported type " << int(type));
+    }
+    return 0;
+}
+
+bool hasFloatRenderTargets()
+{
+    return GLCapabilities::current().hasFloatRenderTargets();
+}
+
+void copyRows(GLubyte* dst, std::size_t dstStride, const GLubyte* src, std::size_t srcStride, std::size_t rowSize, std::size_t rows)
+{
+    if ((dstStride == rowSize) && (srcStride == rowSize))
+    {
+        std::memcpy(dst, src, rowSize * rows);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < rows; i++)
+        {
+            std::memcpy(dst + i * dstStride, src + i * srcStride, rowSize);
+        }
+    }
+}
+
+static void readPixelsDirect(GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    const std::size_t pixelSize = getPixelSize(format, type);
+    const std::size_t rowSize = std::size_t(width) * pixelSize;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#if !defined(AGLET_OPENGL_ES2)
+    if ((stride % pixelSize) == 0)
+    {
+        glPixelStorei(GL_PACK_ROW_LENGTH, GLint(stride / pixelSize));
+        glReadPixels(x, y, width, height, format, type, pixels);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        checkGLError("readPixels() : glReadPixels()");
+        return;
+    }
+#endif
+
+    // Read tightly packed rows, then copy them to their strided location
+    // (the gaps between caller rows may be other pixels, i.e., for a region
+    // of a larger image, so rows are not expanded in place):
+    if (stride == rowSize)
+    {
+        glReadPixels(x, y, width, height, format, type, pixels);
+    }
+    else
+    {
+        thread_local std::vector<GLubyte> scratch; // reused across calls
+        scratch.resize(rowSize * std::size_t(height));
+        glReadPixels(x, y, width, height, format, type, scratch.data());
+        copyRows(pixels, stride, scratch.data(), rowSize, rowSize, std::size_t(height));
+    }
+    checkGLError("readPixels() : glReadPixels()");
+}
+
+static void writePixelsDirect(GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    const std::size_t pixelSize = getPixelSize(format, type);
+    const std::size_t rowSize = std::size_t(width) * pixelSize;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (stride == rowSize)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, pixels);
+    }
+#if !defined(AGLET_OPENGL_ES2)
+    else if ((stride % pixelSize) == 0)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(stride / pixelSize));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+#endif
+    else
+    {
+        thread_local std::vector<GLubyte> scratch; // reused across calls
+        scratch.resize(rowSize * std::size_t(height));
+        copyRows(scratch.data(), rowSize, pixels, stride, rowSize, std::size_t(height));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, scratch.data());
+    }
+    checkGLError("writePixels() : glTexSubImage2D()");
+}
+
+#if defined(AGLET_HAS_PBO)
+// Pixel buffer object of the PBO transfer methods: kept by the current aglet
+// context and grown on demand, so repeated transfers allocate nothing (a
+// transient buffer without an aglet context):
+static GLBuffer& getTransferBuffer(GLenum target, GLenum usage, std::size_t size, std::unique_ptr<GLBuffer>& transient)
+{
+    GLContext* context = GLContext::current();
+    if (!context)
+    {
+        transient.reset(new GLBuffer(target, size, usage));
+        return *transient;
+    }
+
+    auto& buffer = (target == GL_PIXEL_PACK_BUFFER) ? context->m_packBuffer : context->m_unpackBuffer;
+    if (!buffer || (buffer->getSize() < size))
+    {
+        buffer.reset(); // release before allocating the larger one
+        buffer = std::make_shared<GLBuffer>(target, size, usage);
+    }
+    return *buffer;
+}
+
+// Synchronous transfers through a pixel buffer object, for drivers where
+// client memory transfers are slow (see calibrateTransfers()):
+static void readPixelsPBO(GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    const std::size_t rowSize = std::size_t(width) * getPixelSize(format, type);
+    const std::size_t size = rowSize * std::size_t(height);
+
+    std::unique_ptr<GLBuffer> transient;
+    GLBuffer& pbo = getTransferBuffer(GL_PIXEL_PACK_BUFFER, GL_STREAM_READ, size, transient);
+    pbo.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, width, height, format, type, 0);
+    checkGLError("readPixels() : glReadPixels()");
+
+#if defined(AGLET_OSX)
+    const GLubyte* ptr = static_cast<const GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+#else
+    const GLubyte* ptr = static_cast<const GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(size), GL_MAP_READ_BIT));
+#endif
+    if (!ptr)
+    {
+        pbo.unbind();
+        throw_assert(false, "readPixels() : glMapBufferRange()");
+    }
+    copyRows(pixels, stride, ptr, rowSize, rowSize, std::size_t(height));
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+    pbo.unbind();
+    checkGLError("readPixels() : glMapBufferRange()");
+}
+
+static void writePixelsPBO(GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    const std::size_t rowSize = std::size_t(width) * getPixelSize(format, type);
+    const std::size_t size = rowSize * std::size_t(height);
+
+    std::unique_ptr<GLBuffer> transient;
+    GLBuffer& pbo = getTransferBuffer(GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW, size, transient);
+    pbo.bind();
+
+    // Invalidation orphans the storage of the previous upload, which may still be in flight:
+#if defined(AGLET_OSX)
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(pbo.getSize()), nullptr, GL_STREAM_DRAW);
+    GLubyte* ptr = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+#else
+    GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+#endif
+    if (!ptr)
+    {
+        pbo.unbind();
+        throw_assert(false, "writePixels() : glMapBufferRange()");
+    }
+    copyRows(ptr, rowSize, pixels, stride, rowSize, std::size_t(height));
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, 0);
+
+    pbo.unbind();
+    checkGLError("writePixels() : glTexSubImage2D()");
+}
+#endif
+
+static GLContext::TransferStrategy getStrategy()
+{
+    const GLContext* context = GLContext::current();
+    return context ? context->getTransferStrategy() : GLContext::TransferStrategy();
+}
+
+void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    readPixels(getStrategy().readback, x, y, width, height, pixels, stride, format, type);
+}
+
+void readPixels(GLContext::TransferMethod method, GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    AGLET_TRACE_GPU_SCOPE("readPixels", "transfer");
+
+    const std::size_t rowSize = std::size_t(width) * getPixelSize(format, type);
+    if (stride == 0)
+    {
+        stride = rowSize;
+    }
+    throw_assert(stride >= rowSize, "readPixels() : stride " << stride << " < row size " << rowSize);
+
+#if defined(AGLET_HAS_PBO)
+    if (method == GLContext::kTransferPBO)
+    {
+        readPixelsPBO(x, y, width, height, pixels, stride, format, type);
+        return;
+    }
+#else
+    throw_assert(method == GLContext::kTransferDirect, "readPixels() : pixel buffer objects are not supported");
+#endif
+    readPixelsDirect(x, y, width, height, pixels, stride, format, type);
+}
+
+void writePixels(GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    writePixels(getStrategy().upload, x, y, width, height, pixels, stride, format, type);
+}
+
+void writePixels(GLContext::TransferMethod method, GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride, GLenum format, GLenum type)
+{
+    AGLET_TRACE_GPU_SCOPE("writePixels", "transfer");
+
+    const std::size_t rowSize = std::size_t(width) * getPixelSize(format, type);
+    if (stride == 0)
+    {
+        stride = rowSize;
+    }
+    throw_assert(stride >= rowSize, "writePixels() : stride " << stride << " < row size " << rowSize);
+
+#if defined(AGLET_HAS_PBO)
+    if (method == GLContext::kTransferPBO)
+    {
+        writePixelsPBO(x, y, width, height, pixels, stride, format, type);
+        return;
+    }
+#else
+    throw_assert(method == GLContext::kTransferDirect, "writePixels() : pixel buffer objects are not supported");
+#endif
+    writePixelsDirect(x, y, width, height, pixels, stride, format, type);
+}
+
+GLTexture::GLTexture(std::size_t width, std::size_t height, GLenum texType, void* data)
+    : GLTexture(width, height, GL_RGBA, texType, GL_UNSIGNED_BYTE, data)
+{
+}
+
+GLTexture::GLTexture(std::size_t width, std::size_t height, GLint internalFormat, GLenum format, GLenum type, const void* data, Storage storage)
+    : width(width)
+    , height(height)
+    , internalFormat(internalFormat)
+    , format(format)
+    , type(type)
+{
+    GLContext* context = GLContext::current();
+    const GLenum sizedFormat = GLNamePool::getSizedFormat(GLenum(internalFormat), type);
+    if ((storage == kImmutable) && context && sizedFormat && context->getDispatch().hasTextureStorage())
+    {
+        texId = context->getNamePool().acquireTexture(GLsizei(width), GLsizei(height), sizedFormat, allocation);
+        this->sizedFormat = sizedFormat;
+        immutable = true;
+    }
+    else
+    {
+        texId = GLNamePool::generate(GLNamePool::kTexture);
+    }
+    checkGLError("GLTexture::GLTexture() : glGenTextures()");
+    bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    checkGLError("GLTexture::GLTexture() : glTexParameteri()");
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (!immutable)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, GLsizei(width), GLsizei(height), 0, format, type, data);
+        checkGLError("GLTexture::GLTexture() : glTexImage2D()");
+    }
+    else if (data)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GLsizei(width), GLsizei(height), format, type, data);
+        checkGLError("GLTexture::GLTexture() : glTexSubImage2D()");
+    }
+    unbind();
+
+    if (!allocation.getBytes()) // recycled storage is already charged
+    {
+        allocation = GLAllocation(GLMemory::kTexture, width * height * getPixelSize(format, type));
+    }
+}
+
+GLTexture::~GLTexture()
+{
+    if (texId > 0)
+    {
+        if (immutable && owner.isCurrent())
+        {
+            GLContext::current()->getNamePool().recycle(texId, GLsizei(width), GLsizei(height), sizedFormat, std::move(allocation));
+        }
+        else
+        {
+            owner.release(GLDeletionQueue::kTexture, texId, std::move(allocation));
+        }
+        texId = 0;
+    }
+}
+
+void GLTexture::bind()
+{
+    glBindTexture(GL_TEXTURE_2D, texId);
+}
+
+void GLTexture::unbind()
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GLTexture::setFilter(GLenum filter)
+{
+    bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    unbind();
+}
+
+void GLTexture::read(GLubyte* pixels)
+{
+    readPixels(0, 0, GLsizei(width), GLsizei(height), pixels, width * 4);
+}
+
+void GLTexture::write(const GLubyte* pixels, int x, int y, int width, int height, std::size_t stride)
+{
+    throw_assert((x >= 0) && (y >= 0) && ((x + width) <= int(this->width)) && ((y + height) <= int(this->height)), "GLTexture::write() : invalid region");
+    bind();
+    writePixels(x, y, width, height, pixels, stride, format, type);
+    unbind();
+}
+
+void GLTexture::read(GLubyte* pixels, int x, int y, int width, int height, std::size_t stride)
+{
+    throw_assert((x >= 0) && (y >= 0) && ((x + width) <= int(this->width)) && ((y + height) <= int(this->height)), "GLTexture::read() : invalid region");
+    readPixels(x, y, width, height, pixels, stride);
+}
+
+AGLET_END
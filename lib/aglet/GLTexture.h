@@ -0,0 +1,112 @@
+/*!
+  @file   GLTexture.h
+  @brief  Declaration of a minimal RGBA OpenGL texture wrapper.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLTexture_h__
+#define __aglet_GLTexture_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLContext.h"
+#include "aglet/GLDeletionQueue.h"
+#include "aglet/GLMemory.h"
+
+#include <cstddef>
+
+AGLET_BEGIN
+
+// Size in bytes of a pixel with the given format and type (i.e., GL_RGBA, GL_UNSIGNED_BYTE):
+std::size_t getPixelSize(GLenum format, GLenum type);
+
+// True if GL_RGBA32F and GL_RGBA16F textures are color renderable (desktop, or
+// OpenGL ES 3.0 with GL_EXT_color_buffer_float) in the current context:
+bool hasFloatRenderTargets();
+
+// Copy rows of rowSize bytes between buffers with different row strides:
+void copyRows(GLubyte* dst, std::size_t dstStride, const GLubyte* src, std::size_t srcStride, std::size_t rowSize, std::size_t rows);
+
+// Read the width x height rectangle at (x, y) of the bound framebuffer into
+// pixels with a row stride in bytes (0: tightly packed).  Uses
+// GL_PACK_ROW_LENGTH where available, so rows are written directly to the
+// caller memory, and a strided copy from a (reused) buffer otherwise:
+void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride = 0, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+// Upload the width x height rectangle at (x, y) of the bound GL_TEXTURE_2D from
+// pixels with a row stride in bytes (0: tightly packed).  Uses
+// GL_UNPACK_ROW_LENGTH where available and a strided copy to a (reused)
+// buffer otherwise:
+void writePixels(GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride = 0, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+// The functions above transfer with the method selected for the current
+// aglet context (GLContext::getTransferStrategy()), these use a given one
+// (kTransferPBO requires pixel buffer objects):
+void readPixels(GLContext::TransferMethod method, GLint x, GLint y, GLsizei width, GLsizei height, GLubyte* pixels, std::size_t stride = 0, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+void writePixels(GLContext::TransferMethod method, GLint x, GLint y, GLsizei width, GLsizei height, const GLubyte* pixels, std::size_t stride = 0, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+class GLTexture
+{
+public:
+    // kImmutable: one level of glTexStorage2D storage, recycled by the context's GLNamePool
+    // (falls back to kMutable without texture storage support or a known sized format):
+    enum Storage
+    {
+        kMutable,
+        kImmutable
+    };
+
+    GLTexture(std::size_t width, std::size_t height, GLenum texType = GL_RGBA, void* data = nullptr);
+    GLTexture(std::size_t width, std::size_t height, GLint internalFormat, GLenum format, GLenum type, const void* data = nullptr, Storage storage = kMutable);
+    ~GLTexture();
+
+    GLTexture(const GLTexture&) = delete;
+    GLTexture& operator=(const GLTexture&) = delete;
+
+    void bind();
+    void unbind();
+
+    // Set GL_TEXTURE_MIN_FILTER and GL_TEXTURE_MAG_FILTER (i.e., GL_NEAREST for float textures):
+    void setFilter(GLenum filter);
+
+    // Read pixels (RGBA) from the currently bound framebuffer:
+    void read(GLubyte* pixels);
+
+    // Read a region (RGBA) from the currently bound framebuffer into rows of stride bytes:
+    void read(GLubyte* pixels, int x, int y, int width, int height, std::size_t stride = 0);
+
+    // Upload a region from rows of stride bytes (in the format and type of the texture):
+    void write(const GLubyte* pixels, int x, int y, int width, int height, std::size_t stride = 0);
+
+    std::size_t getWidth() const { return width; }
+    std::size_t getHeight() const { return height; }
+    GLint getInternalFormat() const { return internalFormat; } // as requested
+    GLenum getSizedFormat() const { return sizedFormat; }       // storage of an immutable texture, 0 otherwise
+    GLenum getFormat() const { return format; }
+    GLenum getType() const { return type; }
+    bool isImmutable() const { return immutable; }
+
+    operator GLuint() const
+    {
+        return texId;
+    }
+
+protected:
+    std::size_t width;
+    std::size_t height;
+    GLint internalFormat = GL_RGBA;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    GLuint texId = 0;
+    bool immutable = false;
+    GLenum sizedFormat = 0; // glTexStorage2D format (immutable)
+    GLAllocation allocation; // GLMemory::kTexture
+    GLOwner owner;
+};
+
+AGLET_END
+
+#endif // __aglet_GLTexture_h__
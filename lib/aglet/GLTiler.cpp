@@ -0,0 +1,189 @@
+/*!
+  @file   GLTiler.cpp
+  @brief  Implementation of tiled processing for images larger than the GL texture limits.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLTiler.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLError.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLPBO.h"
+#include "aglet/GLTexture.h"
+#include "aglet/GLTrace.h"
+
+#include <algorithm>
+#include <cstring>
+
+AGLET_BEGIN
+
+static const std::size_t kPixelSize = 4; // RGBA
+
+GLTiler::GLTiler(int tileSize, int halo, std::size_t depth)
+    : m_tileSize(std::min(tileSize, getMaxTileSize()))
+    , m_halo(halo)
+    , m_depth(depth)
+{
+    throw_assert((halo >= 0) && (depth > 0), "GLTiler::GLTiler() : invalid halo or depth");
+    throw_assert(getStep() > 0, "GLTiler::GLTiler() : tile size " << m_tileSize << " is too small for halo " << halo);
+
+    m_texture.reset(new GLTexture(m_tileSize, m_tileSize, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, nullptr, GLTexture::kImmutable));
+    m_fbo.reset(new GLFrameBufferObject);
+    m_buffer.resize(std::size_t(m_tileSize) * std::size_t(m_tileSize) * kPixelSize);
+
+#if defined(AGLET_HAS_PBO)
+    for (std::size_t i = 0; i < depth; i++)
+    {
+        m_pbos.emplace_back(new IPBO(getStep(), getStep()));
+    }
+#endif
+}
+
+GLTiler::~GLTiler() = default;
+
+GLuint GLTiler::getTexture() const
+{
+    return *m_texture;
+}
+
+int GLTiler::getMaxTileSize()
+{
+    const auto& limits = GLCapabilities::current().getLimits();
+    int size = limits.maxTextureSize ? limits.maxTextureSize : 2048; // minimum maximum of OpenGL ES 3.0
+    if (limits.maxViewportDims[0] && limits.maxViewportDims[1])
+    {
+        size = std::min(size, std::min(limits.maxViewportDims[0], limits.maxViewportDims[1]));
+    }
+    return size;
+}
+
+std::size_t GLTiler::getTileCount(int width, int height) const
+{
+    const int step = getStep();
+    return std::size_t((width + step - 1) / step) * std::size_t((height + step - 1) / step);
+}
+
+void GLTiler::operator()(const Kernel& kernel, const GLubyte* input, int width, int height, std::size_t inputStride, GLubyte* output, std::size_t outputStride)
+{
+    AGLET_TRACE_SCOPE("GLTiler", "filter");
+    throw_assert(input && output && (width > 0) && (height > 0), "GLTiler::operator()() : invalid image");
+
+    const std::size_t rowSize = std::size_t(width) * kPixelSize;
+    inputStride = inputStride ? inputStride : rowSize;
+    outputStride = outputStride ? outputStride : rowSize;
+
+    const int step = getStep();
+    for (int y = 0; y < height; y += step)
+    {
+        for (int x = 0; x < width; x += step)
+        {
+            Tile tile;
+            tile.x = x;
+            tile.y = y;
+            tile.width = std::min(step, width - x);
+            tile.height = std::min(step, height - y);
+
+            upload(tile, input, width, height, inputStride);
+            const GLuint texture = kernel(*m_texture);
+            read(tile, texture, output, outputStride);
+        }
+    }
+
+#if defined(AGLET_HAS_PBO)
+    while (!m_pending.empty())
+    {
+        finish(output, outputStride);
+    }
+#endif
+}
+
+void GLTiler::upload(const Tile& tile, const GLubyte* input, int width, int height, std::size_t inputStride)
+{
+    const int size = m_tileSize;
+    const int x0 = tile.x - m_halo;
+    const int y0 = tile.y - m_halo;
+
+    if ((x0 >= 0) && (y0 >= 0) && ((x0 + size) <= width) && ((y0 + size) <= height))
+    {
+        // Interior tile: upload directly from the strided image
+        m_texture->write(input + std::size_t(y0) * inputStride + std::size_t(x0) * kPixelSize, 0, 0, size, size, inputStride);
+        return;
+    }
+
+    // Edge tile: replicate the edge pixels of the image (GL_CLAMP_TO_EDGE)
+    const int lo = std::max(0, -x0);           // first column inside the image
+    const int hi = std::min(size, width - x0); // end of the columns inside the image
+    for (int y = 0; y < size; y++)
+    {
+        const GLubyte* src = input + std::size_t(std::min(std::max(y0 + y, 0), height - 1)) * inputStride;
+        GLubyte* dst = &m_buffer[std::size_t(y) * std::size_t(size) * kPixelSize];
+
+        std::memcpy(dst + std::size_t(lo) * kPixelSize, src + std::size_t(x0 + lo) * kPixelSize, std::size_t(hi - lo) * kPixelSize);
+        for (int x = 0; x < lo; x++)
+        {
+            std::memcpy(dst + std::size_t(x) * kPixelSize, src, kPixelSize);
+        }
+        for (int x = hi; x < size; x++)
+        {
+            std::memcpy(dst + std::size_t(x) * kPixelSize, src + std::size_t(width - 1) * kPixelSize, kPixelSize);
+        }
+    }
+    m_texture->write(m_buffer.data(), 0, 0, size, size);
+}
+
+void GLTiler::read(const Tile& tile, GLuint texture, GLubyte* output, std::size_t outputStride)
+{
+    m_fbo->bind();
+    m_fbo->attach(texture);
+
+#if defined(AGLET_HAS_PBO)
+    std::size_t pbo = m_pending.size();
+    if (pbo == m_depth)
+    {
+        pbo = m_pending.front().pbo;
+        finish(output, outputStride); // bounds the tiles in flight
+    }
+
+    m_pbos[pbo]->bind();
+    m_pbos[pbo]->start(m_halo, m_halo);
+    m_pbos[pbo]->unbind();
+
+    m_pending.push_back(tile);
+    m_pending.back().pbo = pbo;
+#else
+    GLubyte* dst = output + std::size_t(tile.y) * outputStride + std::size_t(tile.x) * kPixelSize;
+    readPixels(m_halo, m_halo, tile.width, tile.height, dst, outputStride);
+#endif
+
+    m_fbo->unbind();
+}
+
+#if defined(AGLET_HAS_PBO)
+void GLTiler::finish(GLubyte* output, std::size_t outputStride)
+{
+    const Tile tile = m_pending.front();
+    m_pending.pop_front();
+
+    GLubyte* dst = output + std::size_t(tile.y) * outputStride + std::size_t(tile.x) * kPixelSize;
+
+    auto& pbo = *m_pbos[tile.pbo];
+    pbo.bind();
+    if ((tile.width == getStep()) && (tile.height == getStep()))
+    {
+        pbo.finish(dst, outputStride); // mapped PBO -> output
+    }
+    else
+    {
+        // Partial tile at the right or bottom edge of the image
+        const std::size_t stride = std::size_t(getStep()) * kPixelSize;
+        pbo.finish(m_buffer.data());
+        copyRows(dst, outputStride, m_buffer.data(), stride, std::size_t(tile.width) * kPixelSize, std::size_t(tile.height));
+    }
+    pbo.unbind();
+}
+#endif
+
+AGLET_END
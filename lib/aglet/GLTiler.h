@@ -0,0 +1,114 @@
+/*!
+  @file   GLTiler.h
+  @brief  Declaration of tiled processing for images larger than the GL texture limits.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLTiler_h__
+#define __aglet_GLTiler_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+AGLET_BEGIN
+
+class GLTexture;
+class GLFrameBufferObject;
+class IPBO;
+
+/*
+ * Run a kernel over a CPU resident RGBA image of any size (i.e., beyond
+ * GL_MAX_TEXTURE_SIZE) in overlapping tiles:
+ *
+ *   aglet::GLTiler tiler(2048, radius);        // tile size, halo
+ *   aglet::GLFilterGraph graph(tiler.getTileSize(), tiler.getTileSize());
+ *   graph.output(graph.pass(fshaderBlurSrc, { graph.input(tiler.getTexture()) }));
+ *   tiler([&](GLuint) { return graph(); }, input, width, height, inputStride, output, outputStride);
+ *
+ * Each tile is uploaded to getTexture() with a border of halo pixels on
+ * every side, the kernel renders the result for the whole tile to a
+ * texture of the same size and returns it, and the interior (without the
+ * halo) is stitched into the output.  Kernels reading at most halo pixels
+ * away from the output pixel (with GL_CLAMP_TO_EDGE) give the same result
+ * as a single pass over the whole image: tile borders outside the image
+ * replicate the edge pixels.
+ *
+ * With pixel buffer objects the readback of a tile is started after its
+ * kernel and finished depth tiles later, so the upload and kernel of the
+ * next tiles overlap the transfer.  Memory is bounded by the tile texture
+ * plus depth readback buffers of (tileSize - 2 * halo)^2 pixels.  Without
+ * pixel buffer objects (OpenGL ES 2.0) each tile is read synchronously.
+ */
+
+class GLTiler
+{
+public:
+    // Render a result for the tile in the input texture, return the (tileSize x tileSize RGBA) texture:
+    using Kernel = std::function<GLuint(GLuint texture)>;
+
+    // The tile size is clamped to getMaxTileSize() for the current context:
+    GLTiler(int tileSize, int halo = 0, std::size_t depth = 2);
+    ~GLTiler();
+
+    GLTiler(const GLTiler&) = delete;
+    GLTiler& operator=(const GLTiler&) = delete;
+
+    // Process a width x height RGBA image in rows of inputStride bytes to output (0: tightly packed):
+    void operator()(const Kernel& kernel, const GLubyte* input, int width, int height, std::size_t inputStride, GLubyte* output, std::size_t outputStride = 0);
+
+    // Input texture of the kernel (tileSize x tileSize RGBA, not modified by the kernel):
+    GLuint getTexture() const;
+
+    int getTileSize() const { return m_tileSize; }
+    int getHalo() const { return m_halo; }
+    int getStep() const { return m_tileSize - 2 * m_halo; } // output pixels per tile side
+    std::size_t getDepth() const { return m_depth; }        // tiles in flight
+
+    // Number of tiles for a width x height image:
+    std::size_t getTileCount(int width, int height) const;
+
+    // Largest tile (texture and render target) supported by the current context:
+    static int getMaxTileSize();
+
+protected:
+    struct Tile
+    {
+        int x = 0; // output region
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        std::size_t pbo = 0;
+    };
+
+    void upload(const Tile& tile, const GLubyte* input, int width, int height, std::size_t inputStride);
+    void read(const Tile& tile, GLuint texture, GLubyte* output, std::size_t outputStride);
+#if defined(AGLET_HAS_PBO)
+    void finish(GLubyte* output, std::size_t outputStride); // oldest pending tile
+#endif
+
+    int m_tileSize = 0;
+    int m_halo = 0;
+    std::size_t m_depth = 0;
+
+    std::unique_ptr<GLTexture> m_texture;
+    std::unique_ptr<GLFrameBufferObject> m_fbo; // readback of the kernel output
+    std::vector<GLubyte> m_buffer;              // edge tiles (padded input, partial output)
+
+#if defined(AGLET_HAS_PBO)
+    std::vector<std::unique_ptr<IPBO>> m_pbos;
+    std::deque<Tile> m_pending;
+#endif
+};
+
+AGLET_END
+
+#endif // __aglet_GLTiler_h__
@@ -0,0 +1,406 @@
+/*!
+  @file   GLTrace.cpp
+  @brief  Implementation of span tracing with Chrome trace_event export.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLTrace.h"
+
+#if defined(AGLET_TRACE)
+
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLContext.h"
+#include "aglet/GLDispatch.h"
+#include "aglet/gl_includes.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+AGLET_BEGIN
+
+struct Span
+{
+    const char* name;
+    const char* category;
+    std::int64_t begin;
+    std::int64_t duration;
+    bool gpu;
+};
+
+// Written by the owning thread only, spans [0, count) are published:
+struct Chunk
+{
+    static const std::size_t kSize = 1024;
+
+    Span spans[kSize];
+    std::atomic<std::size_t> count{ 0 };
+    std::atomic<Chunk*> next{ nullptr };
+};
+
+struct ThreadBuffer
+{
+    // Entries of a context expire with it (GLContext::m_alive), so a new
+    // context at the same address never sees its queries or clock:
+    struct Pending
+    {
+        const GLContext* context;
+        GLuint queries[2];
+        const char* name;
+        const char* category;
+        std::weak_ptr<void> alive;
+        bool ended; // false: the span ended in another context, the queries are only deleted
+    };
+
+    struct Clock
+    {
+        bool supported = false;
+        std::int64_t offset = 0; // CPU - GPU timestamp
+        std::weak_ptr<void> alive;
+    };
+
+    explicit ThreadBuffer(int id)
+        : id(id)
+    {
+        head = tail = new Chunk;
+    }
+
+    ~ThreadBuffer()
+    {
+        reset(nullptr);
+    }
+
+    void add(const Span& span)
+    {
+        std::size_t count = tail->count.load(std::memory_order_relaxed);
+        if (count == Chunk::kSize)
+        {
+            Chunk* chunk = new Chunk;
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+            count = 0;
+        }
+        tail->spans[count] = span;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+
+    // Delete the chunks after keep (all for nullptr):
+    void reset(Chunk* keep)
+    {
+        Chunk* chunk = keep ? keep->next.load() : head;
+        while (chunk)
+        {
+            Chunk* next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+        if (keep)
+        {
+            keep->next.store(nullptr);
+            keep->count.store(0);
+        }
+    }
+
+    int id;
+    Chunk* head = nullptr;
+    Chunk* tail = nullptr;
+
+    std::deque<Pending> pending;              // GPU spans waiting for their queries
+    std::map<const GLContext*, Clock> clocks; // per context
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // outlive their threads
+    std::atomic<bool> enabled{ false };
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+static Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+static ThreadBuffer& getBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer = std::make_shared<ThreadBuffer>(int(registry.buffers.size()) + 1); // tid 0: GPU
+        registry.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Timer queries through the dispatch table of the context (GLDispatch.h):
+static ThreadBuffer::Clock& getClock(ThreadBuffer& buffer, GLContext* context)
+{
+    static ThreadBuffer::Clock unsupported; // no aglet context
+    if (!context)
+    {
+        return unsupported;
+    }
+
+    auto iter = buffer.clocks.find(context);
+    if ((iter != buffer.clocks.end()) && iter->second.alive.expired())
+    {
+        buffer.clocks.erase(iter);
+        iter = buffer.clocks.end();
+    }
+    if (iter == buffer.clocks.end())
+    {
+        const auto& gl = context->getDispatch();
+
+        ThreadBuffer::Clock clock;
+        clock.alive = context->m_alive;
+        clock.supported = gl.hasTimerQuery();
+        if (clock.supported)
+        {
+            std::int64_t timestamp = 0;
+            gl.getInteger64v(GLDispatch::kTimestamp, &timestamp);
+            clock.offset = GLTrace::now() - timestamp;
+        }
+        iter = buffer.clocks.emplace(context, clock).first;
+    }
+    return iter->second;
+}
+
+// Drop the entries of destroyed contexts (their queries went with them):
+static void prune(ThreadBuffer& buffer)
+{
+    for (auto iter = buffer.pending.begin(); iter != buffer.pending.end();)
+    {
+        iter = iter->alive.expired() ? buffer.pending.erase(iter) : std::next(iter);
+    }
+    for (auto iter = buffer.clocks.begin(); iter != buffer.clocks.end();)
+    {
+        iter = iter->second.alive.expired() ? buffer.clocks.erase(iter) : std::next(iter);
+    }
+}
+
+// Add the GPU spans of the current context with available results:
+static void resolve(ThreadBuffer& buffer, bool wait)
+{
+    prune(buffer);
+
+    GLContext* context = GLContext::current();
+    for (auto iter = buffer.pending.begin(); iter != buffer.pending.end();)
+    {
+        if (iter->context != context)
+        {
+            ++iter;
+            continue;
+        }
+
+        const auto& gl = context->getDispatch();
+        if (!iter->ended)
+        {
+            gl.deleteQueries(2, iter->queries);
+            iter = buffer.pending.erase(iter);
+            continue;
+        }
+
+        GLuint available = GL_TRUE;
+        if (!wait)
+        {
+            gl.getQueryObjectuiv(iter->queries[1], GLDispatch::kQueryResultAvailable, &available);
+        }
+        if (!available)
+        {
+            break; // later queries complete later
+        }
+
+        std::uint64_t timestamps[2] = { 0, 0 };
+        gl.getQueryObjectui64v(iter->queries[0], GLDispatch::kQueryResult, &timestamps[0]);
+        gl.getQueryObjectui64v(iter->queries[1], GLDispatch::kQueryResult, &timestamps[1]);
+        gl.deleteQueries(2, iter->queries);
+
+        // GL_EXT_disjoint_timer_query: results are undefined after a disjoint event (i.e., a power state change)
+        GLint disjoint = GL_FALSE;
+        if (context->capabilities().isES())
+        {
+            glGetIntegerv(GLDispatch::kGPUDisjoint, &disjoint);
+        }
+
+        if (!disjoint)
+        {
+            const std::int64_t offset = getClock(buffer, context).offset;
+            buffer.add({ iter->name, iter->category, std::int64_t(timestamps[0]) + offset, std::int64_t(timestamps[1] - timestamps[0]), true });
+        }
+        iter = buffer.pending.erase(iter);
+    }
+}
+
+void GLTrace::start()
+{
+    now(); // epoch
+    getRegistry().enabled.store(true, std::memory_order_relaxed);
+}
+
+void GLTrace::stop()
+{
+    getRegistry().enabled.store(false, std::memory_order_relaxed);
+}
+
+bool GLTrace::isEnabled()
+{
+    return getRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+void GLTrace::collect()
+{
+    resolve(getBuffer(), true);
+}
+
+std::int64_t GLTrace::now()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - getRegistry().epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void GLTrace::add(const char* name, const char* category, std::int64_t begin, std::int64_t duration, bool gpu)
+{
+    getBuffer().add({ name, category, begin, duration, gpu });
+}
+
+// Visit the published spans of all threads (registry is locked):
+template <typename Visitor>
+static void visit(Registry& registry, Visitor&& visitor)
+{
+    for (const auto& buffer : registry.buffers)
+    {
+        for (const Chunk* chunk = buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            const std::size_t count = chunk->count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                visitor(*buffer, chunk->spans[i]);
+            }
+        }
+    }
+}
+
+static void writeTime(std::ostream& os, std::int64_t ns)
+{
+    // trace_event times are in microseconds:
+    os << (ns / 1000) << '.' << char('0' + (ns / 100) % 10) << char('0' + (ns / 10) % 10) << char('0' + ns % 10);
+}
+
+void GLTrace::write(std::ostream& os)
+{
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    os << "{\"traceEvents\":[\n";
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    for (const auto& buffer : registry.buffers)
+    {
+        os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"thread " << buffer->id << "\"}}";
+    }
+
+    visit(registry, [&](const ThreadBuffer& buffer, const Span& span) {
+        os << ",\n{\"name\":\"" << span.name << "\",\"cat\":\"" << span.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (span.gpu ? 0 : buffer.id) << ",\"ts\":";
+        writeTime(os, span.begin);
+        os << ",\"dur\":";
+        writeTime(os, span.duration);
+        os << "}";
+    });
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool GLTrace::save(const std::string& filename)
+{
+    std::ofstream os(filename);
+    if (os)
+    {
+        write(os);
+    }
+    return bool(os);
+}
+
+void GLTrace::clear()
+{
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& buffer : registry.buffers)
+    {
+        buffer->reset(buffer->head);
+        buffer->tail = buffer->head;
+    }
+}
+
+std::size_t GLTrace::size()
+{
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::size_t count = 0;
+    visit(registry, [&](const ThreadBuffer&, const Span&) { count++; });
+    return count;
+}
+
+GLTraceScope::GLTraceScope(const char* name, const char* category, bool gpu)
+    : m_name(name)
+    , m_category(category)
+{
+    if (!GLTrace::isEnabled())
+    {
+        return;
+    }
+
+    if (gpu)
+    {
+        auto& buffer = getBuffer();
+        resolve(buffer, false);
+
+        GLContext* context = GLContext::current();
+        if (getClock(buffer, context).supported)
+        {
+            const auto& gl = context->getDispatch();
+            gl.genQueries(2, m_queries);
+            gl.queryCounter(m_queries[0], GLDispatch::kTimestamp);
+            m_context = context;
+            m_alive = context->m_alive;
+        }
+    }
+
+    m_begin = GLTrace::now();
+}
+
+GLTraceScope::~GLTraceScope()
+{
+    if (m_begin < 0)
+    {
+        return;
+    }
+
+    auto& buffer = getBuffer();
+    buffer.add({ m_name, m_category, m_begin, GLTrace::now() - m_begin, false });
+
+    if (m_queries[0] && !m_alive.expired()) // the queries go with a destroyed context
+    {
+        const bool ended = (GLContext::current() == m_context);
+        if (ended)
+        {
+            m_context->getDispatch().queryCounter(m_queries[1], GLDispatch::kTimestamp);
+        }
+        buffer.pending.push_back({ m_context, { m_queries[0], m_queries[1] }, m_name, m_category, m_alive, ended });
+    }
+}
+
+AGLET_END
+
+#endif // defined(AGLET_TRACE)
@@ -0,0 +1,121 @@
+/*!
+  @file   GLTrace.h
+  @brief  Declaration of span tracing with Chrome trace_event export.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLTrace_h__
+#define __aglet_GLTrace_h__
+
+#include "aglet/aglet.h"
+
+/*
+ * Spans of context creation, make current, render loop frames, transfers,
+ * PBO waits and shader builds, for a timeline of a frame's latency across
+ * threads in chrome://tracing or https://ui.perfetto.dev:
+ *
+ *   aglet::GLTrace::start();
+ *   ...
+ *   aglet::GLTrace::stop();
+ *   aglet::GLTrace::save("aglet-trace.json");
+ *
+ * Tracing is compiled in with the AGLET_TRACE CMake option, without it
+ * the macros below expand to nothing and this class is not declared.
+ *
+ * Each thread appends complete spans to its own buffer of fixed size
+ * chunks without locks (the thread publishes the span count, readers only
+ * read published spans), the registry of thread buffers is only locked
+ * when a thread records its first span and on export.
+ *
+ * GPU spans (AGLET_TRACE_GPU_SCOPE) additionally bracket the work with
+ * GL_TIMESTAMP queries where timer queries are available (desktop OpenGL
+ * 3.3+ or GL_EXT_disjoint_timer_query, see GLDispatch.h).  The queries
+ * are resolved without stalls by later GPU spans on the same thread (or
+ * by GLTrace::collect() in the context), and shown on a separate "GPU"
+ * track in the CPU timeline.  A context destroyed while current resolves
+ * its pending queries first, those of a context destroyed elsewhere are
+ * dropped.  A GPU span that ends while another context is current has no
+ * GPU time, its queries are deleted by its own context.
+ */
+
+#if defined(AGLET_TRACE)
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+AGLET_BEGIN
+
+class GLContext;
+
+class GLTrace
+{
+public:
+    // Start or stop recording (recorded spans are kept until clear()):
+    static void start();
+    static void stop();
+    static bool isEnabled();
+
+    // Resolve the GPU spans of the current context (blocking):
+    static void collect();
+
+    // Export recorded spans as Chrome trace_event JSON:
+    static void write(std::ostream& os);
+    static bool save(const std::string& filename);
+
+    // Drop recorded spans (call while no thread is recording):
+    static void clear();
+
+    // Number of recorded spans:
+    static std::size_t size();
+
+    // Time in nanoseconds since the first use of GLTrace:
+    static std::int64_t now();
+
+    // Add a complete span in nanoseconds (name and category must be string literals):
+    static void add(const char* name, const char* category, std::int64_t begin, std::int64_t duration, bool gpu = false);
+};
+
+// RAII span of the enclosing scope:
+class GLTraceScope
+{
+public:
+    GLTraceScope(const char* name, const char* category, bool gpu = false);
+    ~GLTraceScope();
+
+    GLTraceScope(const GLTraceScope&) = delete;
+    GLTraceScope& operator=(const GLTraceScope&) = delete;
+
+protected:
+    const char* m_name;
+    const char* m_category;
+    std::int64_t m_begin = -1; // disabled
+    unsigned int m_queries[2] = { 0, 0 };
+    GLContext* m_context = nullptr; // of the queries
+    std::weak_ptr<void> m_alive;    // m_context (see GLContext::current())
+};
+
+AGLET_END
+
+// clang-format off
+#define AGLET_TRACE_CONCAT_(a, b) a##b
+#define AGLET_TRACE_CONCAT(a, b) AGLET_TRACE_CONCAT_(a, b)
+#define AGLET_TRACE_SCOPE(name, category) \
+    aglet::GLTraceScope AGLET_TRACE_CONCAT(aglet_trace_, __LINE__)(name, category)
+#define AGLET_TRACE_GPU_SCOPE(name, category) \
+    aglet::GLTraceScope AGLET_TRACE_CONCAT(aglet_trace_, __LINE__)(name, category, true)
+// clang-format on
+
+#else
+
+#define AGLET_TRACE_SCOPE(name, category)
+#define AGLET_TRACE_GPU_SCOPE(name, category)
+
+#endif // defined(AGLET_TRACE)
+
+#endif // __aglet_GLTrace_h__
@@ -0,0 +1,134 @@
+/*!
+  @file   GLTransferTuner.cpp
+  @brief  Implementation of per driver calibration of pixel transfer methods.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLTransferTuner.h"
+#include "aglet/GLCapabilities.h"
+#include "aglet/GLError.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLTexture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+AGLET_BEGIN
+
+#if defined(AGLET_HAS_PBO)
+static const char* getName(GLContext::TransferMethod method)
+{
+    return (method == GLContext::kTransferPBO) ? "pbo" : "direct";
+}
+
+// Cache lines: renderer <tab> version <tab> width <tab> height <tab> readback <tab> upload
+static std::string getKey(GLContext& gl, int width, int height)
+{
+    const auto& caps = gl.capabilities();
+    std::stringstream ss;
+    ss << caps.getRenderer() << '\t' << caps.getVersion() << '\t' << width << '\t' << height;
+    return ss.str();
+}
+
+static bool load(const std::string& cacheFile, const std::string& key, GLContext::TransferStrategy& strategy)
+{
+    std::ifstream is(cacheFile);
+    std::string line;
+    bool found = false;
+    while (std::getline(is, line))
+    {
+        if (line.compare(0, key.size() + 1, key + '\t') != 0)
+        {
+            continue;
+        }
+
+        std::stringstream ss(line.substr(key.size() + 1));
+        std::string readback, upload;
+        ss >> readback >> upload;
+        strategy.readback = (readback == getName(GLContext::kTransferPBO)) ? GLContext::kTransferPBO : GLContext::kTransferDirect;
+        strategy.upload = (upload == getName(GLContext::kTransferPBO)) ? GLContext::kTransferPBO : GLContext::kTransferDirect;
+        found = true; // the last entry wins
+    }
+    return found;
+}
+
+static void store(const std::string& cacheFile, const std::string& key, const GLContext::TransferStrategy& strategy)
+{
+    std::ofstream os(cacheFile, std::ios::app);
+    os << key << '\t' << getName(strategy.readback) << '\t' << getName(strategy.upload) << '\n';
+}
+
+// Best time in seconds of iterations runs (after a warm up run):
+static double measure(const std::function<void()>& transfer, int iterations)
+{
+    transfer();
+    glFinish();
+
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < iterations; i++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        transfer();
+        glFinish();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+#endif
+
+GLContext::TransferStrategy calibrateTransfers(GLContext& gl, int width, int height, const std::string& cacheFile, int iterations)
+{
+    throw_assert((width > 0) && (height > 0) && (iterations > 0), "calibrateTransfers() : invalid size");
+
+    gl();
+
+    GLContext::TransferStrategy strategy;
+
+#if defined(AGLET_HAS_PBO)
+    const std::string key = getKey(gl, width, height);
+    if (cacheFile.empty() || !load(cacheFile, key, strategy))
+    {
+        GLTexture texture(width, height);
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        glClearColor(0.25f, 0.5f, 0.75f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        std::vector<GLubyte> pixels(std::size_t(width) * std::size_t(height) * 4);
+        const auto read = [&](GLContext::TransferMethod method) {
+            return measure([&]() { readPixels(method, 0, 0, width, height, pixels.data()); }, iterations);
+        };
+        strategy.readback = (read(GLContext::kTransferPBO) < read(GLContext::kTransferDirect)) ? GLContext::kTransferPBO : GLContext::kTransferDirect;
+        fbo.unbind();
+
+        texture.bind();
+        const auto write = [&](GLContext::TransferMethod method) {
+            return measure([&]() { writePixels(method, 0, 0, width, height, pixels.data()); }, iterations);
+        };
+        strategy.upload = (write(GLContext::kTransferPBO) < write(GLContext::kTransferDirect)) ? GLContext::kTransferPBO : GLContext::kTransferDirect;
+        texture.unbind();
+
+        checkGLError("calibrateTransfers()");
+
+        if (!cacheFile.empty())
+        {
+            store(cacheFile, key, strategy);
+        }
+    }
+#endif
+
+    gl.setTransferStrategy(strategy, true);
+    return strategy;
+}
+
+AGLET_END
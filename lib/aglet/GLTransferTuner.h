@@ -0,0 +1,46 @@
+/*!
+  @file   GLTransferTuner.h
+  @brief  Declaration of per driver calibration of pixel transfer methods.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLTransferTuner_h__
+#define __aglet_GLTransferTuner_h__
+
+#include "aglet/aglet.h"
+#include "aglet/GLContext.h"
+
+#include <string>
+
+AGLET_BEGIN
+
+/*
+ * The fastest synchronous readback and upload methods depend on the driver
+ * (i.e., glReadPixels to client memory beats a PBO round trip on Mesa
+ * llvmpipe, but not on some discrete GPU drivers).  Optional calibration
+ * after context creation:
+ *
+ *   auto gl = aglet::GLContext::create(aglet::GLContext::kAuto);
+ *   aglet::calibrateTransfers(*gl, 1280, 720, "aglet-transfers.txt");
+ *   ...
+ *   aglet::readPixels(0, 0, 1280, 720, pixels); // calibrated method
+ *
+ * Both methods of each direction are timed for width x height RGBA frames
+ * (including glFinish()) and the faster one is stored in the context's
+ * transfer strategy, which readPixels(), writePixels() and the classes
+ * built on them use while the context is current.  With a cache file the
+ * decision is looked up first and appended after a measurement, keyed by
+ * GL_RENDERER, GL_VERSION and the frame size, so later runs on the same
+ * driver skip the measurement.  Without pixel buffer objects (OpenGL ES
+ * 2.0) the direct methods are selected without measuring.
+ */
+
+// Calibrate the transfer strategy of gl (made current), returns the selection:
+GLContext::TransferStrategy calibrateTransfers(GLContext& gl, int width, int height, const std::string& cacheFile = {}, int iterations = 5);
+
+AGLET_END
+
+#endif // __aglet_GLTransferTuner_h__
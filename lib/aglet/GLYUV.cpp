@@ -0,0 +1,232 @@
+/*!
+  @file   GLYUV.cpp
+  @brief  Implementation of planar and semi-planar YUV upload with GPU colour conversion.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "aglet/GLYUV.h"
+#include "aglet/GLError.h"
+
+#include <string>
+
+AGLET_BEGIN
+
+// clang-format off
+#if defined(AGLET_OPENGL_ES2)
+static const GLint kLumaFormat = GL_LUMINANCE;
+static const GLint kChromaFormat = GL_LUMINANCE_ALPHA;
+static const char* kNV12Src = "#define CHROMA(t) texture2D(uChroma, t).ra\n";
+static const char* kNV21Src = "#define CHROMA(t) texture2D(uChroma, t).ar\n";
+#else
+static const GLint kLumaFormat = GL_RED;
+static const GLint kChromaFormat = GL_RG;
+static const char* kNV12Src = "#define CHROMA(t) texture2D(uChroma, t).rg\n";
+static const char* kNV21Src = "#define CHROMA(t) texture2D(uChroma, t).gr\n";
+#endif
+static const char* kI420Src = "#define CHROMA(t) vec2(texture2D(uChroma, t).r, texture2D(uChroma1, t).r)\n";
+
+static const char* kConversionSrc =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "#endif\n"
+    "varying vec2 vTexCoord;\n"
+    "uniform sampler2D uLuma;\n"
+    "uniform sampler2D uChroma;\n"
+    "uniform sampler2D uChroma1;\n"
+    "uniform mat3 uMatrix;\n"
+    "uniform vec3 uOffset;\n"
+    "void main() {\n"
+    "    vec3 yuv = vec3(texture2D(uLuma, vTexCoord).r, CHROMA(vTexCoord)) + uOffset;\n"
+    "    gl_FragColor = vec4(clamp(uMatrix * yuv, 0.0, 1.0), 1.0);\n"
+    "}\n";
+// clang-format on
+
+static GLint getInternalFormat(GLenum format)
+{
+#if defined(AGLET_OPENGL_ES2)
+    return format; // unsized
+#else
+    return (format == GL_RED) ? GL_R8 : GL_RG8;
+#endif
+}
+
+auto GLYUV::getConversion(ColorSpace colorSpace, Range range) -> Conversion
+{
+    const double kr = (colorSpace == kBT709) ? 0.2126 : 0.299;
+    const double kb = (colorSpace == kBT709) ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+
+    // Video range: Y in [16, 235], UV in [16, 240] (8 bit)
+    const double ys = (range == kVideo) ? (255.0 / 219.0) : 1.0;
+    const double cs = (range == kVideo) ? (255.0 / 224.0) : 1.0;
+
+    Conversion conversion;
+    conversion.matrix = { {
+        GLfloat(ys), 0.f, GLfloat(2.0 * (1.0 - kr) * cs),
+        GLfloat(ys), GLfloat(-2.0 * kb * (1.0 - kb) / kg * cs), GLfloat(-2.0 * kr * (1.0 - kr) / kg * cs),
+        GLfloat(ys), GLfloat(2.0 * (1.0 - kb) * cs), 0.f
+    } };
+    conversion.offset = { { (range == kVideo) ? (-16.f / 255.f) : 0.f, -128.f / 255.f, -128.f / 255.f } };
+    return conversion;
+}
+
+GLYUV::GLYUV(int width, int height, Format format, ColorSpace colorSpace, Range range)
+    : m_width(width)
+    , m_height(height)
+    , m_chromaWidth((width + 1) / 2)
+    , m_chromaHeight((height + 1) / 2)
+    , m_format(format)
+    , m_output(width, height)
+{
+    throw_assert((width > 0) && (height > 0), "GLYUV::GLYUV() : invalid size");
+
+    m_luma.reset(new GLTexture(width, height, getInternalFormat(kLumaFormat), kLumaFormat, GL_UNSIGNED_BYTE));
+    if (format == kI420)
+    {
+        for (auto& chroma : m_chroma)
+        {
+            chroma.reset(new GLTexture(m_chromaWidth, m_chromaHeight, getInternalFormat(kLumaFormat), kLumaFormat, GL_UNSIGNED_BYTE));
+        }
+    }
+    else
+    {
+        m_chroma[0].reset(new GLTexture(m_chromaWidth, m_chromaHeight, getInternalFormat(kChromaFormat), kChromaFormat, GL_UNSIGNED_BYTE));
+    }
+
+    m_fbo.bind();
+    m_fbo.attach(m_output);
+    m_fbo.unbind();
+
+    const char* chromaSrc = (format == kI420) ? kI420Src : ((format == kNV21) ? kNV21Src : kNV12Src);
+    const std::string fshSrc = std::string(chromaSrc) + kConversionSrc;
+    auto status = m_shader.buildFromSrc(GLQuad::getVertexShader(), fshSrc.c_str(), GLQuad::getAttributes());
+    throw_assert(status, "GLYUV::GLYUV() : GLShader::buildFromSrc()");
+
+    const GLuint program = m_shader.getProgramId();
+    m_shader.use();
+    glUniform1i(glGetUniformLocation(program, "uLuma"), 0);
+    glUniform1i(glGetUniformLocation(program, "uChroma"), 1);
+    glUniform1i(glGetUniformLocation(program, "uChroma1"), 2);
+    m_matrix = glGetUniformLocation(program, "uMatrix");
+    m_offset = glGetUniformLocation(program, "uOffset");
+    glUseProgram(0);
+
+    setConversion(colorSpace, range);
+}
+
+GLYUV::~GLYUV() = default;
+
+void GLYUV::setConversion(ColorSpace colorSpace, Range range)
+{
+    const auto conversion = getConversion(colorSpace, range);
+
+    // OpenGL ES 2.0 requires transpose == GL_FALSE (column major):
+    GLfloat matrix[9];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            matrix[j * 3 + i] = conversion.matrix[i * 3 + j];
+        }
+    }
+
+    m_shader.use();
+    glUniformMatrix3fv(m_matrix, 1, GL_FALSE, matrix);
+    glUniform3fv(m_offset, 1, conversion.offset.data());
+    glUseProgram(0);
+
+    checkGLError("GLYUV::setConversion() : glUniformMatrix3fv()");
+}
+
+std::size_t GLYUV::getFrameSize() const
+{
+    return std::size_t(m_width * m_height) + std::size_t(m_chromaWidth * m_chromaHeight) * 2;
+}
+
+void GLYUV::upload(const GLubyte* frame)
+{
+    const GLubyte* chroma = frame + (m_width * m_height);
+    if (m_format == kI420)
+    {
+        upload(frame, chroma, chroma + (m_chromaWidth * m_chromaHeight));
+    }
+    else
+    {
+        upload(frame, chroma);
+    }
+}
+
+void GLYUV::upload(const GLubyte* y, const GLubyte* uv)
+{
+    throw_assert((m_format != kI420), "GLYUV::upload() : I420 requires three planes");
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    m_luma->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, kLumaFormat, GL_UNSIGNED_BYTE, y);
+    m_chroma[0]->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_chromaWidth, m_chromaHeight, kChromaFormat, GL_UNSIGNED_BYTE, uv);
+    m_chroma[0]->unbind();
+
+    checkGLError("GLYUV::upload() : glTexSubImage2D()");
+}
+
+void GLYUV::upload(const GLubyte* y, const GLubyte* u, const GLubyte* v)
+{
+    throw_assert((m_format == kI420), "GLYUV::upload() : NV12/NV21 require two planes");
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    m_luma->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, kLumaFormat, GL_UNSIGNED_BYTE, y);
+    m_chroma[0]->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_chromaWidth, m_chromaHeight, kLumaFormat, GL_UNSIGNED_BYTE, u);
+    m_chroma[1]->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_chromaWidth, m_chromaHeight, kLumaFormat, GL_UNSIGNED_BYTE, v);
+    m_chroma[1]->unbind();
+
+    checkGLError("GLYUV::upload() : glTexSubImage2D()");
+}
+
+GLuint GLYUV::operator()()
+{
+    m_fbo.bind();
+    glViewport(0, 0, m_width, m_height);
+    m_shader.use();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, *m_luma);
+    for (int i = 0; i < 2; i++)
+    {
+        if (m_chroma[i])
+        {
+            glActiveTexture(GL_TEXTURE1 + i);
+            glBindTexture(GL_TEXTURE_2D, *m_chroma[i]);
+        }
+    }
+
+    m_quad.bind();
+    m_quad.draw();
+    m_quad.unbind();
+
+    for (int i = 2; i >= 0; i--)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glUseProgram(0);
+    m_fbo.unbind();
+
+    checkGLError("GLYUV::operator()() : glDrawArrays()");
+    return m_output;
+}
+
+void GLYUV::read(GLubyte* pixels)
+{
+    m_fbo.bind();
+    m_output.read(pixels);
+    m_fbo.unbind();
+}
+
+AGLET_END
@@ -0,0 +1,121 @@
+/*!
+  @file   GLYUV.h
+  @brief  Declaration of planar and semi-planar YUV upload with GPU colour conversion.
+
+  \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __aglet_GLYUV_h__
+#define __aglet_GLYUV_h__
+
+#include "aglet/aglet.h"
+#include "aglet/gl_includes.h"
+#include "aglet/GLFrameBufferObject.h"
+#include "aglet/GLQuad.h"
+#include "aglet/GLShader.h"
+#include "aglet/GLTexture.h"
+
+#include <array>
+#include <memory>
+
+AGLET_BEGIN
+
+/*
+ * Upload 8 bit YUV 4:2:0 frames as one luma and one (NV12, NV21) or two
+ * (I420) half resolution chroma textures and convert them to RGBA on the
+ * GPU, i.e., 1.5 bytes per pixel are uploaded instead of 4:
+ *
+ *   aglet::GLYUV yuv(width, height, aglet::GLYUV::kNV12, aglet::GLYUV::kBT601, aglet::GLYUV::kVideo);
+ *   yuv.upload(frame);         // Y plane followed by the UV plane
+ *   GLuint rgba = yuv();       // conversion pass
+ *
+ * Planes are tightly packed, chroma planes are ((width + 1) / 2) x
+ * ((height + 1) / 2).  Single channel textures are GL_LUMINANCE and
+ * GL_LUMINANCE_ALPHA on OpenGL ES 2.0 and GL_R8 and GL_RG8 otherwise.
+ */
+
+class GLYUV
+{
+public:
+    enum Format
+    {
+        kNV12, // Y + interleaved UV
+        kNV21, // Y + interleaved VU (Android camera)
+        kI420  // Y + U + V
+    };
+
+    enum ColorSpace
+    {
+        kBT601,
+        kBT709
+    };
+
+    enum Range
+    {
+        kVideo, // Y in [16, 235], UV in [16, 240]
+        kFull   // Y, UV in [0, 255]
+    };
+
+    // Row major 3x3 matrix applied to (Y, U, V) after the offset is added:
+    struct Conversion
+    {
+        std::array<GLfloat, 9> matrix;
+        std::array<GLfloat, 3> offset;
+    };
+
+    GLYUV(int width, int height, Format format, ColorSpace colorSpace = kBT601, Range range = kVideo);
+    ~GLYUV();
+
+    // Upload a contiguous frame (planes in format order):
+    void upload(const GLubyte* frame);
+
+    // Upload the luma and chroma planes (NV12, NV21):
+    void upload(const GLubyte* y, const GLubyte* uv);
+
+    // Upload the luma and chroma planes (I420):
+    void upload(const GLubyte* y, const GLubyte* u, const GLubyte* v);
+
+    // Convert the last upload to RGBA, return the output texture:
+    GLuint operator()();
+
+    // Read the output (RGBA) after operator()():
+    void read(GLubyte* pixels);
+
+    // Change the conversion without reallocating textures:
+    void setConversion(ColorSpace colorSpace, Range range);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    Format getFormat() const { return m_format; }
+
+    // Size in bytes of a contiguous frame:
+    std::size_t getFrameSize() const;
+
+    GLuint getLuma() const { return *m_luma; }
+    GLuint getTexture() const { return m_output; }
+
+    static Conversion getConversion(ColorSpace colorSpace, Range range);
+
+protected:
+    int m_width = 0;
+    int m_height = 0;
+    int m_chromaWidth = 0;
+    int m_chromaHeight = 0;
+    Format m_format = kNV12;
+
+    std::unique_ptr<GLTexture> m_luma;
+    std::unique_ptr<GLTexture> m_chroma[2]; // UV or U and V
+
+    GLTexture m_output;
+    GLFrameBufferObject m_fbo;
+    GLQuad m_quad;
+    GLShader m_shader;
+    GLint m_matrix = -1;
+    GLint m_offset = -1;
+};
+
+AGLET_END
+
+#endif // __aglet_GLYUV_h__
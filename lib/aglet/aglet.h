@@ -14,6 +14,11 @@
 // clang-format off
 #define AGLET_BEGIN namespace aglet {
 #define AGLET_END }
+
+// POSIX mmap and shared memory (FrameRing, GLFrameRing, GLFrameSink, GLMappedImage):
+#if !defined(_WIN32)
+#  define AGLET_HAS_POSIX 1
+#endif
 // clang-format on
 
 #endif
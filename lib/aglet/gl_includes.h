@@ -41,7 +41,10 @@
 #    define AGLET_OSX 1
 #  endif
 #elif defined(__ANDROID__) || defined(ANDROID)
-#  if defined(AGLET_OPENGL_ES3)
+#  if defined(AGLET_OPENGL_ES31)
+#    include <GLES3/gl31.h>
+#    include <GLES3/gl3ext.h>
+#  elif defined(AGLET_OPENGL_ES3)
 #    include <GLES3/gl3.h>
 #    include <GLES3/gl3ext.h>
 #  else
@@ -54,6 +57,9 @@
 #  if defined(AGLET_OPENGL_ES2)
 #    include <GLES2/gl2.h>
 #    include <GLES2/gl2ext.h>
+#  elif defined(AGLET_OPENGL_ES31)
+#    include <GLES3/gl31.h>
+#    include <GLES3/gl3ext.h>
 #  elif defined(AGLET_OPENGL_ES3)
 #    include <GLES3/gl3.h>
 #    include <GLES3/gl3ext.h>
@@ -65,6 +71,36 @@
 #else
 #  error platform not supported.
 #endif
+
+// Pixel buffer objects: OpenGL ES 3.0 or desktop OpenGL
+#if defined(AGLET_OPENGL_ES3)
+#  define AGLET_HAS_PBO 1
+#elif !defined(AGLET_OPENGL_ES2) && !defined(AGLET_ANDROID) && !defined(AGLET_IOS)
+#  define AGLET_HAS_PBO 1
+#endif
+
+// Texture arrays and instanced draws: OpenGL ES 3.0 or desktop OpenGL 3.x (core profile on OS X)
+#if defined(AGLET_OPENGL_ES3)
+#  define AGLET_HAS_TEXTURE_ARRAY 1
+#elif !defined(AGLET_OPENGL_ES2) && !defined(AGLET_ANDROID) && !defined(AGLET_IOS) && !defined(AGLET_OSX)
+#  define AGLET_HAS_TEXTURE_ARRAY 1
+#endif
+
+// Compute shaders: OpenGL ES 3.1 or desktop OpenGL 4.3 (not available on Apple platforms)
+#if defined(AGLET_OPENGL_ES31)
+#  define AGLET_HAS_COMPUTE 1
+#elif !defined(AGLET_OPENGL_ES2) && !defined(AGLET_OPENGL_ES3) && !defined(AGLET_ANDROID) && !defined(AGLET_IOS) && !defined(AGLET_OSX)
+#  define AGLET_HAS_COMPUTE 1
+#endif
+
+// GL call statistics (GLStats.h): AGLET_GL_STATS builds, entry points are GLEW macros on Windows
+#if defined(AGLET_GL_STATS) && !defined(AGLET_MSVC)
+#  define AGLET_HAS_GL_STATS 1
+#endif
 // clang-format on
 
+#if defined(AGLET_HAS_GL_STATS)
+#  include "aglet/GLIntercept.h"
+#endif
+
 #endif
@@ -1,4 +1,29 @@
 #include <aglet/GLContext.h>
+#include <aglet/GLContextStatic.h>
+#include <aglet/GLBuffer.h>
+#include <aglet/GLCapabilities.h>
+#include <aglet/GLBatch.h>
+#include <aglet/GLComputeProgram.h>
+#include <aglet/GLDeletionQueue.h>
+#include <aglet/GLDispatch.h>
+#include <aglet/GLFilterGraph.h>
+#include <aglet/GLFrameBufferObject.h>
+#include <aglet/GLFrameRing.h>
+#include <aglet/GLFrameSink.h>
+#include <aglet/GLIncrementalUploader.h>
+#include <aglet/GLMappedImage.h>
+#include <aglet/GLMemory.h>
+#include <aglet/GLNamePool.h>
+#include <aglet/GLPackedReader.h>
+#include <aglet/GLPBO.h>
+#include <aglet/GLPyramid.h>
+#include <aglet/GLReduction.h>
+#include <aglet/GLShader.h>
+#include <aglet/GLTexture.h>
+#include <aglet/GLTiler.h>
+#include <aglet/GLTrace.h>
+#include <aglet/GLTransferTuner.h>
+#include <aglet/GLYUV.h>
 #include "aglet/gl_includes.h"
 #include <gtest/gtest.h>
 
@@ -16,12 +41,20 @@
 
 #if defined(AGLET_OPENGL_ES2)
 static const auto glKind = aglet::GLContext::kGLES20;
+#elif defined(AGLET_OPENGL_ES31)
+static const auto glKind = aglet::GLContext::kGLES31;
 #elif defined(AGLET_OPENGL_ES3)
 static const auto glKind = aglet::GLContext::kGLES30;
 #else
 static const auto glKind = aglet::GLContext::kGL;
 #endif
 
+#if defined(AGLET_OPENGL_ES31)
+static const auto glComputeKind = aglet::GLContext::kGLES31;
+#else
+static const auto glComputeKind = aglet::GLContext::kGL43;
+#endif
+
 static void check_gl_error()
 {
     auto e = glGetError();
@@ -33,706 +66,1842 @@ static void check_gl_error()
     }
 }
 
-class GLFrameBufferObject
+using aglet::GLFrameBufferObject;
+using aglet::GLTexture;
+
+int gauze_main(int argc, char** argv)
 {
-public:
-    GLFrameBufferObject()
+    try
     {
-        glGenFramebuffers(1, &id);
-        check_gl_error();
+        ::testing::InitGoogleTest(&argc, argv);
+        auto code = RUN_ALL_TESTS();
+        return code;
     }
-
-    ~GLFrameBufferObject()
+    catch (std::exception& e)
     {
-        glDeleteFramebuffers(1, &id);
-        check_gl_error();
+        std::cerr << "Exception: " << e.what() << std::endl;
     }
+    catch (...)
+    {
+        std::cout << "Unknown exception" << std::endl;
+    }
+    return 1; // return non-zero
+}
 
-    void bind()
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(AGLET_HAS_POSIX)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(AGLET_EGL)
+#include <EGL/egl.h>
+#endif
+
+using rgba_t = std::array<std::uint8_t, 4>;
+using image_rgba_t = std::vector<rgba_t>;
+
+static image_rgba_t make_test_image(int rows, int cols)
+{
+    image_rgba_t image(rows * cols);
+    for (int y = 0; y < rows; y++)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, id);
-        check_gl_error();
+        for (int x = 0; x < cols; x++)
+        {
+            std::uint8_t value = (y + 1) % 255;
+            image[y * cols + x] = { { value, value, value, 255 } };
+        }
     }
+    return image;
+}
+
+TEST(aglet, glReadPixels)
+{
+    const int width = 640;
+    const int height = 480;
 
-    void unbind()
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    check_gl_error();
+    (*gl)();
+    check_gl_error();
+    ASSERT_TRUE(gl);
+
+    glActiveTexture(GL_TEXTURE0);
+    check_gl_error();
+
+    (*gl)();
+
+    image_rgba_t image0 = make_test_image(height, width);
+    image_rgba_t image1(image0.size());
+
+    GLFrameBufferObject fbo;
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+    check_gl_error();
+    fbo.bind();
+    check_gl_error();
+
+    fbo.attach(texture);
+    check_gl_error();
+    texture.read(image1.data()->data());
+
+    ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
+}
+
+TEST(aglet, readPixelsStrided)
+{
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    image_rgba_t image0(width * height);
+    for (int y = 0; y < height; y++)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        check_gl_error();
+        for (int x = 0; x < width; x++)
+        {
+            image0[y * width + x] = { { std::uint8_t(x % 256), std::uint8_t(y % 256), std::uint8_t(x / 256), std::uint8_t(y / 256) } };
+        }
     }
+    GLTexture texture(width, height, GL_RGBA, image0.data()->data());
+    GLFrameBufferObject fbo;
+    fbo.bind();
+    fbo.attach(texture);
+
+    // ROI into caller rows with padding, check the padding is untouched:
+    const int x0 = 13, y0 = 7, cols = 101, rows = 50;
+    const auto check = [&](const std::vector<std::uint8_t>& buffer, std::size_t stride) {
+        for (int y = 0; y < rows; y++)
+        {
+            for (std::size_t i = 0; i < stride; i++)
+            {
+                const std::uint8_t expected = (i < std::size_t(cols * 4)) ? image0[(y0 + y) * width + x0 + int(i / 4)][i % 4] : 0xaa;
+                if (buffer[y * stride + i] != expected)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
 
-    void attach(GLuint texId, GLenum attachment = GL_COLOR_ATTACHMENT0, GLenum target = GL_TEXTURE_2D)
+    // GL_PACK_ROW_LENGTH (stride in pixels), scratch buffer + copyRows() (odd stride):
+    for (std::size_t stride : { std::size_t(cols * 4 + 36), std::size_t(cols * 4 + 3) })
     {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, target, texId, 0);
+        std::vector<std::uint8_t> buffer(stride * rows, 0xaa);
+        texture.read(buffer.data(), x0, y0, cols, rows, stride);
         check_gl_error();
-        GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        ASSERT_TRUE(check(buffer, stride)) << "stride " << stride;
+    }
 
+#if defined(AGLET_HAS_PBO)
+    { // Asynchronous ROI:
+        const std::size_t stride = cols * 4 + 12;
+        std::vector<std::uint8_t> buffer(stride * rows, 0xaa);
+        aglet::IPBO pbo(cols, rows);
+        pbo.bind();
+        pbo.start(x0, y0);
+        pbo.finish(buffer.data(), stride);
+        pbo.unbind();
         check_gl_error();
-        if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
+        ASSERT_TRUE(check(buffer, stride));
+    }
+#endif
+
+    fbo.unbind();
+}
+
+TEST(aglet, GLIncrementalUploader)
+{
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    // Frames live in a padded buffer (GL_UNPACK_ROW_LENGTH, or a copy on OpenGL ES 2.0):
+    const std::size_t stride = width * 4 + 16;
+    std::vector<std::uint8_t> frame(stride * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width * 4; x++)
         {
-            std::stringstream ss;
-            ss << "Framebuffer incomplete :" << int(fboStatus);
-            throw std::runtime_error(ss.str());
+            frame[y * stride + x] = std::uint8_t((x + y * 3) % 256);
         }
     }
 
-protected:
-    GLuint id;
-};
+    GLTexture texture(width, height, GL_RGBA, nullptr);
+    GLFrameBufferObject fbo;
+    fbo.bind();
+    fbo.attach(texture);
+    fbo.unbind();
 
-class GLTexture
+    const auto matches = [&]() {
+        image_rgba_t image(width * height);
+        fbo.bind();
+        texture.read(image.data()->data());
+        fbo.unbind();
+        for (int y = 0; y < height; y++)
+        {
+            if (std::memcmp(image[y * width].data(), &frame[y * stride], width * 4) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    aglet::GLIncrementalUploader uploader(texture, 64);
+    uploader.upload(frame.data(), stride); // full
+    ASSERT_EQ(uploader.getDirty().size(), std::size_t(1));
+    ASSERT_EQ(uploader.getUploadSize(), std::size_t(width * height * 4));
+    ASSERT_TRUE(matches());
+
+    uploader.upload(frame.data(), stride); // unchanged
+    ASSERT_EQ(uploader.getDirty().size(), std::size_t(0));
+
+    // Two changes in adjacent tiles (one span) and one in the last partial tile row:
+    frame[100 * stride + 63 * 4] ^= 0xff;
+    frame[120 * stride + 64 * 4 + 1] ^= 0xff;
+    frame[(height - 1) * stride + (width - 1) * 4 + 2] ^= 0xff;
+    uploader.upload(frame.data(), stride);
+    ASSERT_EQ(uploader.getDirty().size(), std::size_t(2));
+    ASSERT_EQ(uploader.getDirty()[0].width, 128);
+    ASSERT_EQ(uploader.getDirty()[1].height, height - 448);
+    ASSERT_LT(uploader.getUploadSize(), std::size_t(width * height * 4 / 10));
+    ASSERT_TRUE(matches());
+
+    // Caller provided dirty rectangles:
+    aglet::GLIncrementalUploader::Rect rect;
+    rect.x = 5;
+    rect.y = 7;
+    rect.width = 33;
+    rect.height = 21;
+    for (int y = rect.y; y < (rect.y + rect.height); y++)
+    {
+        std::fill(&frame[y * stride + rect.x * 4], &frame[y * stride + (rect.x + rect.width) * 4], std::uint8_t(y));
+    }
+    uploader.upload(frame.data(), stride, { rect });
+    ASSERT_EQ(uploader.getUploadSize(), std::size_t(rect.width * rect.height * 4));
+    ASSERT_TRUE(matches());
+    check_gl_error();
+}
+
+#if defined(AGLET_HAS_POSIX)
+// Scratch files go to the temporary directory, not the working directory:
+static std::string temp_path(const std::string& name)
 {
-public:
-    GLTexture(std::size_t width, std::size_t height, GLenum texType, void* data)
-        : width(width)
-        , height(height)
+    const char* dir = std::getenv("TMPDIR");
+    return std::string((dir && *dir) ? dir : "/tmp") + "/" + std::to_string(getpid()) + "-" + name; // test binaries may run in parallel
+}
+
+// ... and are removed on every exit of the test:
+struct TempFile
+{
+    explicit TempFile(const std::string& name)
+        : path(temp_path(name))
     {
-        glGenTextures(1, &texId);
-        check_gl_error();
-        bind();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        check_gl_error();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        check_gl_error();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        check_gl_error();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        check_gl_error();
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        check_gl_error();
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, texType, GL_UNSIGNED_BYTE, data);
-        check_gl_error();
-        unbind();
     }
+    ~TempFile() { std::remove(path.c_str()); }
+    const std::string path;
+};
+
+TEST(aglet, GLFrameSink)
+{
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    ~GLTexture()
+    GLTexture texture(width, height, GL_RGBA, nullptr);
+    GLFrameBufferObject fbo;
+    fbo.bind();
+    fbo.attach(texture);
+
+    const TempFile temp("aglet-frame-sink.agf");
+    const std::string& filename = temp.path;
+    const std::size_t capacity = 5, frames = 4;
     {
-        glDeleteTextures(1, &texId);
-        check_gl_error();
+        aglet::GLFrameSink sink(filename, width, height, capacity, 2);
+        for (std::size_t i = 0; i < frames; i++)
+        {
+            glClearColor(float(i) / 255.f, 0.f, 1.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ASSERT_TRUE(sink(1000 + i));
+        }
+        ASSERT_EQ(sink.getCount(), frames);
+    } // flush + close
+    fbo.unbind();
+    check_gl_error();
+
+    aglet::GLFrameFile file(filename);
+    ASSERT_EQ(file.getHeader().width, std::uint32_t(width));
+    ASSERT_EQ(file.getHeader().capacity, capacity);
+    ASSERT_EQ(file.getCount(), frames);
+    for (std::size_t i = 0; i < frames; i++)
+    {
+        ASSERT_EQ(file.getTimestamp(i), 1000 + i);
+        const GLubyte* frame = file.getFrame(i);
+        for (int k = 0; k < (width * height); k += 997)
+        {
+            ASSERT_EQ(int(frame[k * 4 + 0]), int(i));
+            ASSERT_EQ(int(frame[k * 4 + 2]), 255);
+        }
     }
 
-    void bind()
+    // Corrupt files are rejected when opened:
+    const auto patch = [&](std::size_t offset, std::uint64_t value) {
+        std::fstream fs(filename, std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(std::streamoff(offset));
+        fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    const std::uint64_t count = file.getHeader().count;
+    const std::size_t entry = sizeof(aglet::GLFrameFileHeader) + sizeof(aglet::GLFrameFileEntry); // frame 1
+    patch(offsetof(aglet::GLFrameFileHeader, count), capacity + 1);
+    ASSERT_THROW(aglet::GLFrameFile{ filename }, std::exception);
+    patch(offsetof(aglet::GLFrameFileHeader, count), count);
+    patch(entry + offsetof(aglet::GLFrameFileEntry, offset), ~std::uint64_t(0) - 16);
+    ASSERT_THROW(aglet::GLFrameFile{ filename }, std::exception);
+}
+
+TEST(aglet, GLMappedImage)
+{
+    const int width = 333;
+    const int height = 211;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    // Raw file: header, then padded rows:
+    const TempFile temp("aglet-mapped-image.raw");
+    const std::string& filename = temp.path;
+    const std::size_t offset = 123, stride = width * 4 + 12;
+    std::vector<GLubyte> file(offset + stride * height, 0);
+    for (int y = 0; y < height; y++)
     {
-        glBindTexture(GL_TEXTURE_2D, texId);
-        check_gl_error();
+        for (int x = 0; x < width; x++)
+        {
+            GLubyte* pixel = &file[offset + y * stride + x * 4];
+            pixel[0] = GLubyte(x);
+            pixel[1] = GLubyte(y);
+            pixel[2] = GLubyte(x + y);
+            pixel[3] = 255;
+        }
     }
+    FILE* fp = std::fopen(filename.c_str(), "wb");
+    ASSERT_TRUE(fp);
+    ASSERT_EQ(std::fwrite(file.data(), 1, file.size(), fp), file.size());
+    std::fclose(fp);
+
+    std::vector<std::tuple<aglet::GLMappedImage::Transfer, int>> uploads = {
+        std::make_tuple(aglet::GLMappedImage::kClientPointer, 50),
+        std::make_tuple(aglet::GLMappedImage::kAuto, 0),
+    };
+#if defined(AGLET_HAS_PBO)
+    uploads.push_back(std::make_tuple(aglet::GLMappedImage::kPBO, 50));
+#endif
 
-    void unbind()
     {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        check_gl_error();
+        aglet::GLMappedImage image(filename, offset, width, height, stride);
+        for (const auto& upload : uploads)
+        {
+            GLTexture texture(width, height, GL_RGBA, nullptr);
+            image.upload(texture, std::get<0>(upload), std::get<1>(upload));
+            check_gl_error();
+
+            GLFrameBufferObject fbo;
+            fbo.bind();
+            fbo.attach(texture);
+            std::vector<GLubyte> pixels(width * height * 4);
+            texture.read(pixels.data());
+            fbo.unbind();
+            for (int y = 0; y < height; y++)
+            {
+                ASSERT_EQ(std::memcmp(&pixels[y * width * 4], &file[offset + y * stride], width * 4), 0);
+            }
+        }
     }
+}
 
-    void read(GLubyte* pixels)
+// Consumer process: no OpenGL, exit status 0 if the last frame was seen intact
+static int consume_frame_ring(const std::string& name, std::uint64_t frames)
+{
+    try
     {
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        check_gl_error();
-        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-        check_gl_error();
+        std::unique_ptr<aglet::FrameRingConsumer> consumer;
+        for (int i = 0; (i < 500) && !consumer; i++)
+        {
+            try
+            {
+                consumer.reset(new aglet::FrameRingConsumer(name));
+            }
+            catch (...)
+            {
+                usleep(10000); // producer hasn't created the ring yet
+            }
+        }
+        if (!consumer)
+        {
+            return 1;
+        }
+
+        std::uint64_t count = 0;
+        while ((count = consumer->wait(count, 5000)) > 0)
+        {
+            aglet::FrameRingConsumer::Frame frame;
+            if (consumer->acquire(frame))
+            {
+                // The clear color encodes the frame number:
+                const bool intact = (frame.data[0] == GLubyte(frame.number * 10)) && (frame.data[2] == 255) && (frame.timestamp == 1000 + frame.number);
+                if (consumer->isValid(frame))
+                {
+                    if (!intact)
+                    {
+                        return 2;
+                    }
+                    if (frame.number == (frames - 1))
+                    {
+                        return 0;
+                    }
+                }
+            }
+        }
+        return 3; // timeout
     }
+    catch (...)
+    {
+        return 4;
+    }
+}
 
-    operator GLuint() const
+TEST(aglet, GLFrameRing)
+{
+    const int width = 320;
+    const int height = 240;
+    const std::uint64_t frames = 8;
+    const std::string name = "/aglet-ring-" + std::to_string(getpid());
+
+    // Fork before creating the context, the child never touches OpenGL:
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
     {
-        return texId;
+        _exit(consume_frame_ring(name, frames));
     }
 
-protected:
-    std::size_t width;
-    std::size_t height;
-    GLuint texId;
-};
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-#if defined(AGLET_OPENGL_ES3)
+    GLTexture texture(width, height, GL_RGBA, nullptr);
+    GLFrameBufferObject fbo;
+    fbo.bind();
+    fbo.attach(texture);
 
-namespace Tools
-{
-void checkGLErr(const char* cls, const char* msg)
+    {
+        aglet::GLFrameRing ring(name, width, height, 4, 2);
+        for (std::uint64_t i = 0; i < frames; i++)
+        {
+            glClearColor(float(i * 10) / 255.f, 0.f, 1.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ring(1000 + i);
+        }
+        ring.flush();
+        ASSERT_EQ(ring.getCount(), frames);
+
+        // The local consumer maps the same frames:
+        aglet::FrameRingConsumer consumer(name);
+        ASSERT_EQ(consumer.getCount(), frames);
+        ASSERT_EQ(consumer.getHeader().width, std::uint32_t(width));
+        aglet::FrameRingConsumer::Frame frame;
+        ASSERT_TRUE(consumer.acquire(frames - 1, frame));
+        ASSERT_EQ(int(frame.data[(width * height - 1) * 4]), int((frames - 1) * 10));
+        ASSERT_FALSE(consumer.acquire(0, frame)); // overwritten
+
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+    } // unlink
+    fbo.unbind();
+    check_gl_error();
+}
+#endif
+
+TEST(aglet, swapInterval)
 {
-    GLenum err = glGetError();
-    if (err != GL_NO_ERROR)
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 640, 480, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    for (auto interval : { 0, 1, -1 })
     {
-        std::cerr << cls << " " << msg << " - GL error " << err << " occurred" << std::endl;
+        bool honoured = gl->setSwapInterval(interval);
+        ASSERT_EQ(honoured, gl->isSwapIntervalHonoured());
+        ASSERT_EQ(honoured, (gl->getSwapInterval() == interval));
+        ASSERT_GE(gl->getSwapInterval(), (interval < 0) ? interval : 0);
     }
 }
-}
 
-class IPBO
+TEST(aglet, run)
 {
-public:
-    /**
-     * Constructor.
-     */
-    IPBO(std::size_t width, std::size_t height);
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 640, 480, glKind);
+    ASSERT_TRUE(gl);
+    gl->setSwapInterval(0);
 
-    /**
-     * Destructor.
-     */
-    ~IPBO();
+    int frames = 0;
+    aglet::run(*gl, [&]() { return (++frames < 8); });
+    ASSERT_EQ(frames, 8);
 
-    /**
-     * Bind the PBO (GL_PIXEL_PACK_BUFFER)
-     */
-    void bind();
+    // The virtual render loop shares the same implementation:
+    aglet::GLContext::RenderDelegate delegate = [&]() { return (++frames < 16); };
+    (*gl)(delegate);
+    ASSERT_EQ(frames, 16);
+}
 
-    /**
-     * Unbind the PBO (GL_PIXEL_PACK_BUFFER).
-     */
-    void unbind();
+#define AGLET_TO_STR_(x) #x
+#define AGLET_TO_STR(x) AGLET_TO_STR_(x)
 
-    /**
-     * Start read operation (asynchronous/non-blocking).
-     */
-    void start(); // asynchronous
+// Real-world shader test from here:
+// https://github.com/hunter-packages/ogles_gpgpu/blob/hunter/ogles_gpgpu/common/proc/rgb2luv.cpp
 
-    /**
-     * Pack/read pixels to <buffer> (blocking call) after a call to start().
-     */
-    void finish(GLubyte* buffer); // asynchronous
+// clang-format off
+const char* vshaderRgb2LuvSrc = AGLET_TO_STR(
+  attribute vec4 aPos;
+  attribute vec2 aTexCoord;
+  varying vec2 vTexCoord;
+  void main() {
+    gl_Position = aPos;
+    vTexCoord = aTexCoord;
+  });
 
-    /**
-     * Perform a blocking pack from the PBO.
-     */
-    void read(GLubyte* buffer); // synchronous (start, finish)
+const char* fshaderRgb2LuvSrc = 
+#if defined(AGLET_OPENGLES)
+AGLET_TO_STR(precision highp float;)
+#endif
+AGLET_TO_STR(
+  varying vec2 vTexCoord;
+  uniform sampler2D uInputTex;
 
-    /**
-     * Returns current processing state for asynchronous read.
-     */
-    bool isReadingAsynchronously() const;
+  const mat3 RGBtoXYZ = mat3(0.430574, 0.341550, 0.178325, 0.222015, 0.706655, 0.071330, 0.020183, 0.129553, 0.93918);
 
-protected:
-    bool isReadingAsynchronously_ = false; // read state (async API)
-    std::size_t width;                     // width of PBO
-    std::size_t height;                    // head of PBO
-    GLuint pbo;                            // ID of created PBO
-};
+  const float y0 = 0.00885645167; // pow(6.0/29.0, 3.0)
+  const float a = 903.296296296;  // pow(29.0/3.0, 3.0);
+  const float un = 0.197833;
+  const float vn = 0.468331;
+  const float maxi = 0.0037037037;  // 1.0/270.0;
+  const float minu = -88.0 * maxi;
+  const float minv = -134.0 * maxi;
+  const vec3 k = vec3(1.0, 15.0, 3.0);
+  const vec3 RGBtoGray = vec3(0.2125, 0.7154, 0.0721);
 
-class OPBO
-{
-public:
-    /**
-     * Constructor.
-     */
-    OPBO(std::size_t width, std::size_t height);
-
-    /**
-     * Destructor.
-     */
-    ~OPBO();
-
-    /**
-     * Bind the PBO (GL_PIXEL_UNPACK_BUFFER)
-     */
-    void bind();
-
-    /**
-     * Unbind the PBO (GL_PIXEL_UNPACK_BUFFER)
-     */
-    void unbind();
-
-    /**
-     * Unpack/write pixels in <buffer> to texture <texId>.
-     */
-    void write(const GLubyte* buffer, GLuint texId = 0);
-
-protected:
-    std::size_t width;  // width of PBO
-    std::size_t height; // head of PBO
-    GLuint pbo;         // ID of created PBO
-};
+  void main()
+  {
+      vec3 rgb = texture2D(uInputTex, vTexCoord).rgb;
+      vec3 xyz = (rgb * RGBtoXYZ);
+      float z = 1.0/(dot(xyz,k) + 1e-35);
+
+      vec3 luv;
+      float y = xyz.y;
+      float l = ((y > y0) ? ((116.0 * pow(y, 0.3333333333)) - 16.0) : (y*a)) * maxi;
+      luv.x = l;
+      luv.y = l * ((52.0 * xyz.x * z) - (13.0*un)) - minu;
+      luv.z = l * ((117.0 * xyz.y * z) - (13.0*vn)) - minv;
+
+      gl_FragColor = vec4(vec3(luv.xyz), dot(rgb, RGBtoGray));
+  }
+);
+// clang-format on
 
-IPBO::IPBO(std::size_t width, std::size_t height)
-    : width(width)
-    , height(height)
-    , isReadingAsynchronously_(false)
+TEST(aglet, glShader)
 {
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    check_gl_error();
+    (*gl)();
+    check_gl_error();
+    ASSERT_TRUE(gl);
+    aglet::GLShader shader;
+    auto value = shader.buildFromSrc(vshaderRgb2LuvSrc, fshaderRgb2LuvSrc);
+    ASSERT_TRUE(value);
+}
 
-    glGenBuffers(1, &pbo);
-    Tools::checkGLErr("IPBO::IPBO", "glGenBuffers()");
+// clang-format off
+const char* fshaderInvertSrc =
+#if defined(AGLET_OPENGLES)
+AGLET_TO_STR(precision highp float;)
+#endif
+AGLET_TO_STR(
+  varying vec2 vTexCoord;
+  uniform sampler2D uInputTex;
+  void main()
+  {
+      vec4 rgba = texture2D(uInputTex, vTexCoord);
+      gl_FragColor = vec4(vec3(1.0) - rgba.rgb, rgba.a);
+  }
+);
 
-    std::size_t pbo_size = width * height * 4;
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    Tools::checkGLErr("IPBO::IPBO", "glBindBuffer()");
+const char* fshaderAddSrc =
+#if defined(AGLET_OPENGLES)
+AGLET_TO_STR(precision highp float;)
+#endif
+AGLET_TO_STR(
+  varying vec2 vTexCoord;
+  uniform sampler2D uInputTex;
+  uniform sampler2D uInputTex1;
+  void main()
+  {
+      gl_FragColor = texture2D(uInputTex, vTexCoord) + texture2D(uInputTex1, vTexCoord);
+  }
+);
+// clang-format on
 
-    glBufferData(GL_PIXEL_PACK_BUFFER, pbo_size, 0, GL_DYNAMIC_READ);
-    Tools::checkGLErr("IPBO::IPBO", "glBufferData()");
+TEST(aglet, GLFilterGraph)
+{
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    Tools::checkGLErr("IPBO::IPBO", "glBindBuffer()");
+    image_rgba_t image0 = make_test_image(height, width);
+    image_rgba_t image1(image0.size());
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    { // Linear chain: 6 inversions ping-pong between two render targets
+        aglet::GLFilterGraph graph(width, height);
+        auto node = graph.input(texture);
+        for (int i = 0; i < 6; i++)
+        {
+            node = graph.pass(fshaderInvertSrc, { node });
+        }
+        graph.pass(fshaderRgb2LuvSrc, { node }); // dead pass is skipped
+        graph.output(node);
+        graph();
+        graph.read(image1.data()->data());
+        check_gl_error();
+
+        ASSERT_EQ(graph.getTargetCount(), 2);
+        ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
+    }
+
+    { // Diamond: input + invert(input) == 1
+        aglet::GLFilterGraph graph(width, height);
+        auto src = graph.input(texture);
+        auto inv = graph.pass(fshaderInvertSrc, { src });
+        auto sum = graph.pass(fshaderAddSrc, { src, inv });
+        graph.output(sum);
+        graph();
+        graph.read(image1.data()->data());
+        check_gl_error();
+
+        for (const auto& pixel : image1)
+        {
+            ASSERT_EQ(pixel[0], 255);
+            ASSERT_EQ(pixel[1], 255);
+            ASSERT_EQ(pixel[2], 255);
+        }
+    }
 }
 
-IPBO::~IPBO()
+TEST(aglet, GLFilterGraphFusion)
 {
-    if (pbo > 0)
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    image_rgba_t image0 = make_test_image(height, width);
+    image_rgba_t image1(image0.size()), image2(image0.size());
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    // invert -> gain -> threshold
+    aglet::GLFilterGraph graph(width, height);
+    auto src = graph.input(texture);
+    auto inv = graph.elementwise("vec4 process(vec4 c, vec4 p) { return vec4(vec3(1.0) - c.rgb, c.a); }", src);
+    auto gain = graph.elementwise("vec4 process(vec4 c, vec4 p) { return vec4(c.rgb * p.x, c.a); }", inv, { { 2.f } });
+    auto thresh = graph.elementwise("vec4 process(vec4 c, vec4 p) { return vec4(step(p.xxx, c.rgb), c.a); }", gain, { { 0.5f } });
+    graph.output(thresh);
+
+    graph();
+    graph.read(image1.data()->data());
+    ASSERT_EQ(graph.getPassCount(), 3);
+
+    graph.setFusion(true);
+    graph();
+    graph.read(image2.data()->data());
+    ASSERT_EQ(graph.getPassCount(), 1);
+    ASSERT_EQ(graph.getTargetCount(), 1);
+    check_gl_error();
+
+    ASSERT_TRUE(std::equal(image1.begin(), image1.end(), image2.begin()));
+    for (int y = 0; y < height; y++)
     {
-        glDeleteBuffers(1, &pbo);
-        Tools::checkGLErr("IPBO::~IPBO", "glDeleteBuffers()");
-        pbo = 0;
+        const int expected = (2 * (255 - image0[y * width][0]) >= 128) ? 255 : 0;
+        ASSERT_EQ(image2[y * width][0], expected);
     }
+
+    // Stage params are uniforms, updates don't require recompilation:
+    graph.setParams(thresh, { { 2.f } });
+    graph();
+    graph.read(image2.data()->data());
+    ASSERT_EQ(image2.front()[0], 0);
 }
 
-bool IPBO::isReadingAsynchronously() const
+TEST(aglet, GLReduction)
 {
-    return isReadingAsynchronously_;
+    // Odd size: partial 4x4 blocks at the borders of every level
+    const int width = 637;
+    const int height = 479;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    image_rgba_t image0 = make_test_image(height, width);
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    double sum = 0.0;
+    float lower = 1.f, upper = 0.f;
+    for (const auto& pixel : image0)
+    {
+        const float value = float(pixel[0]) / 255.f;
+        sum += value;
+        lower = std::min(lower, value);
+        upper = std::max(upper, value);
+    }
+    const float mean = float(sum / double(image0.size()));
+
+    aglet::GLReduction reduceMean(width, height, aglet::GLReduction::kMean);
+    aglet::GLReduction reduceSum(width, height, aglet::GLReduction::kSum);
+    aglet::GLReduction reduceMin(width, height, aglet::GLReduction::kMin);
+    aglet::GLReduction reduceMax(width, height, aglet::GLReduction::kMax);
+    ASSERT_EQ(reduceMean.getLevelCount(), std::size_t(5)); // 160x120 ... 1x1
+
+    // RGBA8 levels (OpenGL ES 2.0) round every level to 1/255:
+    const float tolerance = reduceMean.isFloat() ? 1e-4f : (4.f / 255.f);
+
+    reduceMean.start(texture);
+    reduceSum.start(texture);
+    const auto valueMean = reduceMean.finish();
+    const auto valueSum = reduceSum.finish();
+    ASSERT_NEAR(valueMean[0], mean, tolerance);
+    ASSERT_NEAR(valueMean[3], 1.f, tolerance);
+    ASSERT_NEAR(valueSum[0] / float(sum), 1.f, tolerance);
+    ASSERT_NEAR(reduceMin(texture)[0], lower, 1e-4f);
+    ASSERT_NEAR(reduceMax(texture)[0], upper, 1e-4f);
+    check_gl_error();
 }
 
-void IPBO::bind()
+// Reference pyramid level (R channel), sizes follow the mip chain:
+static std::vector<int> make_level(const std::vector<int>& src, int width, int height, bool gaussian)
 {
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    Tools::checkGLErr("IPBO::bind", "glBindBuffer()");
+    const int cols = std::max(width / 2, 1), rows = std::max(height / 2, 1);
+    const int w[4] = { 1, 3, 3, 1 };
+    std::vector<int> dst(rows * cols);
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            int sum = 0, total = 0;
+            for (int j = (gaussian ? -1 : 0); j < (gaussian ? 3 : 2); j++)
+            {
+                for (int i = (gaussian ? -1 : 0); i < (gaussian ? 3 : 2); i++)
+                {
+                    const int u = std::min(std::max(x * 2 + i, 0), width - 1);
+                    const int v = std::min(std::max(y * 2 + j, 0), height - 1);
+                    const int weight = gaussian ? (w[i + 1] * w[j + 1]) : 1;
+                    sum += src[v * width + u] * weight;
+                    total += weight;
+                }
+            }
+            dst[y * cols + x] = (sum + total / 2) / total;
+        }
+    }
+    return dst;
 }
 
-void IPBO::unbind()
+TEST(aglet, GLPyramid)
 {
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    Tools::checkGLErr("IPBO::unbind", "glBindBuffer()");
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    image_rgba_t image0 = make_test_image(height, width);
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    for (auto filter : { aglet::GLPyramid::kBox, aglet::GLPyramid::kGaussian })
+    {
+        aglet::GLPyramid pyramid(width, height, 4, filter);
+        ASSERT_EQ(pyramid.getLevelCount(), std::size_t(4));
+        ASSERT_EQ(pyramid.getAtlasWidth(), width + width / 2);
+        ASSERT_EQ(pyramid.getAtlasHeight(), height);
+        ASSERT_EQ(pyramid.getLevel(3).y, height / 2 + height / 4);
+
+        pyramid(texture);
+        image_rgba_t atlas(pyramid.getAtlasWidth() * pyramid.getAtlasHeight());
+        pyramid.start();
+        pyramid.finish(atlas.data()->data());
+        check_gl_error();
+
+        std::vector<int> level(image0.size());
+        std::transform(image0.begin(), image0.end(), level.begin(), [](const rgba_t& pixel) { return int(pixel[0]); });
+        for (std::size_t i = 0; i < pyramid.getLevelCount(); i++)
+        {
+            const auto& rect = pyramid.getLevel(i);
+            if (i > 0)
+            {
+                const auto& parent = pyramid.getLevel(i - 1);
+                level = make_level(level, parent.width, parent.height, (filter == aglet::GLPyramid::kGaussian));
+            }
+
+            int error = 0;
+            for (int y = 0; y < rect.height; y++)
+            {
+                for (int x = 0; x < rect.width; x++)
+                {
+                    const auto& pixel = atlas[(rect.y + y) * pyramid.getAtlasWidth() + rect.x + x];
+                    error = std::max(error, std::abs(int(pixel[0]) - level[y * rect.width + x]));
+                }
+            }
+            ASSERT_LE(error, 2) << "level " << i;
+        }
+    }
 }
 
-void IPBO::start()
+#if defined(AGLET_HAS_TEXTURE_ARRAY)
+TEST(aglet, GLBatch)
 {
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    if (!isReadingAsynchronously_)
+    image_rgba_t image0 = make_test_image(height, width);
+    GLTexture frame(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    // clang-format off
+    const char* invertSrc = AGLET_TO_STR(
+      vec4 process(vec2 texCoord, float layer) {
+          vec4 color = texture(uInputTex, vec3(texCoord, layer));
+          return vec4(1.0 - color.rgb, color.a);
+      });
+    // clang-format on
+
+    const int size = 32, uploads = 40, crops = 10;
+    aglet::GLBatch batch(size, size, uploads + crops, invertSrc);
+
+    // Chips 0...uploads-1 from memory (one upload), the rest cropped from the frame:
+    image_rgba_t chips(uploads * size * size);
+    for (int i = 0; i < uploads; i++)
     {
-        glReadBuffer(GL_COLOR_ATTACHMENT0);
-        Tools::checkGLErr("IPBO::start", "glReadBuffer()");
+        for (int j = 0; j < size * size; j++)
+        {
+            const auto value = std::uint8_t(i * 5 + j % size);
+            chips[i * size * size + j] = { { value, value, value, 255 } };
+        }
+    }
+    batch.upload(chips.data()->data(), 0, uploads);
+    for (int i = 0; i < crops; i++)
+    {
+        batch.copy(uploads + i, frame, i * 10, i * 20);
+    }
 
-        // Note glReadPixels last argument == 0 for PBO reads
-        glReadPixels(0, 0, width, height, TEXTURE_FORMAT, GL_UNSIGNED_BYTE, 0);
-        Tools::checkGLErr("IPBO::start", "glReadPixels()");
+    batch(uploads + crops);
+    image_rgba_t atlas(batch.getAtlasWidth() * batch.getAtlasHeight());
+    batch.read(atlas.data()->data());
+    check_gl_error();
 
-        isReadingAsynchronously_ = true;
+    const int cols = batch.getColumns();
+    for (int i = 0; i < (uploads + crops); i++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                const auto& pixel = atlas[((i / cols) * size + y) * batch.getAtlasWidth() + (i % cols) * size + x];
+                const auto& expected = (i < uploads) ? chips[i * size * size + y * size + x] : image0[((i - uploads) * 20 + y) * width + (i - uploads) * 10 + x];
+                ASSERT_EQ(int(pixel[0]), 255 - int(expected[0])) << "item " << i;
+                ASSERT_EQ(int(pixel[3]), 255);
+            }
+        }
     }
 }
+#endif
 
-void IPBO::finish(GLubyte* buffer)
+TEST(aglet, GLYUV)
 {
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    if (isReadingAsynchronously_)
-    {
-        std::size_t pbo_size = width * height * 4;
-#if defined(AGLET_OSX)
-        // Note: glMapBufferRange does not seem to work in OS X
-        GLubyte* ptr = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
-#else
-        GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pbo_size, GL_MAP_READ_BIT));
-#endif
-        Tools::checkGLErr("IPBO::finish", "glMapBufferRange()");
+    // Reference conversion from the published coefficients (Kr, Kb) and ranges,
+    // independent of GLYUV::getConversion(), to 8 bit RGB:
+    const auto reference = [](float Yc, float Uc, float Vc, aglet::GLYUV::ColorSpace space, aglet::GLYUV::Range range) {
+        const bool video = (range == aglet::GLYUV::kVideo);
+        const float y = video ? (Yc - 16.f) / 219.f : Yc / 255.f;
+        const float cb = (Uc - 128.f) / (video ? 224.f : 255.f);
+        const float cr = (Vc - 128.f) / (video ? 224.f : 255.f);
+        const float kr = (space == aglet::GLYUV::kBT601) ? 0.299f : 0.2126f;
+        const float kb = (space == aglet::GLYUV::kBT601) ? 0.114f : 0.0722f;
+        const float kg = 1.f - kr - kb;
+        const float rgb[3] = {
+            y + 2.f * (1.f - kr) * cr,
+            y - (2.f * kb * (1.f - kb) * cb + 2.f * kr * (1.f - kr) * cr) / kg,
+            y + 2.f * (1.f - kb) * cb
+        };
+        std::array<int, 3> result;
+        for (int c = 0; c < 3; c++)
+        {
+            result[c] = int(std::min(std::max(rgb[c], 0.f), 1.f) * 255.f + 0.5f);
+        }
+        return result;
+    };
+
+    { // Fixed points: video range black and white, BT.709 red (Y 63, Cb 102, Cr 240) and BT.601 red (Y 81, Cb 90, Cr 240)
+        const int size = 16;
+        const auto convert = [&](std::uint8_t Yc, std::uint8_t Uc, std::uint8_t Vc, aglet::GLYUV::ColorSpace space) {
+            aglet::GLYUV yuv(size, size, aglet::GLYUV::kI420, space, aglet::GLYUV::kVideo);
+            std::vector<std::uint8_t> frame(size * size, Yc);
+            frame.insert(frame.end(), size * size / 4, Uc);
+            frame.insert(frame.end(), size * size / 4, Vc);
+            yuv.upload(frame.data());
+            yuv();
+            image_rgba_t image(size * size);
+            yuv.read(image.data()->data());
+            return image[(size / 2) * size + size / 2];
+        };
+        const auto near = [](const rgba_t& pixel, int r, int g, int b) {
+            return (std::abs(pixel[0] - r) <= 2) && (std::abs(pixel[1] - g) <= 2) && (std::abs(pixel[2] - b) <= 2);
+        };
+        for (auto space : { aglet::GLYUV::kBT601, aglet::GLYUV::kBT709 })
+        {
+            ASSERT_TRUE(near(convert(16, 128, 128, space), 0, 0, 0));
+            ASSERT_TRUE(near(convert(235, 128, 128, space), 255, 255, 255));
+        }
+        ASSERT_TRUE(near(convert(63, 102, 240, aglet::GLYUV::kBT709), 255, 0, 0));
+        ASSERT_TRUE(near(convert(81, 90, 240, aglet::GLYUV::kBT601), 255, 0, 0)); // BT.601 red
+        check_gl_error();
+    }
 
-        if (ptr)
+    // Luma with detail, chroma varying in x (U) and y (V), quantized to 8 bits.
+    // The expected chroma interpolates the stored samples as the bilinear
+    // upsampling does, which is exact away from the borders:
+    const int cols = width / 2, rows = height / 2;
+    std::vector<std::uint8_t> Y(width * height), U(cols * rows), V(cols * rows);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
         {
-            memcpy(buffer, ptr, pbo_size);
+            Y[y * width + x] = std::uint8_t(40 + (x * 3 + y * 7) % 160);
+        }
+    }
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            U[y * cols + x] = std::uint8_t(100 + x * 60 / cols);
+            V[y * cols + x] = std::uint8_t(90 + y * 70 / rows);
+        }
+    }
 
-            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-            Tools::checkGLErr("IPBO::finish", "glUnmapBuffer()");
+    const std::vector<std::tuple<aglet::GLYUV::Format, aglet::GLYUV::ColorSpace, aglet::GLYUV::Range>> cases = {
+        std::make_tuple(aglet::GLYUV::kNV12, aglet::GLYUV::kBT601, aglet::GLYUV::kVideo),
+        std::make_tuple(aglet::GLYUV::kNV21, aglet::GLYUV::kBT709, aglet::GLYUV::kFull),
+        std::make_tuple(aglet::GLYUV::kI420, aglet::GLYUV::kBT709, aglet::GLYUV::kVideo)
+    };
+
+    for (const auto& test : cases)
+    {
+        const auto format = std::get<0>(test);
+        aglet::GLYUV yuv(width, height, format, std::get<1>(test), std::get<2>(test));
+
+        std::vector<std::uint8_t> frame(Y);
+        for (int i = 0; i < (cols * rows); i++)
+        {
+            switch (format)
+            {
+                case aglet::GLYUV::kNV12:
+                    frame.push_back(U[i]);
+                    frame.push_back(V[i]);
+                    break;
+                case aglet::GLYUV::kNV21:
+                    frame.push_back(V[i]);
+                    frame.push_back(U[i]);
+                    break;
+                case aglet::GLYUV::kI420:
+                    break;
+            }
         }
+        if (format == aglet::GLYUV::kI420)
+        {
+            frame.insert(frame.end(), U.begin(), U.end());
+            frame.insert(frame.end(), V.begin(), V.end());
+        }
+        ASSERT_EQ(frame.size(), yuv.getFrameSize());
 
-        isReadingAsynchronously_ = false;
+        yuv.upload(frame.data());
+        yuv();
+        image_rgba_t image(width * height);
+        yuv.read(image.data()->data());
+        check_gl_error();
+
+        // Bilinear sample of a chroma plane at the center of a luma pixel:
+        const auto sample = [&](const std::vector<std::uint8_t>& plane, int x, int y) {
+            const float fx = (x + 0.5f) / 2.f - 0.5f, fy = (y + 0.5f) / 2.f - 0.5f;
+            const int x0 = int(std::floor(fx)), y0 = int(std::floor(fy));
+            const float ax = fx - x0, ay = fy - y0;
+            const auto at = [&](int i, int j) { return float(plane[j * cols + i]); };
+            return (1.f - ay) * ((1.f - ax) * at(x0, y0) + ax * at(x0 + 1, y0)) + ay * ((1.f - ax) * at(x0, y0 + 1) + ax * at(x0 + 1, y0 + 1));
+        };
+
+        int error = 0;
+        for (int y = 2; y < (height - 2); y++)
+        {
+            for (int x = 2; x < (width - 2); x++)
+            {
+                const auto expected = reference(Y[y * width + x], sample(U, x, y), sample(V, x, y), std::get<1>(test), std::get<2>(test));
+                for (int c = 0; c < 3; c++)
+                {
+                    error = std::max(error, std::abs(int(image[y * width + x][c]) - expected[c]));
+                }
+            }
+        }
+        ASSERT_LE(error, 3) << "format " << int(format);
     }
 }
 
-void IPBO::read(GLubyte* buffer)
+TEST(aglet, GLPackedReader)
 {
-    start();        // Use start() and
-    finish(buffer); // finish() pair for consistent internal state
-}
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-// ::: output/write  :::
+    image_rgba_t image0(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            image0[y * width + x] = { { std::uint8_t(x % 256), std::uint8_t(y % 256), std::uint8_t((x + y) % 256), 255 } };
+        }
+    }
+    GLTexture texture(width, height, GL_RGBA, image0.data()->data());
+
+    // BT.601 video range (defaults):
+    const auto Y = [&](int x, int y) {
+        const auto& p = image0[y * width + x];
+        return 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+    };
+
+    { // kRed and kLuma: 1 byte per pixel
+        aglet::GLPackedReader red(width, height, aglet::GLPackedReader::kRed);
+        aglet::GLPackedReader luma(width, height, aglet::GLPackedReader::kLuma);
+        ASSERT_EQ(red.getSize(), std::size_t(width * height));
+
+        std::vector<std::uint8_t> r(red.getSize()), l(luma.getSize());
+        red.start(texture);
+        luma.start(texture);
+        red.finish(r.data());
+        luma.finish(l.data());
+        check_gl_error();
 
-OPBO::OPBO(std::size_t width, std::size_t height)
-    : width(width)
-    , height(height)
-{
+        int errorR = 0, errorL = 0;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                errorR = std::max(errorR, std::abs(int(r[y * width + x]) - int(image0[y * width + x][0])));
+                errorL = std::max(errorL, std::abs(int(l[y * width + x]) - int(16.f + Y(x, y) * 219.f / 255.f + 0.5f)));
+            }
+        }
+        ASSERT_EQ(errorR, 0);
+        ASSERT_LE(errorL, 1);
+    }
 
-    glGenBuffers(1, &pbo);
-    Tools::checkGLErr("OPBO::OPBO", "glGenBuffers()");
+    { // kNV12: 1.5 bytes per pixel
+        aglet::GLPackedReader reader(width, height, aglet::GLPackedReader::kNV12);
+        ASSERT_EQ(reader.getSize(), std::size_t(width * height * 3 / 2));
 
-    std::size_t pbo_size = width * height * 4;
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
-    Tools::checkGLErr("OPBO::OPBO", "glBindBuffer()");
+        std::vector<std::uint8_t> nv12(reader.getSize());
+        reader.read(texture, nv12.data());
+        check_gl_error();
 
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size, 0, GL_STREAM_DRAW);
-    Tools::checkGLErr("OPBO::OPBO", "glBufferData()");
+        const std::uint8_t* uv = nv12.data() + width * height;
+        int error = 0;
+        for (int y = 0; y < height / 2; y++)
+        {
+            for (int x = 0; x < width / 2; x++)
+            {
+                float b = 0.f, r = 0.f, l = 0.f;
+                for (int k = 0; k < 4; k++)
+                {
+                    const int u = x * 2 + (k % 2), v = y * 2 + (k / 2);
+                    b += image0[v * width + u][2] / 4.f;
+                    r += image0[v * width + u][0] / 4.f;
+                    l += Y(u, v) / 4.f;
+                }
+                const int U = int(128.f + (b - l) / (2.f * (1.f - 0.114f)) * 224.f / 255.f + 0.5f);
+                const int V = int(128.f + (r - l) / (2.f * (1.f - 0.299f)) * 224.f / 255.f + 0.5f);
+                error = std::max(error, std::abs(int(uv[(y * width / 2 + x) * 2 + 0]) - U));
+                error = std::max(error, std::abs(int(uv[(y * width / 2 + x) * 2 + 1]) - V));
+            }
+        }
+        ASSERT_LE(error, 1);
+    }
 
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-    Tools::checkGLErr("OPBO::OPBO", "glBindBuffer()");
+#if !defined(AGLET_OPENGL_ES2)
+    if (aglet::hasFloatRenderTargets())
+    { // kHalfFloat: 8 bytes per pixel for float results
+        std::vector<GLfloat> values(width * height * 4);
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            values[i] = float(int(i % 1000) - 300) / 100.f; // [-3, 7)
+        }
+        GLTexture input(width, height, GL_RGBA32F, GL_RGBA, GL_FLOAT, values.data());
+        input.setFilter(GL_NEAREST);
+
+        aglet::GLPackedReader reader(width, height, aglet::GLPackedReader::kHalfFloat);
+        ASSERT_EQ(reader.getSize(), std::size_t(width * height * 8));
+
+        std::vector<std::uint16_t> halfs(width * height * 4);
+        reader.read(input, halfs.data());
+        check_gl_error();
+
+        const auto half_to_float = [](std::uint16_t h) {
+            const int sign = (h >> 15) ? -1 : 1;
+            const int exponent = (h >> 10) & 0x1f;
+            const int mantissa = h & 0x3ff;
+            if (exponent == 0)
+            {
+                return sign * std::ldexp(float(mantissa), -24);
+            }
+            return sign * std::ldexp(float(mantissa + 1024), exponent - 25);
+        };
+
+        float error = 0.f;
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            error = std::max(error, std::abs(half_to_float(halfs[i]) - values[i]));
+        }
+        ASSERT_LE(error, 4e-3f); // 11 bit mantissa
+    }
+#endif
 }
 
-OPBO::~OPBO()
+TEST(aglet, calibrateTransfers)
 {
-    if (pbo > 0)
+    const int width = 160;
+    const int height = 120;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    ASSERT_EQ(aglet::GLContext::current(), gl.get());
+    ASSERT_FALSE(gl->isTransferCalibrated());
+
+    const std::string cacheFile = "aglet-transfers.txt";
+    std::remove(cacheFile.c_str());
+    auto strategy = aglet::calibrateTransfers(*gl, width, height, cacheFile, 2);
+    ASSERT_TRUE(gl->isTransferCalibrated());
+    ASSERT_EQ(gl->getTransferStrategy().readback, strategy.readback);
+    ASSERT_EQ(gl->getTransferStrategy().upload, strategy.upload);
+
+#if defined(AGLET_HAS_PBO)
+    // The cached decision is used without measuring, edit it to tell:
     {
-        glDeleteBuffers(1, &pbo);
-        Tools::checkGLErr("OPBO::~OPBO", "glDeleteBuffers()");
-        pbo = 0;
+        std::ifstream is(cacheFile);
+        std::string line;
+        ASSERT_TRUE(std::getline(is, line));
+        ASSERT_NE(line.find(reinterpret_cast<const char*>(glGetString(GL_RENDERER))), std::string::npos);
+        std::ofstream os(cacheFile, std::ios::app);
+        os << line.substr(0, line.rfind('\t', line.rfind('\t') - 1)) << "\tpbo\tdirect\n";
     }
-}
+    strategy = aglet::calibrateTransfers(*gl, width, height, cacheFile);
+    ASSERT_EQ(strategy.readback, aglet::GLContext::kTransferPBO);
+    ASSERT_EQ(strategy.upload, aglet::GLContext::kTransferDirect);
 
-void OPBO::bind()
-{
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
-    Tools::checkGLErr("OPBO::bind", "glBindBuffer()");
+    const std::vector<aglet::GLContext::TransferMethod> methods = { aglet::GLContext::kTransferDirect, aglet::GLContext::kTransferPBO };
+#else
+    ASSERT_EQ(strategy.readback, aglet::GLContext::kTransferDirect);
+    const std::vector<aglet::GLContext::TransferMethod> methods = { aglet::GLContext::kTransferDirect };
+#endif
+    std::remove(cacheFile.c_str());
+
+    // Both methods through the strategy of the current context (strided region):
+    const image_rgba_t image = make_test_image(height, width);
+    const std::size_t stride = (width + 3) * 4;
+    for (auto method : methods)
+    {
+        aglet::GLContext::TransferStrategy manual;
+        manual.readback = method;
+        manual.upload = method;
+        gl->setTransferStrategy(manual);
+        ASSERT_FALSE(gl->isTransferCalibrated());
+
+        GLTexture texture(width, height, GL_RGBA, nullptr);
+        texture.write(image.data()->data(), 0, 0, width, height);
+
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        std::vector<GLubyte> pixels(stride * height, 7);
+        texture.read(pixels.data(), 0, 0, width, height, stride);
+        image_rgba_t frame(width * height);
+        texture.read(frame.data()->data()); // full frame
+        fbo.unbind();
+        check_gl_error();
+
+        for (int y = 0; y < height; y++)
+        {
+            ASSERT_EQ(std::memcmp(&pixels[y * stride], &image[y * width], width * 4), 0);
+            ASSERT_EQ(pixels[y * stride + width * 4], 7);
+        }
+        ASSERT_EQ(std::memcmp(frame.data(), image.data(), width * height * 4), 0);
+    }
+
+#if defined(AGLET_HAS_PBO)
+    // PBO transfers reuse the buffers of the context:
+    ASSERT_TRUE(gl->m_packBuffer && gl->m_unpackBuffer);
+    const GLuint pack = *gl->m_packBuffer, unpack = *gl->m_unpackBuffer;
+    {
+        GLTexture texture(width / 2, height / 2, GL_RGBA, nullptr);
+        texture.write(image.data()->data(), 0, 0, width / 2, height / 2, width * 4);
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        image_rgba_t frame(width * height / 4);
+        texture.read(frame.data()->data());
+        fbo.unbind();
+    }
+    ASSERT_EQ(GLuint(*gl->m_packBuffer), pack);
+    ASSERT_EQ(GLuint(*gl->m_unpackBuffer), unpack);
+    check_gl_error();
+#endif
 }
 
-void OPBO::unbind()
+#if defined(AGLET_TRACE)
+TEST(aglet, GLTrace)
 {
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-    Tools::checkGLErr("OPBO::unbind", "glBindBuffer()");
+    bool timerQuery = false;
+    aglet::GLTrace::clear();
+    aglet::GLTrace::start();
+    {
+        const int width = 64;
+        const int height = 48;
+
+        { // A GPU span ending after its context is gone has no GPU time
+            auto gone = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+            ASSERT_TRUE(gone);
+            AGLET_TRACE_GPU_SCOPE("destroyed", "test");
+            gone.reset();
+        }
+
+        aglet::GLContext::GLContextPtr other; // outlives gl (contexts share the EGL display)
+        auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+        ASSERT_TRUE(gl);
+
+        GLTexture texture(width, height, GL_RGBA, nullptr);
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        std::vector<GLubyte> pixels(width * height * 4);
+        texture.read(pixels.data(), 0, 0, width, height);
+        fbo.unbind();
+        check_gl_error();
+
+        { // ... nor one ending in another context
+            other = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+            ASSERT_TRUE(other);
+            (*gl)();
+            {
+                AGLET_TRACE_GPU_SCOPE("switched", "test");
+                (*other)();
+            }
+            (*gl)();
+        }
+
+        aglet::GLTrace::collect();
+
+        // Pending GPU spans are resolved when the context is destroyed
+        texture.read(pixels.data(), 0, 0, width, height);
+        timerQuery = gl->getDispatch().hasTimerQuery();
+    }
+    aglet::GLTrace::stop();
+
+    const std::size_t count = aglet::GLTrace::size();
+    ASSERT_GE(count, 2); // context creation, readPixels
+
+    // Spans are not recorded while stopped:
+    aglet::GLTrace::add("manual", "test", aglet::GLTrace::now(), 1000);
+    ASSERT_EQ(aglet::GLTrace::size(), count + 1);
+    {
+        AGLET_TRACE_SCOPE("stopped", "test");
+    }
+    ASSERT_EQ(aglet::GLTrace::size(), count + 1);
+
+    const std::string filename = "aglet-trace.json";
+    ASSERT_TRUE(aglet::GLTrace::save(filename));
+    {
+        std::ifstream is(filename);
+        const std::string json((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        ASSERT_EQ(json.find("{\"traceEvents\":["), 0);
+        ASSERT_NE(json.find("\"name\":\"GLContext::create\""), std::string::npos);
+        ASSERT_NE(json.find("\"name\":\"readPixels\""), std::string::npos);
+        ASSERT_NE(json.find("\"name\":\"manual\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+
+        std::size_t gpuSpans = 0;
+        for (std::size_t pos = json.find("\"tid\":0,\"ts\""); pos != std::string::npos; pos = json.find("\"tid\":0,\"ts\"", pos + 1))
+        {
+            gpuSpans++;
+        }
+        ASSERT_EQ(gpuSpans, timerQuery ? 2 : 0); // both readbacks
+    }
+    std::remove(filename.c_str());
+
+    aglet::GLTrace::clear();
+    ASSERT_EQ(aglet::GLTrace::size(), 0);
 }
+#endif
 
-void OPBO::write(const GLubyte* buffer, GLuint texId)
+#if defined(AGLET_GL_STATS) && !defined(AGLET_MSVC)
+TEST(aglet, GLStats)
 {
-    std::size_t pbo_size = width * height * 4;
+    const int width = 64;
+    const int height = 48;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    ASSERT_TRUE(aglet::GLStats::isCompiled());
+
+    auto& stats = gl->getStats();
+    stats.reset();
+
+    GLTexture texture(width, height, GL_RGBA, nullptr);
+    GLFrameBufferObject fbo;
+    fbo.bind();
+    fbo.attach(texture);
+    stats.frame(); // setup
 
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size, NULL, GL_STREAM_DRAW);
-    Tools::checkGLErr("OPBO::write", "glBufferData()");
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, texture); // redundant
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, texture); // other unit
+    glActiveTexture(GL_TEXTURE0);
 
-#if defined(AGLET_OSX)
-    // TODO: glMapBufferRange does not seem to work in OS X
-    GLubyte* ptr = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
-    Tools::checkGLErr("OPBO::write", "glMapBuffer()");
-#else
-    GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pbo_size, GL_MAP_WRITE_BIT));
-    Tools::checkGLErr("OPBO::write", "glMapBufferRange()");
+    for (int i = 0; i < 2 * aglet::GLStats::kGetErrorLoop; i++) // polling: one warning per run
+    {
+        glGetError();
+    }
+    ASSERT_EQ(glGetError(), GL_NO_ERROR);
+
+    std::vector<GLubyte> pixels(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glFinish();
+    fbo.unbind();
+    stats.frame();
+
+    const auto& frame = stats.getFrame();
+    ASSERT_EQ(stats.getFrameCount(), 2);
+    ASSERT_EQ(frame.calls[aglet::GLStats::kBindTexture].calls, 4);
+    ASSERT_EQ(frame.calls[aglet::GLStats::kActiveTexture].calls, 2);
+    ASSERT_GE(frame.calls[aglet::GLStats::kGetError].calls, 2);
+    ASSERT_EQ(frame.calls[aglet::GLStats::kReadPixels].calls, 1);
+    ASSERT_EQ(frame.calls[aglet::GLStats::kFinish].calls, 1);
+    ASSERT_GE(frame.getCalls(), 10);
+    ASSERT_GT(frame.getTime(), 0);
+
+    ASSERT_EQ(frame.warnings[aglet::GLStats::kWarnRedundantBind], 1);
+    ASSERT_EQ(frame.warnings[aglet::GLStats::kWarnGetErrorLoop], 1);
+    ASSERT_EQ(frame.warnings[aglet::GLStats::kWarnFinish], 1);
+    ASSERT_EQ(frame.warnings[aglet::GLStats::kWarnSyncReadPixels], 1);
+
+#if defined(AGLET_HAS_PBO)
+    // Readback into a pack buffer is asynchronous:
+    GLuint pbo = 0;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, pixels.size(), nullptr, GL_STREAM_READ);
+    fbo.bind();
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    fbo.unbind();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+    stats.frame();
+    ASSERT_EQ(stats.getFrame().calls[aglet::GLStats::kReadPixels].calls, 1);
+    ASSERT_EQ(stats.getFrame().warnings[aglet::GLStats::kWarnSyncReadPixels], 0);
 #endif
 
-    if (ptr)
-    {
-        memcpy(ptr, buffer, pbo_size);
+    // Disabled per context:
+    stats.setEnabled(false);
+    glFinish();
+    stats.frame();
+    ASSERT_EQ(stats.getFrame().getCalls(), 0);
+    ASSERT_EQ(stats.getTotal().warnings[aglet::GLStats::kWarnFinish], 1);
 
-        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-        Tools::checkGLErr("OPBO::write", "glUnmapBuffer()");
+    // Normal aglet usage (shader builds, render targets, filter passes, readback) polls no errors:
+    stats.setEnabled(true);
+    {
+        aglet::GLShader shader;
+        ASSERT_TRUE(shader.buildFromSrc(vshaderRgb2LuvSrc, fshaderRgb2LuvSrc));
 
-        glBindTexture(GL_TEXTURE_2D, texId);
-        Tools::checkGLErr("OPBO::write", "glBindTexture()");
+        image_rgba_t image = make_test_image(height, width);
+        GLTexture input(width, height, TEXTURE_FORMAT, image.data()->data());
+        aglet::GLFilterGraph graph(width, height);
+        graph.output(graph.pass(fshaderInvertSrc, { graph.input(input) }));
+        graph();
+        graph.read(image.data()->data());
 
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, TEXTURE_FORMAT, GL_UNSIGNED_BYTE, 0);
-        Tools::checkGLErr("OPBO::write", "glTexSubImage2D()");
+        fbo.bind();
+        texture.read(image.data()->data());
+        texture.read(image.data()->data(), 1, 1, width / 2, height / 2, width * 4);
+        fbo.unbind();
     }
+    stats.frame();
+    ASSERT_GT(stats.getFrame().calls[aglet::GLStats::kGetError].calls, 0);
+    ASSERT_EQ(stats.getFrame().warnings[aglet::GLStats::kWarnGetErrorLoop], 0);
+    ASSERT_EQ(stats.getFrame().warnings[aglet::GLStats::kWarnRedundantBind], 0);
+    check_gl_error();
 }
-
 #endif
 
-int gauze_main(int argc, char** argv)
+TEST(aglet, GLCapabilities)
 {
-    try
-    {
-        ::testing::InitGoogleTest(&argc, argv);
-        auto code = RUN_ALL_TESTS();
-        return code;
-    }
-    catch (std::exception& e)
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 48, glKind);
+    ASSERT_TRUE(gl);
+
+    // Queried once per context:
+    const auto& caps = gl->capabilities();
+    ASSERT_EQ(&caps, &gl->capabilities());
+    ASSERT_EQ(&caps, &aglet::GLCapabilities::current());
+
+#if defined(AGLET_EGL)
+    // ... and once per thread and native context without an aglet context (the
+    // native context of gl, made current on another thread):
+    const EGLDisplay display = eglGetCurrentDisplay();
+    const EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    const EGLContext native = eglGetCurrentContext();
+    ASSERT_TRUE(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
+    std::thread([&]() {
+        ASSERT_TRUE(eglMakeCurrent(display, surface, surface, native));
+        ASSERT_EQ(aglet::GLContext::current(), nullptr);
+        const aglet::GLCapabilities* first = &aglet::GLCapabilities::current();
+        ASSERT_NE(first, &caps);
+        ASSERT_EQ(first, &aglet::GLCapabilities::current());
+        for (int i = 0; i < aglet::GLCapabilities::kExtensionCount; i++)
+        {
+            ASSERT_EQ(first->has(aglet::GLCapabilities::Extension(i)), caps.has(aglet::GLCapabilities::Extension(i)));
+        }
+        ASSERT_EQ(glGetError(), GLenum(GL_NO_ERROR));
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }).join();
+    (*gl)();
+#endif
+
+    ASSERT_EQ(caps.isES(), (glKind != aglet::GLContext::kGL) && (glKind != aglet::GLContext::kGL43));
+    ASSERT_TRUE(caps.isVersion(2, 0));
+    ASSERT_FALSE(caps.isVersion(caps.getMajorVersion(), caps.getMinorVersion() + 1));
+    ASSERT_EQ(caps.getRenderer(), reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    ASSERT_FALSE(caps.getShadingLanguageVersion().empty());
+
+    // Bits agree with the names:
+    ASSERT_FALSE(caps.getExtensions().empty());
+    for (int i = 0; i < aglet::GLCapabilities::kExtensionCount; i++)
     {
-        std::cerr << "Exception: " << e.what() << std::endl;
+        const auto extension = aglet::GLCapabilities::Extension(i);
+        ASSERT_EQ(caps.has(extension), caps.has(aglet::GLCapabilities::getName(extension)));
     }
-    catch (...)
+    ASSERT_FALSE(caps.has("GL_not_an_extension"));
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    ASSERT_EQ(caps.getLimits().maxTextureSize, maxSize);
+    ASSERT_GT(caps.getLimits().maxCombinedTextureImageUnits, 0);
+    if (caps.isVersion(3, 0))
     {
-        std::cout << "Unknown exception" << std::endl;
+        ASSERT_GE(caps.getLimits().maxArrayTextureLayers, 256);
+        ASSERT_GE(caps.getLimits().maxSamples, 4);
     }
-    return 1; // return non-zero
-}
-
-#include <vector>
-#include <array>
-
-using rgba_t = std::array<std::uint8_t, 4>;
-using image_rgba_t = std::vector<rgba_t>;
-
-static image_rgba_t make_test_image(int rows, int cols)
-{
-    image_rgba_t image(rows * cols);
-    for (int y = 0; y < rows; y++)
+    if (caps.isES() ? caps.isVersion(3, 1) : caps.isVersion(4, 3))
     {
-        for (int x = 0; x < cols; x++)
-        {
-            std::uint8_t value = (y + 1) % 255;
-            image[y * cols + x] = { { value, value, value, 255 } };
-        }
+        ASSERT_GE(caps.getLimits().maxComputeWorkGroupInvocations, 128);
+        ASSERT_GE(caps.getLimits().maxComputeWorkGroupSize[2], 64);
     }
-    return image;
+    ASSERT_EQ(caps.hasFloatRenderTargets(), aglet::hasFloatRenderTargets());
+    check_gl_error();
 }
 
-TEST(aglet, glReadPixels)
+TEST(aglet, GLDispatch)
 {
-    const int width = 640;
-    const int height = 480;
-
-    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
-    check_gl_error();
-    (*gl)();
-    check_gl_error();
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 48, glKind);
     ASSERT_TRUE(gl);
 
-    glActiveTexture(GL_TEXTURE0);
-    check_gl_error();
-
-    (*gl)();
+    // Resolved once per context:
+    const auto& dispatch = gl->getDispatch();
+    ASSERT_EQ(&dispatch, &gl->getDispatch());
+    ASSERT_NE(gl->getProcAddress("glGetString"), nullptr);
 
-    image_rgba_t image0 = make_test_image(height, width);
-    image_rgba_t image1(image0.size());
+    const auto& caps = gl->capabilities();
+    if (!caps.isES() && caps.isVersion(3, 3))
+    {
+        ASSERT_TRUE(dispatch.hasTimerQuery());
+    }
 
-    GLFrameBufferObject fbo;
-    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
-    check_gl_error();
-    fbo.bind();
-    check_gl_error();
+    if (dispatch.hasTimerQuery())
+    {
+        GLuint queries[2] = { 0, 0 };
+        dispatch.genQueries(2, queries);
+        dispatch.queryCounter(queries[0], aglet::GLDispatch::kTimestamp);
+        glClear(GL_COLOR_BUFFER_BIT);
+        dispatch.queryCounter(queries[1], aglet::GLDispatch::kTimestamp);
+
+        std::uint64_t timestamps[2] = { 0, 0 };
+        dispatch.getQueryObjectui64v(queries[0], aglet::GLDispatch::kQueryResult, &timestamps[0]);
+        dispatch.getQueryObjectui64v(queries[1], aglet::GLDispatch::kQueryResult, &timestamps[1]);
+        dispatch.deleteQueries(2, queries);
+        ASSERT_GE(timestamps[1], timestamps[0]);
+    }
 
-    fbo.attach(texture);
+#if defined(AGLET_HAS_PBO)
+    if (dispatch.hasBufferStorage())
+    {
+        // Immutable, persistently mapped pack buffer:
+        const GLsizeiptr size = 64 * 48 * 4;
+        const GLbitfield flags = GL_MAP_READ_BIT | aglet::GLDispatch::kMapPersistent | aglet::GLDispatch::kMapCoherent;
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        dispatch.bufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+        void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+        ASSERT_NE(data, nullptr);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+    }
+#endif
     check_gl_error();
-    texture.read(image1.data()->data());
-
-    ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
 }
 
-#define AGLET_TO_STR_(x) #x
-#define AGLET_TO_STR(x) AGLET_TO_STR_(x)
-#define AGLET_LOGINF(class_tag, fmt, ...)
-#define AGLET_LOGERR(class_tag, fmt, ...)                                                                                   \
-    do                                                                                                                      \
-    {                                                                                                                       \
-        fprintf(stderr, "ogles_gpgpu::%s - %s:%d:%s(): " fmt "\n", class_tag, __FILE__, __LINE__, __func__, ##__VA_ARGS__); \
-    } while (0)
-
-// Real-world shader test from here:
-// https://github.com/hunter-packages/ogles_gpgpu/blob/hunter/ogles_gpgpu/common/proc/rgb2luv.cpp
-
-// clang-format off
-const char* vshaderRgb2LuvSrc = AGLET_TO_STR(
-  attribute vec4 aPos;
-  attribute vec2 aTexCoord;
-  varying vec2 vTexCoord;
-  void main() {
-    gl_Position = aPos;
-    vTexCoord = aTexCoord;
-  });
-
-const char* fshaderRgb2LuvSrc = 
+// Maximum of the 4 neighbors at a distance of 2 pixels (halo 2):
+const char* fshaderMaxSrc =
 #if defined(AGLET_OPENGLES)
 AGLET_TO_STR(precision highp float;)
 #endif
 AGLET_TO_STR(
   varying vec2 vTexCoord;
   uniform sampler2D uInputTex;
-
-  const mat3 RGBtoXYZ = mat3(0.430574, 0.341550, 0.178325, 0.222015, 0.706655, 0.071330, 0.020183, 0.129553, 0.93918);
-
-  const float y0 = 0.00885645167; // pow(6.0/29.0, 3.0)
-  const float a = 903.296296296;  // pow(29.0/3.0, 3.0);
-  const float un = 0.197833;
-  const float vn = 0.468331;
-  const float maxi = 0.0037037037;  // 1.0/270.0;
-  const float minu = -88.0 * maxi;
-  const float minv = -134.0 * maxi;
-  const vec3 k = vec3(1.0, 15.0, 3.0);
-  const vec3 RGBtoGray = vec3(0.2125, 0.7154, 0.0721);
-
+  uniform vec2 uTexelSize;
   void main()
   {
-      vec3 rgb = texture2D(uInputTex, vTexCoord).rgb;
-      vec3 xyz = (rgb * RGBtoXYZ);
-      float z = 1.0/(dot(xyz,k) + 1e-35);
-
-      vec3 luv;
-      float y = xyz.y;
-      float l = ((y > y0) ? ((116.0 * pow(y, 0.3333333333)) - 16.0) : (y*a)) * maxi;
-      luv.x = l;
-      luv.y = l * ((52.0 * xyz.x * z) - (13.0*un)) - minu;
-      luv.z = l * ((117.0 * xyz.y * z) - (13.0*vn)) - minv;
-
-      gl_FragColor = vec4(vec3(luv.xyz), dot(rgb, RGBtoGray));
+      vec4 a = texture2D(uInputTex, vTexCoord + vec2(-2.0, 0.0) * uTexelSize);
+      vec4 b = texture2D(uInputTex, vTexCoord + vec2(2.0, 0.0) * uTexelSize);
+      vec4 c = texture2D(uInputTex, vTexCoord + vec2(0.0, -2.0) * uTexelSize);
+      vec4 d = texture2D(uInputTex, vTexCoord + vec2(0.0, 2.0) * uTexelSize);
+      gl_FragColor = max(max(a, b), max(c, d));
   }
 );
-// clang-format on
-
-// Shader compiler inlined here for test purposes
-// Source:
-// https://github.com/hunter-packages/ogles_gpgpu/blob/hunter/ogles_gpgpu/common/gl/shader.cpp
-
-typedef enum
-{
-    ATTR,
-    UNIF
-} ShaderParamType;
 
-/** 
- * Shader helper class for creating and managing an OpenGL shader.
- */
-class Shader
+TEST(aglet, GLTiler)
 {
-public:
-    typedef std::pair<int, const char*> Attribute;
-    typedef std::vector<Attribute> Attributes;
-
-    /**
-     * Constructor.
-     */
-    Shader()
-    {
-        programId = 0;
-    }
+    const int width = 301;
+    const int height = 203;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 64, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+#if defined(AGLET_EGL)
+    ASSERT_EQ(gl->getGeometry().width, 64); // pbuffer size (clamped to the EGL limits)
+    ASSERT_EQ(gl->getGeometry().height, 64);
+#endif
 
-    /**
-     * Deconstructor.
-     */
-    ~Shader()
+    image_rgba_t image0(width * height), image1(image0.size()), image2(image0.size());
+    for (int y = 0; y < height; y++)
     {
-        if (programId > 0)
+        for (int x = 0; x < width; x++)
         {
-            AGLET_LOGINF("Shader", "deleting shader program");
-            glDeleteProgram(programId);
+            image0[y * width + x] = { { std::uint8_t((x * 7 + y) % 251), std::uint8_t((y * 5) % 251), std::uint8_t(x % 251), 255 } };
         }
     }
 
-    /**
-     * Build an OpenGL shader object from vertex and fragment shader source code
-     * <vshSrc> and <fshSrc>.
-     */
-    bool buildFromSrc(const char* vshSrc, const char* fshSrc, const std::vector<Attribute>& attributes = {})
-    {
-        programId = create(vshSrc, fshSrc, &vshId, &fshId, attributes);
-        return (programId > 0);
+    auto setTexelSize = [](int w, int h) {
+        return [w, h](aglet::GLShader& shader) {
+            glUniform2f(glGetUniformLocation(shader.getProgramId(), "uTexelSize"), 1.f / float(w), 1.f / float(h));
+        };
+    };
+
+    { // Reference: the whole image in one pass
+        GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+        texture.setFilter(GL_NEAREST);
+        aglet::GLFilterGraph graph(width, height);
+        graph.output(graph.pass(fshaderMaxSrc, { graph.input(texture) }, setTexelSize(width, height)));
+        graph();
+        graph.read(image1.data()->data());
+        check_gl_error();
     }
 
-    /**
-     * Use the shader program.
-     */
-    void use()
-    {
-        glUseProgram(programId);
-    }
+    // Tiles of 64 x 64 pixels with a halo of 2 (60 x 60 output pixels), 3 in flight:
+    aglet::GLTiler tiler(64, 2, 3);
+    ASSERT_EQ(tiler.getStep(), 60);
+    ASSERT_EQ(tiler.getTileCount(width, height), 6 * 4);
 
-    /**
-     * Get a shader parameter position for a parameter of type <type> and with
-     * <name>.
-     */
-    GLint getParam(ShaderParamType type, const char* name) const
-    {
+    glBindTexture(GL_TEXTURE_2D, tiler.getTexture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-        // get position according to type and name
-        GLint id = (type == ATTR) ? glGetAttribLocation(programId, name) : glGetUniformLocation(programId, name);
+    aglet::GLFilterGraph graph(tiler.getTileSize(), tiler.getTileSize());
+    graph.output(graph.pass(fshaderMaxSrc, { graph.input(tiler.getTexture()) }, setTexelSize(tiler.getTileSize(), tiler.getTileSize())));
 
-        if (id < 0)
-        {
-            AGLET_LOGERR("Shader", "could not get parameter id for param %s", name);
-        }
+    std::size_t tiles = 0;
+    tiler([&](GLuint) { tiles++; return graph(); }, image0.data()->data(), width, height, 0, image2.data()->data());
+    check_gl_error();
 
-        return id;
-    }
+    ASSERT_EQ(tiles, tiler.getTileCount(width, height));
+    ASSERT_TRUE(std::equal(image1.begin(), image1.end(), image2.begin()));
+}
+
+TEST(aglet, GLMemory)
+{
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 64, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    /**
-     * Get a shader parameter position for a parameter of type <type> and with
-     * <name>.
-     */
-    GLuint getProgramId()
+    auto& memory = gl->getMemory();
+    const std::size_t start = memory.getBytes();
+    const std::size_t count = memory.getCount(aglet::GLMemory::kTexture);
+
+    {
+        GLTexture texture(64, 32);
+        aglet::GLBuffer buffer(GL_ARRAY_BUFFER, 1000, GL_STATIC_DRAW);
+        ASSERT_EQ(memory.getBytes(), start + 64 * 32 * 4 + 1000);
+        ASSERT_EQ(memory.getCount(aglet::GLMemory::kTexture), count + 1);
+        ASSERT_GE(aglet::GLMemory::getGlobalBytes(), memory.getBytes());
+    }
+    ASSERT_EQ(memory.getBytes(), start);
+    ASSERT_GE(memory.getPeak(), start + 64 * 32 * 4 + 1000);
+
+    // Budget: a new texture evicts the cached one
+    std::unique_ptr<GLTexture> cache(new GLTexture(64, 64));
+    std::size_t requested = 0;
+    const int id = memory.addEvictor([&](std::size_t bytes) {
+        requested = bytes;
+        cache.reset();
+    });
+    memory.setBudget(memory.getBytes() + 1024);
     {
-        return programId;
+        GLTexture texture(64, 64);
+        ASSERT_FALSE(cache);
+        ASSERT_EQ(requested, 64 * 64 * 4 - 1024);
+        ASSERT_LE(memory.getBytes(), memory.getBudget());
+        ASSERT_EQ(memory.getOverBudgetCount(), 0);
     }
+    memory.removeEvictor(id);
+    memory.setBudget(0);
+    check_gl_error();
 
-private:
-    /**
-     * Create a shader program from sources <vshSrc> and <fshSrc>. Save shader ids in
-     * <vshId> and <fshId>.
-     */
-    GLuint create(const char* vshSrc, const char* fshSrc, GLuint* vshId, GLuint* fshId, const Attributes& attributes = {})
+    // An evictor removing itself does not skip the next one, a throwing one does not stop eviction
     {
-        *vshId = compile(GL_VERTEX_SHADER, vshSrc);
-        *fshId = compile(GL_FRAGMENT_SHADER, fshSrc);
+        int once = -1, calls = 0;
+        once = memory.addEvictor([&](std::size_t) { memory.removeEvictor(once); });
+        const int next = memory.addEvictor([&](std::size_t) { calls++; });
+        memory.evict(1);
+        ASSERT_EQ(calls, 1);
+        memory.removeEvictor(next);
+
+        const int thrower = memory.addEvictor([](std::size_t) { throw std::runtime_error("evictor"); });
+        ASSERT_THROW(memory.evict(1), std::runtime_error);
+        memory.removeEvictor(thrower);
+        const int counter = memory.addEvictor([&](std::size_t) { calls++; });
+        memory.evict(1);
+        ASSERT_EQ(calls, 2);
+        memory.removeEvictor(counter);
+    }
 
-        // create shader program
-        GLuint programId = glCreateProgram();
+#if defined(AGLET_HAS_PBO)
+    // The caches of the context are evicted before the evictors of the application
+    {
+        GLTexture texture(64, 64);
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        std::vector<GLubyte> pixels(64 * 64 * 4);
+        aglet::readPixels(aglet::GLContext::kTransferPBO, 0, 0, 64, 64, pixels.data());
+        fbo.unbind();
+    }
+    ASSERT_TRUE(gl->m_packBuffer);
+    bool evicted = false;
+    const int last = memory.addEvictor([&](std::size_t) { evicted = true; });
+    memory.setBudget(memory.getBytes());
+    {
+        GLTexture texture(32, 32); // smaller than the pack buffer
+        ASSERT_FALSE(gl->m_packBuffer);
+        ASSERT_FALSE(evicted);
+    }
+    memory.removeEvictor(last);
+    memory.setBudget(0);
+    check_gl_error();
+#endif
 
-        if (programId == 0)
-        {
-            AGLET_LOGERR("Shader", "could not create shader program");
-            return 0;
-        }
+    // Driver queries are only valid with GL_NVX_gpu_memory_info or GL_ATI_meminfo:
+    const auto& caps = gl->capabilities();
+    const auto driver = aglet::GLMemory::queryDriver(caps);
+    if (!caps.has(aglet::GLCapabilities::kNVX_gpu_memory_info) && !caps.has(aglet::GLCapabilities::kATI_meminfo))
+    {
+        ASSERT_FALSE(driver.valid);
+    }
+    check_gl_error();
+}
 
-        glAttachShader(programId, *vshId); // add the vertex shader to program
-        glAttachShader(programId, *fshId); // add the fragment shader to program
+TEST(aglet, GLDeletionQueue)
+{
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 64, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-        // Bind attribute locations
-        // this needs to be done prior to linking
-        for (int i = 0; i < attributes.size(); i++)
-        {
-            glBindAttribLocation(programId, attributes[i].first, attributes[i].second);
-        }
+    auto& queue = gl->getDeletionQueue();
+    auto& memory = gl->getMemory();
+    const std::size_t start = memory.getBytes();
+    const std::size_t deleted = queue.getDeletedCount();
 
-        glLinkProgram(programId); // link both shaders to a full program
+    std::unique_ptr<GLTexture> texture(new GLTexture(64, 64));
+    std::unique_ptr<aglet::GLBuffer> buffer(new aglet::GLBuffer(GL_ARRAY_BUFFER, 1000, GL_STATIC_DRAW));
+    const GLuint name = *texture;
 
-        // check link status
-        GLint linkStatus;
-        glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
-        if (linkStatus != GL_TRUE)
-        {
-            AGLET_LOGERR("Shader", "could not link shader program. error log:");
-            GLchar infoLogBuf[1024];
-            GLsizei infoLogLen;
-            glGetProgramInfoLog(programId, 1024, &infoLogLen, infoLogBuf);
-            std::cerr << infoLogBuf << std::endl
-                      << std::endl;
+    // Release on a thread without a current context: the names are queued
+    std::thread([&]() {
+        texture.reset();
+        buffer.reset();
+    }).join();
 
-            glDeleteProgram(programId);
+    ASSERT_FALSE(queue.isEmpty());
+    ASSERT_EQ(memory.getBytes(), start + 64 * 64 * 4 + 1000); // still held
+    ASSERT_TRUE(glIsTexture(name));
 
-            return 0;
-        }
+    // ... and deleted by the owner on the next make current
+    (*gl)();
+    ASSERT_TRUE(queue.isEmpty());
+    ASSERT_EQ(queue.getDeletedCount(), deleted + 2);
+    ASSERT_EQ(memory.getBytes(), start);
+    ASSERT_FALSE(glIsTexture(name));
+    check_gl_error();
 
-        return programId;
+    // The render loop leaves the names queued while another context is current
+    texture.reset(new GLTexture(64, 64));
+    std::thread([&]() { texture.reset(); }).join();
+    {
+        auto other = aglet::GLContext::create(aglet::GLContext::kAuto, {}, 64, 64, glKind);
+        ASSERT_TRUE(other);
+        (*other)();
+        aglet::GLContext::RenderDelegate frame = []() { return false; };
+        (*gl)(frame);
+        ASSERT_FALSE(queue.isEmpty());
+        (*gl)();
+        ASSERT_TRUE(queue.isEmpty());
     }
 
-    /**
-     * Compile a shader of type <type> and source <src> and return its id.
-     */
-    static GLuint compile(GLenum type, const char* src);
-
-    GLuint programId; // full shader program id
-    GLuint vshId;     // vertex shader id
-    GLuint fshId;     // fragment shader id
-};
+    // A context released on another thread is no longer current on this one
+    std::thread([&]() { gl.reset(); }).join();
+    ASSERT_EQ(aglet::GLContext::current(), nullptr);
+}
 
-GLuint Shader::compile(GLenum type, const char* src)
+TEST(aglet, GLNamePool)
 {
+    const int width = 64;
+    const int height = 32;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
 
-    // create a shader
-    GLuint shId = glCreateShader(type);
-    if (shId == 0)
-    {
-        AGLET_LOGERR("Shader", "could not create shader");
-        return 0;
+    auto& pool = gl->getNamePool();
+
+    { // Names are generated in batches
+        const auto calls = pool.getGenerateCount(aglet::GLNamePool::kFramebuffer);
+        std::vector<std::unique_ptr<aglet::GLFrameBufferObject>> fbos;
+        for (int i = 0; i < 100; i++)
+        {
+            fbos.emplace_back(new aglet::GLFrameBufferObject);
+        }
+        ASSERT_LE(pool.getGenerateCount(aglet::GLNamePool::kFramebuffer) - calls, 4);
     }
-    // set shader source
-    glShaderSource(shId, 1, (const GLchar**)&src, NULL);
-    // compile the shader
-    glCompileShader(shId);
-    // check compile status
-    GLint compileStatus;
-    glGetShaderiv(shId, GL_COMPILE_STATUS, &compileStatus);
-    if (compileStatus != GL_TRUE)
+
+    if (!gl->getDispatch().hasTextureStorage())
     {
-        AGLET_LOGERR("Shader", "could not compile shader program. error log:");
-        GLchar infoLogBuf[1024];
-        GLsizei infoLogLen;
-        glGetShaderInfoLog(shId, 1024, &infoLogLen, infoLogBuf);
-        std::cerr << infoLogBuf << std::endl
-                  << std::endl;
-        AGLET_LOGERR("Shader", "could not compile shader program. shader source:");
-        std::cerr << src << std::endl
-                  << std::endl;
+        return;
+    }
 
-        glDeleteShader(shId);
-        return 0;
+    // Unsized formats are not given to glTexStorage2D
+    const GLenum bgra = 0x80E1; // GL_BGRA, GL_BGRA_EXT
+    ASSERT_EQ(aglet::GLNamePool::getSizedFormat(bgra, GL_UNSIGNED_BYTE), 0);
+    ASSERT_EQ(aglet::GLNamePool::getSizedFormat(GL_RGBA, GL_FLOAT), 0);
+    if (gl->capabilities().has("GL_EXT_texture_format_BGRA8888"))
+    {
+        GLTexture texture(width, height, bgra, bgra, GL_UNSIGNED_BYTE, nullptr, GLTexture::kImmutable);
+        ASSERT_FALSE(texture.isImmutable());
+        check_gl_error();
     }
-    return shId;
-}
 
-TEST(aglet, glShader)
-{
-    const int width = 640;
-    const int height = 480;
-    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glKind);
+    // Nothing is kept unless asked for
+    ASSERT_EQ(pool.getCapacity(), 0);
+    pool.setCapacity(64 << 20);
+
+    // Immutable textures of the same size and format recycle name and storage
+    image_rgba_t image0 = make_test_image(height, width);
+    image_rgba_t image1(image0.size());
+    const auto hits = pool.getRecycleHits();
+    GLuint name = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        GLTexture texture(width, height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, image0.data()->data(), GLTexture::kImmutable);
+        ASSERT_TRUE(texture.isImmutable());
+        ASSERT_EQ(texture.getInternalFormat(), GLenum(GL_RGBA));
+        ASSERT_EQ(texture.getSizedFormat(), GLenum(0x8058)); // GL_RGBA8
+        ASSERT_TRUE((i == 0) || (GLuint(texture) == name));
+        name = texture;
+
+        aglet::GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(texture);
+        texture.read(image1.data()->data());
+        fbo.unbind();
+        ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
+    }
+    ASSERT_EQ(pool.getRecycleHits() - hits, 9);
+    ASSERT_EQ(pool.getRecycledCount(), 1);
     check_gl_error();
-    (*gl)();
+
+    // Recycled textures stay charged and are evicted first
+    auto& memory = gl->getMemory();
+    const std::size_t bytes = memory.getBytes();
+    ASSERT_GE(bytes, pool.getRecycledBytes());
+    bool evicted = false;
+    const int id = memory.addEvictor([&](std::size_t) { evicted = true; });
+    memory.evict(pool.getRecycledBytes());
+    memory.removeEvictor(id);
+    ASSERT_FALSE(evicted); // the recycle bin was enough
+    ASSERT_EQ(pool.getRecycledCount(), 0);
+    ASSERT_EQ(memory.getBytes(), bytes - width * height * 4);
+    ASSERT_FALSE(glIsTexture(name));
     check_gl_error();
-    ASSERT_TRUE(gl);
-    Shader shader;
-    auto value = shader.buildFromSrc(vshaderRgb2LuvSrc, fshaderRgb2LuvSrc);
-    ASSERT_TRUE(value);
 }
 
 #if defined(AGLET_OPENGL_ES3)
@@ -757,7 +1926,7 @@ TEST(aglet, pbo)
     GLTexture texture(width, height, TEXTURE_FORMAT, 0);
 
     { // Write pixels:
-        OPBO pbo(width, height);
+        aglet::OPBO pbo(width, height, TEXTURE_FORMAT);
         pbo.bind();
         pbo.write(image0.data()->data(), texture);
         pbo.unbind();
@@ -768,7 +1937,7 @@ TEST(aglet, pbo)
         fbo.bind();
         fbo.attach(texture);
 
-        IPBO pbo(width, height);
+        aglet::IPBO pbo(width, height, TEXTURE_FORMAT);
         pbo.bind();
         pbo.read(image1.data()->data());
         pbo.unbind();
@@ -779,3 +1948,127 @@ TEST(aglet, pbo)
     ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
 }
 #endif
+
+#if defined(AGLET_HAS_COMPUTE)
+TEST(aglet, GLComputeProgram)
+{
+    const int width = 640;
+    const int height = 480;
+    auto gl = aglet::GLContext::create(aglet::GLContext::kAuto, {}, width, height, glComputeKind);
+    ASSERT_TRUE(gl);
+    (*gl)();
+
+    using aglet::GLComputeProgram;
+    const auto& limits = gl->capabilities().getLimits();
+    for (int dimensions = 1; dimensions <= 3; dimensions++)
+    {
+        const auto size = GLComputeProgram::getDefaultLocalSize(dimensions);
+        ASSERT_LE(GLint(size[0] * size[1] * size[2]), limits.maxComputeWorkGroupInvocations);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_LE(GLint(size[i]), limits.maxComputeWorkGroupSize[i]);
+        }
+        if ((dimensions == 3) && (limits.maxComputeWorkGroupInvocations >= 256))
+        {
+            ASSERT_EQ(size[0] * size[1] * size[2], 256);
+        }
+    }
+    const auto localSize = GLComputeProgram::getDefaultLocalSize(2);
+    const std::string header = std::string(GLComputeProgram::getVersionDeclaration()) + GLComputeProgram::getLocalSizeDeclaration(localSize);
+    aglet::GLMemoryBarrier barrier;
+
+    image_rgba_t image0 = make_test_image(height, width);
+    image_rgba_t image1(image0.size());
+    GLTexture texture(width, height, TEXTURE_FORMAT, image0.data()->data());
+
+    { // Histogram: texture -> SSBO (atomics)
+        // clang-format off
+        const std::string src = header + AGLET_TO_STR(
+          uniform highp sampler2D uInput;
+          layout(std430, binding = 0) buffer Histogram { uint bins[256]; };
+          void main() {
+              ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+              ivec2 size = textureSize(uInput, 0);
+              if (p.x < size.x && p.y < size.y) {
+                  uint value = uint(texelFetch(uInput, p, 0).r * 255.0 + 0.5);
+                  atomicAdd(bins[value], 1u);
+              }
+          });
+        // clang-format on
+
+        GLComputeProgram program(src);
+        ASSERT_EQ(program.getLocalSize(), localSize);
+        ASSERT_EQ(program.getGroupCount(width, height)[0], (width + localSize[0] - 1) / localSize[0]);
+
+        std::vector<GLuint> bins(256, 0);
+        aglet::GLBuffer ssbo(GL_SHADER_STORAGE_BUFFER, bins.size() * sizeof(GLuint), GL_DYNAMIC_READ, bins.data());
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        GLComputeProgram::bindStorageBuffer(0, ssbo);
+        program.run(width, height, 1, &barrier);
+        ASSERT_EQ(barrier.getPending(), GLbitfield(GL_ALL_BARRIER_BITS));
+
+        barrier.read(GL_BUFFER_UPDATE_BARRIER_BIT);
+        ASSERT_EQ(barrier.getPending() & GL_BUFFER_UPDATE_BARRIER_BIT, GLbitfield(0));
+        ssbo.read(bins.data(), bins.size() * sizeof(GLuint));
+        check_gl_error();
+
+        std::vector<GLuint> expected(256, 0);
+        for (const auto& pixel : image0)
+        {
+            expected[pixel[0]]++;
+        }
+        ASSERT_EQ(bins, expected);
+    }
+
+    { // GLHistogram: only the bins are read back
+        aglet::GLHistogram histogram(256);
+        std::vector<GLuint> expected(256, 0);
+        for (const auto& pixel : image0)
+        {
+            expected[pixel[0]]++;
+        }
+        ASSERT_EQ(histogram(texture, width, height), expected);
+        check_gl_error();
+    }
+
+    { // Image store: compute -> immutable texture -> glReadPixels
+        // clang-format off
+        const std::string src = header + AGLET_TO_STR(
+          layout(rgba8, binding = 0) writeonly uniform highp image2D uOutput;
+          uniform highp sampler2D uInput;
+          void main() {
+              ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+              ivec2 size = imageSize(uOutput);
+              if (p.x < size.x && p.y < size.y) {
+                  imageStore(uOutput, p, texelFetch(uInput, p, 0));
+              }
+          });
+        // clang-format on
+
+        GLuint output = 0;
+        glGenTextures(1, &output);
+        glBindTexture(GL_TEXTURE_2D, output);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        check_gl_error();
+
+        GLComputeProgram program(src);
+        GLComputeProgram::bindImage(0, output, GL_WRITE_ONLY, GL_RGBA8);
+        program.run(width, height, 1, &barrier);
+        barrier.read(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+        GLFrameBufferObject fbo;
+        fbo.bind();
+        fbo.attach(output);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image1.data()->data());
+        fbo.unbind();
+        glDeleteTextures(1, &output);
+        check_gl_error();
+
+        ASSERT_TRUE(std::equal(image0.begin(), image0.end(), image1.begin()));
+    }
+}
+#endif